@@ -68,6 +68,8 @@
 #define   QD_DIRECTION_DECREMENT        -1
 #define   QD_DIRECTION_INCREMENT_FAST    4
 #define   QD_DIRECTION_DECREMENT_FAST   -4
+#define   QD_DIRECTION_INCREMENT_ULTRA   8
+#define   QD_DIRECTION_DECREMENT_ULTRA  -8
 #define   QD_DIRECTION_BIT7              0x80
 
 /* QD mode_current parameter bits */
@@ -76,11 +78,30 @@
 #define   QD_MODE_FAST                   0x04
 #define   QD_LEADING_EDGE_INDICATION     0x08
 #define   QD_FAST_TO_NORMAL_SWITCH       0x10
+#define   QD_MODE_ULTRA_FAST             0x20
+#define   QD_MODE_TCR2                   0x40
 
 /* QD options parameter bits */
 #define   QD_PC_MAX_ENABLED              0x01
 #define   QD_PC_INTERRUPT_ENABLED        0x02
 #define   QD_WINDOWING_DISABLED          0x04
+#define   QD_EDGE_RING_ENABLED           0x08
+#define   QD_EDGE_HISTORY_ENABLED        0x10
+#define   QD_PERIOD_AVG_ENABLED          0x20
+#define   QD_TRIGGER_TABLE_ENABLED       0x40
+
+/* QD trigger table entry actions */
+#define   QD_TRIGGER_INTERRUPT           0x01
+#define   QD_TRIGGER_DMA                 0x02
+#define   QD_TRIGGER_LINK                0x04
+
+/* period reported after standstill (saturated, not measured) */
+#define   QD_PERIOD_STANDSTILL           0xFF000000
+
+/* QD irq_state parameter bits */
+#define   QD_IRQ_ARMED1                  0x01
+#define   QD_IRQ_ARMED2                  0x02
+#define   QD_IRQ_HOLD                    0x04
 
 /* QD pins parameter bits */
 #define   QD_PIN_A                       0x01
@@ -89,6 +110,38 @@
 
 /* QD error buts */
 #define   QD_ERROR_WINDOWING             0x01
+#define   QD_ERROR_REVERSAL              0x02
+#define   QD_ERROR_ILLEGAL               0x04
+#define   QD_ERROR_SPURIOUS              0x08
+
+/* error counters saturate at 16 bits */
+#define   QD_ERROR_COUNT_MAX             0xFFFF
+
+/* Build options - each one adds its parameters to the channel frame and
+   its code to the threads. The host driver API of an option is compiled
+   only when its parameters are exported to etpu_eqd_auto.h.
+   Without options the frame is 124 bytes; the 8-bit parameters of the
+   options fit into free bytes of it, the others add (bytes):
+     QD_EDGE_RING          - leading edge record ring (options bit3)   20
+     QD_EDGE_HISTORY       - edge time history (options bit4)          12
+     QD_PERIOD_AVG         - moving average period (options bit5)      20
+     QD_TRIGGER_TABLE      - position trigger table (options bit6)     24
+     QD_PC_IRQ_COALESCING  - pc_interrupt coalescing; without it each  12
+                             hit of a pc_interrupt value interrupts
+     QD_STANDSTILL         - standstill detection                       4
+     QD_FAST_REVERSAL      - direction reversal detection in FAST mode  0
+     QD_ERROR_COUNTERS     - illegal, window and spurious error        12
+                             counters
+     QD_PROFILING          - per-thread hit counters                   24
+   12 axes without options take half of the 3 KB DATA RAM of the MPC5554,
+   with all options nearly all of it. */
+
+/* QD_PROFILING - per-thread hit counters in the channel frame */
+#ifdef QD_PROFILING
+#define   QD_PROF_HIT(counter)           counter += 1
+#else
+#define   QD_PROF_HIT(counter)
+#endif
 
 /* QD Function Modes */
 #define   QD_CHANNEL_PRIMARY            (fm0==0)
@@ -130,11 +183,56 @@
 *                          mode.
 *  fast_normal_threshold - Threshold for switching from fast mode to normal
 *                          mode.
+*  fast_ultra_threshold  - Threshold for switching from fast mode to ultra
+*                          fast mode, 0 = ultra fast mode not used.
+*  ultra_fast_threshold  - Threshold for switching from ultra fast mode to
+*                          fast mode. The ultra fast mode is left for slow
+*                          mode when two leading edges do not come within
+*                          4 * ultra_fast_threshold.
+*  fast_tcr2_threshold   - Threshold for switching from fast or ultra fast
+*                          mode to TCR2 mode, 0 = TCR2 mode not used.
+*  tcr2_fast_threshold   - Threshold for leaving TCR2 mode (for slow mode).
+*  tcr2_interval         - TCR2 mode, the period of the match which reconciles
+*                          pc, period and the edge time with TCR2.
+*  tcr2_base             - TCR2 mode, the TCR2 value at the last reconcile.
+*  tcr2_state            - TCR2 mode, the pin state (position modulo 4) at
+*                          the last reconcile.
 *  last_leading_edge     - The last leading edge time.
 *  last_edge             - The last edge time.
+*  last_leading_edge_ext - Wrap extension of last_leading_edge (bits 24-31).
+*  last_edge_ext         - Wrap extension of last_edge (bits 24-31).
+*  illegal_count         - QD_ERROR_COUNTERS only (the *_count parameters) -
+*                          Number of illegal transitions - in Slow mode both
+*                          pins changed between two edge services. The edge
+*                          is counted, QD_ERROR_ILLEGAL is set.
+*  window_count          - Number of detection window ends without an edge
+*                          (QD_ERROR_WINDOWING set).
+*  spurious_count        - Number of spurious edges - in Slow mode the pin is
+*                          back on its level before the edge when the edge is
+*                          serviced (a glitch, or the same edge twice). The
+*                          edge is not counted, QD_ERROR_SPURIOUS is set.
+*                          The counters saturate at 0xFFFF and are cleared
+*                          only by the initialization.
+*  prof_init             - QD_PROFILING only - thread hit counters (24-bit,
+*  prof_slow_normal        wrapping): Init threads and host service requests,
+*  prof_fast               Slow/Normal mode edges, Fast/Ultra Fast/TCR2 mode
+*  prof_overflow           edges and matches, period overflow, Index and
+*  prof_index_home         Home transitions and overflows. prof_mode_switch
+*  prof_mode_switch        counts the mode switch paths, which run within
+*                          the edge threads.
+*  tcr_ext               - TCR wrap extension: lsb - the latest TCR time
+*                          seen on an edge or a match, msb - the number of
+*                          TCR wraps up to it since the initialization. The
+*                          period overflow match keeps it running at
+*                          standstill.
 *  pc_sc                 - Special position counter used by Speed Controller
+*  position_lo           - Absolute position, bits 0-23. position_lo and
+*  position_hi             position_hi form a 48-bit position counted like
+*                          pc_sc, but never reset (pc_max, index, set_pc).
+*  position_hi           - Absolute position, bits 24-47 (signed).
 *  direction             - Direction. 
-*                          1 or 4 for incremental, -1 or -4 for decremental.
+*                          1, 4 or 8 for incremental, -1, -4 or -8 for
+*                          decremental.
 *  last_direction        - Last direction value on first INDEX transition.
 *  pins                  - Actual QD pin states and configuration
 *                          - bit0=0 ? primary QD channel pin state is low
@@ -149,11 +247,23 @@
 *                          - bit2=1 ? FAST mode
 *                          - bit3=0 ? the last edge is not a leading edge
 *                          - bit3=1 ? the last edge is a leading edge
+*                          - bit4=1 ? fast to normal mode switch on this edge
+*                          - bit5=1 ? ULTRA FAST mode - the leading edges are
+*                            detected in pairs (double transition mode), one
+*                            thread and +/-8 counts per pair
+*                          - bit6=1 ? TCR2 mode - TCR2 counts the edges of
+*                            the phase wired to TCRCLK, no transition is
+*                            detected, a periodic match reconciles pc
 *  options               - QD options
 *                          - bit0=0 ? reset of pc when pc=pc_max disabled      
 *                            bit0=1 ? reset of pc when pc=pc_max enabled
 *                          - bit1=0 ? generation of interrupt when pc=pc_interrupt disabled   
 *                            bit1=1 ? generation of interrupt when pc=pc_interrupt enabled
+*                          - bit2=1 ? windowing disabled
+*                          - bit3=1 ? leading edge records written to the edge ring
+*                          - bit4=1 ? edge times written to the edge history
+*                          - bit5=1 ? moving average period_avg maintained
+*                          - bit6=1 ? position trigger table enabled
 *  
 *  ratio1                - This parameter applies in the window mode for setting
 *                          of the window beginning.
@@ -163,15 +273,118 @@
 *  phase_A_chan          - The phase A input channel number.
 *  phase_B_chan          - The phase B input channel number.
 *  error_flags(_latched) - The current state of error flags (working copy and latched).
+*  seq                   - Publication sequence counter. Incremented before
+*                          and after the QD outputs (pc, pc_sc, rc, period,
+*                          last_edge, direction, pins, mode_current,
+*                          error_flags) are updated, so it is odd while an
+*                          update is in progress. The host re-reads when it
+*                          changes. Volatile, so that the compiler emits
+*                          both stores of a thread and does not merge them
+*                          into one increment by 2.
+*  ring_start            - QD_EDGE_RING only (the ring_* parameters) - edge
+*                          ring - first record. Each record is two words:
+*                          {direction, last_edge} and {ring_seq, pc}.
+*  ring_end              - Edge ring - end (one past the last record).
+*  ring_wr               - Edge ring - next record to be written by eTPU.
+*  ring_rd               - Edge ring - next record to be read by host. When
+*                          the record after ring_wr is ring_rd the ring is full
+*                          and the record is dropped. Set to 0 (no flow
+*                          control) when a DMA channel drains the ring.
+*  ring_overflow         - Edge ring - number of dropped records.
+*  ring_seq              - Edge ring - sequence number of the next record,
+*                          counting the dropped ones, so that the reader of
+*                          a DMA drained ring sees a gap for a lost record.
+*  window_begin          - Detection window beginning and end, relative to
+*  window_end              last_edge. Computed from period, ratio1 and ratio2
+*                          on each leading edge in Normal and Fast mode.
+*  hist_start            - QD_EDGE_HISTORY only (the hist_* parameters) -
+*                          edge history - first entry. Each entry is one
+*                          word: {direction, last_edge}.
+*  hist_end              - Edge history - end (one past the last entry).
+*  hist_wr               - Edge history - next entry to be written by eTPU.
+*                          The history is overwritten circularly, on every
+*                          counted edge; the host reads it between two reads
+*                          of seq.
+*  period_avg            - QD_PERIOD_AVG only (period_avg, period_sum and
+*                          the avg_* parameters) - average of the last
+*                          2^avg_shift periods, 32-bit.
+*                          Valid while the periods are below 2^(32-avg_shift)
+*                          TCR ticks.
+*  period_sum            - Sum of the periods in the average buffer.
+*  avg_start             - Average buffer - first period. Each entry is one
+*                          32-bit period.
+*  avg_end               - Average buffer - end (one past the last period).
+*  avg_wr                - Average buffer - oldest period, replaced by the
+*                          next one.
+*  avg_shift             - log2 of the number of averaged periods.
+*  last_index            - Revolution period reference - TCR1 time of the
+*                          last index pulse, advanced by each overflow match.
+*  rev_accum(_ext)       - Revolution period accumulator (40-bit).
+*  rev_period            - Time between the last two index pulses, 32-bit.
+*                          0 until two pulses have been seen.
+*  rev_period_ext        - Revolution period overflow extension - bits 32-39
+*                          of the time between the last two index pulses.
+*  index_seen            - An index pulse has been captured since init.
+*  trig_start            - QD_TRIGGER_TABLE only (the trig_* parameters) -
+*                          trigger table - first entry. Each entry is one
+*                          word: {actions, position}, sorted by ascending
+*                          position (signed, no duplicates).
+*  trig_end              - Trigger table - end (one past the last entry).
+*  trig_next             - Trigger table - next target above pc (the first
+*                          entry with position > pc); the next target
+*                          below is the entry before it.
+*  trig_new_start        - Trigger table posted by the host, 0 = none. It
+*  trig_new_end            replaces the active table on the next edge, and
+*                          trig_new_start is cleared.
+*  trig_last             - The last entry that triggered.
+*  trig_link_chan        - Channel linked by entries with QD_TRIGGER_LINK.
+*  irq_min_interval      - QD_PC_IRQ_COALESCING only (the irq_* parameters)
+*                          - pc_interrupt coalescing - minimum TCR time
+*                          between two interrupts, 0 = no limit. At most
+*                          0x7FFFFF.
+*  irq_last_time         - TCR time of the last pc_interrupt.
+*  irq_hysteresis        - pc_interrupt coalescing - a pc_interrupt value is
+*                          re-armed when pc gets more than irq_hysteresis
+*                          counts away from it.
+*  irq_rev_div           - pc_interrupt coalescing - interrupt only when rc
+*                          is a multiple of irq_rev_div (every Nth
+*                          revolution), 0 or 1 = every revolution.
+*  irq_state             - Armed pc_interrupt values and minimum interval
+*                          hold.
+*  irq_suppressed        - Number of pc_interrupts suppressed by coalescing.
+*  standstill_timeout    - QD_STANDSTILL only (the standstill* parameters)
+*                          - standstill detection - TCR time without an
+*                          edge after which the shaft is at standstill, 0 =
+*                          detection disabled, max 0x7FFFFF. Detected in
+*                          slow mode.
+*  standstill            - The shaft is at standstill. Set by the period
+*                          overflow match, cleared by the next edge. At
+*                          standstill one channel keeps an equal only match,
+*                          once per TCR wrap, to extend tcr_ext; the first
+*                          period after it is QD_PERIOD_STANDSTILL plus the
+*                          time from the first edge to the leading edge.
+*  standstill_irq        - Generate an interrupt when standstill is detected.
+*  fast_reversal         - QD_FAST_REVERSAL only - direction reversal
+*                          detection in FAST mode. On each leading edge the
+*                          pin of the other channel, which does not detect
+*                          transitions in FAST mode, is sampled. When it is not on its leading edge level
+*                          the shaft has reversed - the edge is counted, the
+*                          direction is flipped, QD_ERROR_REVERSAL is set and
+*                          the QD continues in SLOW mode. The sample is used
+*                          only when the thread starts within a quarter of
+*                          the QD period after the edge.
 *                          
 * CHANNEL FLAG USAGE: 
 *
-*   Flag0 is used to select the mode.
-*     0 = slow or normal mode
-*     1 = fast mode
-*   Flag1 is used to select the expected edge.
-*     0 = the next edge must be rising edge
-*     1 = the next edge must be falling edge
+*   Flag0 and Flag1 select the thread which services the next edge.
+*     F0=0 F1=0 = slow or normal mode, the next edge is not a leading edge
+*     F0=0 F1=1 = slow mode, the next edge is a leading edge
+*     F0=1 F1=0 = normal mode, the next edge is a leading edge
+*     F0=1 F1=1 = fast mode (only leading edges are detected)
+*   The next edge is a leading edge on the channel whose pin is not on its
+*   leading edge level while the other pin is. Each edge thread updates the
+*   flags of both channels accordingly. The expected edge (rising or
+*   falling) follows from the pin state in pins.
 *
 * NOTES: !!!!! Phase A and B channels must have the same base address (and home/index!). !!!!!!
 *************************************************************************/
@@ -188,7 +401,8 @@ union Data_32_or_8_24
 
 _eTPU_class QD
 {
-   /* channel frame data */
+   /* channel frame data - the core parameters, then the parameters of
+      the build options */
    int24_t        pc;
    int24_t        rc;
    union Data_32_or_8_24 period; 
@@ -215,20 +429,139 @@ _eTPU_class QD
    uint8_t        error_flags_latched;
    union Data_32_or_8_24 period_accum; 
    _Bool          found_leading_edge;
+   volatile uint24_t seq;
+   uint24_t       window_begin;
+   uint24_t       window_end;
+   int24_t        last_index;
+   union Data_32_or_8_24 rev_accum;
+   uint8_t        rev_accum_ext;
+   union Data_32_or_8_24 rev_period;
+   uint8_t        rev_period_ext;
+   _Bool          index_seen;
+   uint24_t       fast_ultra_threshold;
+   uint24_t       ultra_fast_threshold;
+   uint24_t       fast_tcr2_threshold;
+   uint24_t       tcr2_fast_threshold;
+   uint24_t       tcr2_interval;
+   uint24_t       tcr2_base;
+   uint8_t        tcr2_state;
+   uint24_t       position_lo;
+   int24_t        position_hi;
+   union Data_32_or_8_24 tcr_ext;
+   uint8_t        last_leading_edge_ext;
+   uint8_t        last_edge_ext;
+#ifdef QD_EDGE_RING
+   union Data_32_or_8_24 *ring_start;
+   union Data_32_or_8_24 *ring_end;
+   union Data_32_or_8_24 *ring_wr;
+   union Data_32_or_8_24 *ring_rd;
+   uint24_t       ring_overflow;
+   uint8_t        ring_seq;
+#endif
+#ifdef QD_EDGE_HISTORY
+   union Data_32_or_8_24 *hist_start;
+   union Data_32_or_8_24 *hist_end;
+   union Data_32_or_8_24 *hist_wr;
+#endif
+#ifdef QD_PERIOD_AVG
+   union Data_32_or_8_24 period_avg;
+   union Data_32_or_8_24 period_sum;
+   union Data_32_or_8_24 *avg_start;
+   union Data_32_or_8_24 *avg_end;
+   union Data_32_or_8_24 *avg_wr;
+   uint8_t        avg_shift;
+#endif
+#ifdef QD_TRIGGER_TABLE
+   union Data_32_or_8_24 *trig_start;
+   union Data_32_or_8_24 *trig_end;
+   union Data_32_or_8_24 *trig_next;
+   union Data_32_or_8_24 *trig_new_start;
+   union Data_32_or_8_24 *trig_new_end;
+   union Data_32_or_8_24 trig_last;
+   uint8_t        trig_link_chan;
+#endif
+#ifdef QD_PC_IRQ_COALESCING
+   uint24_t       irq_min_interval;
+   int24_t        irq_last_time;
+   uint24_t       irq_suppressed;
+   uint8_t        irq_hysteresis;
+   uint8_t        irq_rev_div;
+   uint8_t        irq_state;
+#endif
+#ifdef QD_STANDSTILL
+   uint24_t       standstill_timeout;
+   _Bool          standstill;
+   _Bool          standstill_irq;
+#endif
+#ifdef QD_FAST_REVERSAL
+   _Bool          fast_reversal;
+#endif
+#ifdef QD_ERROR_COUNTERS
+   uint24_t       illegal_count;
+   uint24_t       window_count;
+   uint24_t       spurious_count;
+#endif
+#ifdef QD_PROFILING
+   uint24_t       prof_init;
+   uint24_t       prof_slow_normal;
+   uint24_t       prof_fast;
+   uint24_t       prof_overflow;
+   uint24_t       prof_index_home;
+   uint24_t       prof_mode_switch;
+#endif
 
    /* main QD */
    
    /* threads */
    _eTPU_thread Init(_eTPU_matches_disabled);
    _eTPU_thread LatchAndClearErrors(_eTPU_matches_enabled);
-   _eTPU_thread SlowNormalFallingEdge(_eTPU_matches_enabled);
-   _eTPU_thread SlowNormalModeRisingEdge(_eTPU_matches_enabled);
+   _eTPU_thread NonLeadingEdge(_eTPU_matches_enabled);
+   _eTPU_thread SlowModeLeadingEdge(_eTPU_matches_enabled);
+   _eTPU_thread NormalModeLeadingEdge(_eTPU_matches_enabled);
    _eTPU_thread PeriodOverflow(_eTPU_matches_enabled);
    _eTPU_thread FastModeEdge(_eTPU_matches_enabled);
+   _eTPU_thread FastModeMatch(_eTPU_matches_enabled);
 
    /* fragments */
-   _eTPU_fragment SlowNormalCommon();
-   _eTPU_fragment Common();
+   _eTPU_fragment NormalToFast();
+   _eTPU_fragment FastToNormal();
+#ifdef QD_FAST_REVERSAL
+   _eTPU_fragment FastReversal();
+#endif
+   _eTPU_fragment FastToUltra();
+   _eTPU_fragment UltraFastEdge();
+   _eTPU_fragment UltraToSlow();
+   _eTPU_fragment UltraNextEdges();
+   _eTPU_fragment FastToTcr2();
+   _eTPU_fragment Tcr2Reconcile();
+   _eTPU_fragment Tcr2NextMatch();
+   _eTPU_fragment SlowModeNextEdge();
+   _eTPU_fragment LeadingEdgeWindow();
+   _eTPU_fragment WindowNextEdge();
+   _eTPU_fragment SpuriousEdge();
+#ifdef QD_STANDSTILL
+   _eTPU_fragment StandstillOverflow();
+#endif
+
+   /* functions */
+   void CountEdge();
+   uint24_t LeadingEdgePeriod();
+#ifdef QD_TRIGGER_TABLE
+   void TriggerEdge();
+   void TriggerSeek();
+#endif
+   void PcInterrupt();
+   void ReadPins();
+   uint8_t PinState();
+   int8_t SlowFromPins();
+   void CountToPins(int8_t at_level);
+   void PositionAdd(int24_t counts);
+   uint8_t TimeExt(uint24_t time);
+#ifdef QD_STANDSTILL
+   void StandstillMatch();
+   void StandstillEnd();
+#endif
+   void IllegalCheck(int8_t pin_bit);
 
    /* entry table */
    _eTPU_entry_table QD;
@@ -255,11 +588,16 @@ _eTPU_class QD
    _eTPU_thread Index_FirstTransitionLink(_eTPU_matches_enabled);
    _eTPU_thread Index_SecondTransition(_eTPU_matches_enabled);
    _eTPU_thread Index_SecondTransitionLink(_eTPU_matches_enabled);
+   _eTPU_thread Index_PeriodOverflow(_eTPU_matches_enabled);
 
    /* fragments */
    _eTPU_fragment Index_FirstTransitionCommon();
    _eTPU_fragment Index_SecondTransitionCommon();
 
+   /* functions */
+   void RevolutionAccum(uint24_t ticks);
+   void RevolutionPeriod();
+
    /* entry table */
    _eTPU_entry_table QD_INDEX;
 #endif
@@ -279,37 +617,40 @@ DEFINE_ENTRY_TABLE(QD, QD, alternate, inputpin, QD_FUNCTION_NUMBER)
    ETPU_VECTOR1(0,     1,  0, 0, 0,  x, x, _Error_handler_unexpected_thread),
    ETPU_VECTOR1(0,     1,  0, 0, 1,  x, x, _Error_handler_unexpected_thread),
 
-   ETPU_VECTOR1(0,     x,  1, 0, 0,  1, 0, _Error_handler_unexpected_thread),
-   ETPU_VECTOR1(0,     x,  1, 0, 0,  1, 1, _Error_handler_unexpected_thread),
-   ETPU_VECTOR1(0,     x,  1, 0, 1,  1, 0, _Error_handler_unexpected_thread),
-   ETPU_VECTOR1(0,     x,  1, 0, 1,  1, 1, _Error_handler_unexpected_thread),
-
-   /* Slow or normal mode, rising edge */
-   ETPU_VECTOR1(0,     x,  0, 1, 0,  0, 0, SlowNormalModeRisingEdge),
-   ETPU_VECTOR1(0,     x,  0, 1, 1,  0, 0, SlowNormalModeRisingEdge),
-   ETPU_VECTOR1(0,     x,  1, 1, 0,  0, 0, SlowNormalModeRisingEdge),
-   ETPU_VECTOR1(0,     x,  1, 1, 1,  0, 0, SlowNormalModeRisingEdge),
-
-   /* Slow or normal mode, falling edge */
-   ETPU_VECTOR1(0,     x,  0, 1, 0,  0, 1, SlowNormalFallingEdge),
-   ETPU_VECTOR1(0,     x,  0, 1, 1,  0, 1, SlowNormalFallingEdge),
-   ETPU_VECTOR1(0,     x,  1, 1, 0,  0, 1, SlowNormalFallingEdge),
-   ETPU_VECTOR1(0,     x,  1, 1, 1,  0, 1, SlowNormalFallingEdge),
-
-    /* */
+   /* Fast mode, match without transition (ultra fast mode timeout, TCR2 mode) */
+   ETPU_VECTOR1(0,     x,  1, 0, 0,  1, 1, FastModeMatch),
+   ETPU_VECTOR1(0,     x,  1, 0, 1,  1, 1, FastModeMatch),
+
+   /* Slow or normal mode, edge which is not a leading edge */
+   ETPU_VECTOR1(0,     x,  0, 1, 0,  0, 0, NonLeadingEdge),
+   ETPU_VECTOR1(0,     x,  0, 1, 1,  0, 0, NonLeadingEdge),
+   ETPU_VECTOR1(0,     x,  1, 1, 0,  0, 0, NonLeadingEdge),
+   ETPU_VECTOR1(0,     x,  1, 1, 1,  0, 0, NonLeadingEdge),
+
+   /* Slow mode, leading edge */
+   ETPU_VECTOR1(0,     x,  0, 1, 0,  0, 1, SlowModeLeadingEdge),
+   ETPU_VECTOR1(0,     x,  0, 1, 1,  0, 1, SlowModeLeadingEdge),
+   ETPU_VECTOR1(0,     x,  1, 1, 0,  0, 1, SlowModeLeadingEdge),
+   ETPU_VECTOR1(0,     x,  1, 1, 1,  0, 1, SlowModeLeadingEdge),
+
+   /* Normal mode, leading edge */
+   ETPU_VECTOR1(0,     x,  0, 1, 0,  1, 0, NormalModeLeadingEdge),
+   ETPU_VECTOR1(0,     x,  0, 1, 1,  1, 0, NormalModeLeadingEdge),
+   ETPU_VECTOR1(0,     x,  1, 1, 0,  1, 0, NormalModeLeadingEdge),
+   ETPU_VECTOR1(0,     x,  1, 1, 1,  1, 0, NormalModeLeadingEdge),
+
+   /* Slow or normal mode, period overflow */
    ETPU_VECTOR1(0,     x,  1, 0, 0,  0, 0, PeriodOverflow),
    ETPU_VECTOR1(0,     x,  1, 0, 0,  0, 1, PeriodOverflow),
    ETPU_VECTOR1(0,     x,  1, 0, 1,  0, 0, PeriodOverflow),
    ETPU_VECTOR1(0,     x,  1, 0, 1,  0, 1, PeriodOverflow),
+   ETPU_VECTOR1(0,     x,  1, 0, 0,  1, 0, PeriodOverflow),
+   ETPU_VECTOR1(0,     x,  1, 0, 1,  1, 0, PeriodOverflow),
 
-   /* Fast mode activates on edge and flag0 == 1 */
-   ETPU_VECTOR1(0,     x,  0, 1, 0,  1, 0, FastModeEdge),
+   /* Fast mode, leading edge */
    ETPU_VECTOR1(0,     x,  0, 1, 0,  1, 1, FastModeEdge),
-   ETPU_VECTOR1(0,     x,  0, 1, 1,  1, 0, FastModeEdge),
    ETPU_VECTOR1(0,     x,  0, 1, 1,  1, 1, FastModeEdge),
-   ETPU_VECTOR1(0,     x,  1, 1, 0,  1, 0, FastModeEdge),
    ETPU_VECTOR1(0,     x,  1, 1, 0,  1, 1, FastModeEdge),
-   ETPU_VECTOR1(0,     x,  1, 1, 1,  1, 0, FastModeEdge),
    ETPU_VECTOR1(0,     x,  1, 1, 1,  1, 1, FastModeEdge),
 };
 
@@ -366,16 +707,16 @@ DEFINE_ENTRY_TABLE(QD, QD_INDEX, standard, inputpin, QDINDEX_FUNCTION_NUMBER)
 	ETPU_VECTOR1(5,  x,  x, x, x,  x, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(6,  x,  x, x, x,  x, x, _Error_handler_unexpected_thread),
 	ETPU_VECTOR1(7,  x,  x, x, x,  x, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  1,  1, 1, x,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  1,  1, 1, x,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  1,  1, 1, x,  0, x, Index_PeriodOverflow),
+	ETPU_VECTOR1(0,  1,  1, 1, x,  1, x, Index_PeriodOverflow),
 	ETPU_VECTOR1(0,  0,  0, 1, 0,  0, x, Index_SecondTransition),
 	ETPU_VECTOR1(0,  0,  0, 1, 0,  1, x, Index_FirstTransition),
 	ETPU_VECTOR1(0,  0,  0, 1, 1,  0, x, Index_FirstTransition),
 	ETPU_VECTOR1(0,  0,  0, 1, 1,  1, x, Index_SecondTransition),
-	ETPU_VECTOR1(0,  0,  1, 0, 0,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  0,  1, 0, 0,  1, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  0,  1, 0, 1,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  0,  1, 0, 1,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  0,  1, 0, 0,  0, x, Index_PeriodOverflow),
+	ETPU_VECTOR1(0,  0,  1, 0, 0,  1, x, Index_PeriodOverflow),
+	ETPU_VECTOR1(0,  0,  1, 0, 1,  0, x, Index_PeriodOverflow),
+	ETPU_VECTOR1(0,  0,  1, 0, 1,  1, x, Index_PeriodOverflow),
 	ETPU_VECTOR1(0,  0,  1, 1, 0,  0, x, Index_SecondTransition),
 	ETPU_VECTOR1(0,  0,  1, 1, 0,  1, x, Index_FirstTransition),
 	ETPU_VECTOR1(0,  0,  1, 1, 1,  0, x, Index_FirstTransition),
@@ -386,8 +727,8 @@ DEFINE_ENTRY_TABLE(QD, QD_INDEX, standard, inputpin, QDINDEX_FUNCTION_NUMBER)
 	ETPU_VECTOR1(0,  1,  0, 0, 1,  1, x, Index_SecondTransitionLink),
 	ETPU_VECTOR1(0,  1,  0, 1, x,  0, x, Index_FirstTransition),
 	ETPU_VECTOR1(0,  1,  0, 1, x,  1, x, Index_FirstTransition),
-	ETPU_VECTOR1(0,  1,  1, 0, x,  0, x, _Error_handler_unexpected_thread),
-	ETPU_VECTOR1(0,  1,  1, 0, x,  1, x, _Error_handler_unexpected_thread),
+	ETPU_VECTOR1(0,  1,  1, 0, x,  0, x, Index_PeriodOverflow),
+	ETPU_VECTOR1(0,  1,  1, 0, x,  1, x, Index_PeriodOverflow),
 };
 #endif
 
@@ -397,6 +738,11 @@ DEFINE_ENTRY_TABLE(QD, QD_INDEX, standard, inputpin, QDINDEX_FUNCTION_NUMBER)
 **********************************************/
 _eTPU_thread QD::Init(_eTPU_matches_disabled)
 {   
+   uint8_t tmp_chan;
+   int8_t at_level;
+
+   QD_PROF_HIT(prof_init);
+   seq += 1;                                               // Start of QD outputs update.
    if(QD_TIMER_TCR1)                                       // With FM1 select TCR1 or TCR2.
    {  
       ActionUnitA( MatchTCR1, CaptureTCR1, GreaterEqual);  // TCR1 clock selected.
@@ -413,17 +759,18 @@ _eTPU_thread QD::Init(_eTPU_matches_disabled)
       ClearAllLatches();                                   // Negate all pending events.
       last_leading_edge=tcr2;                              // Store current TCR2 value.
    }
+   tcr_ext._data_8_24._data_24_lsb = last_leading_edge;    // Start the TCR wrap extension
+   last_leading_edge_ext = tcr_ext._data_8_24._data_8_msb;
+   last_edge_ext = tcr_ext._data_8_24._data_8_msb;
    if(CurrentInputPin==1)                                  // Get latest pin state.
    {
       OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
       if(QD_CHANNEL_PRIMARY)                                // for primary channel
       {   
-         Set(flag1);                                         // The next edge must be falling edge
          pins |= QD_PIN_A;                                   // Set primary channel pin_A bit of pins parameter
       }
       else                                                  // for secondary channel
       {
-         Set(flag1);                                         // The next edge must be falling edge
          pins |= QD_PIN_B;                                   // Set secondary channel pin_B bit of pins parameter
       }
    }
@@ -432,319 +779,1459 @@ _eTPU_thread QD::Init(_eTPU_matches_disabled)
       OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
       if(QD_CHANNEL_PRIMARY)                                // for primary channel
       {   
-         Clear(flag1);                                       // The next edge must be rising edge
          pins &= ~QD_PIN_A;                                  // Clear primary channel pin_A bit of pins parameter
       }
-      else                                                  // for secondary channel
+      else                                                  // for secondary channel
+      {
+         pins &= ~QD_PIN_B;                                  // Clear secondary channel pin_B bit of pins parameter
+      }
+   }
+   pc=0;                                                   // Set Position Counter to 0.
+   mode_current=QD_MODE_SLOW;                              // Set mode_current to slow
+   period_accum._data_32 = 0;
+
+   /* Select the slow mode edge threads of both channels. The partner
+      channel may not be initialized yet - its Init does this again. */
+   at_level = pins;                                        // Pins on their leading edge level
+   if(!(pins & QD_CONFIGURATION))
+      at_level = ~pins;
+   tmp_chan = chan;
+   chan = phase_A_chan;
+   Clear(flag0);
+   if((at_level & (QD_PIN_A+QD_PIN_B)) == QD_PIN_B)
+      Set(flag1);                                          // The next phase A edge is the leading edge
+   else
+      Clear(flag1);
+   chan = phase_B_chan;
+   Clear(flag0);
+   if((at_level & (QD_PIN_A+QD_PIN_B)) == QD_PIN_A)
+      Set(flag1);                                          // The next phase B edge is the leading edge
+   else
+      Clear(flag1);
+   chan = tmp_chan;
+   
+   found_leading_edge = FALSE;
+#ifdef QD_PC_IRQ_COALESCING
+   irq_state = QD_IRQ_ARMED1 + QD_IRQ_ARMED2;
+#endif
+#ifdef QD_STANDSTILL
+   standstill = FALSE;
+#endif
+   erta = last_leading_edge + 0x800000;
+   WriteErtAToMatchAAndEnable();
+   
+   EnableEventHandling();                                  // Enable channel.
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/**********************************************
+* Latch the error flags and clear the working copy
+**********************************************/
+_eTPU_thread QD::LatchAndClearErrors(_eTPU_matches_enabled)
+{
+   QD_PROF_HIT(prof_init);
+   seq += 1;                                               // Start of QD outputs update.
+   error_flags_latched = error_flags;
+   error_flags = 0;
+   seq += 1;                                               // End of QD outputs update.
+}
+   
+/************************************************************
+* Edge which is not a Leading Edge in Slow/Normal Mode
+************************************************************/
+_eTPU_thread QD::NonLeadingEdge(_eTPU_matches_enabled)
+{
+   uint8_t tmp_chan;
+   int8_t pin_bit;
+   int8_t at_level;
+
+   QD_PROF_HIT(prof_slow_normal);
+   seq += 1;                                                // Start of QD outputs update.
+   if(QD_CHANNEL_PRIMARY)
+      pin_bit = QD_PIN_A;
+   else
+      pin_bit = QD_PIN_B;
+   if (mode_current & QD_MODE_SLOW)                         // Pin back on its level - spurious edge
+   {
+      if(pins & pin_bit)
+      {
+         if(CurrentInputPin==1)
+            SpuriousEdge();
+      }
+      else if(CurrentInputPin==0)
+         SpuriousEdge();
+   }
+   pins ^= pin_bit;                                         // Update the pin bit of this channel
+   if(pins & pin_bit)
+      OnTransA(HighLow);                                    // Rising edge - the next edge must be falling edge
+   else
+      OnTransA(LowHigh);                                    // Falling edge - the next edge must be rising edge
+
+   if (mode_current & QD_MODE_SLOW)                         // For slow mode
+   {
+      if((QD_CHANNEL_SECONDARY)^(pins & QD_PIN_A)^((pins & QD_PIN_B)>>1)) // Perform lead/lag test.
+         direction=QD_DIRECTION_INCREMENT;                   // Set direction.
+      else
+         direction=QD_DIRECTION_DECREMENT;                   // Set direction.
+      IllegalCheck(pin_bit);
+   }
+   else if (!IsTransALatched())                             // Detection window end?
+   {
+      erta = last_edge + (period._data_8_24._data_24_lsb >> 2);                        // Estimate edge time from previous egde and period
+      error_flags |= QD_ERROR_WINDOWING;
+#ifdef QD_ERROR_COUNTERS
+      if (window_count < QD_ERROR_COUNT_MAX)
+         window_count += 1;
+#endif
+   }
+   CountEdge();
+
+   /* Clear leading edge indication bit and Fast to Normal Switch indication bit */
+   mode_current &= (~(QD_LEADING_EDGE_INDICATION | QD_FAST_TO_NORMAL_SWITCH));
+
+   /* When the other pin is on its leading edge level, the next edge of
+      this channel is the leading edge. Otherwise it is the next edge of
+      the other channel, if this pin has just reached its level. */
+   at_level = pins;
+   if(!(pins & QD_CONFIGURATION))
+      at_level = ~pins;
+   if(at_level & (pin_bit ^ (QD_PIN_A+QD_PIN_B)))
+   {
+      if (mode_current & QD_MODE_SLOW)
+         Set(flag1);
+      else
+         Set(flag0);
+   }
+   else
+   {
+      tmp_chan = chan;
+      if(QD_CHANNEL_PRIMARY)                                // for primary channel
+         chan = phase_B_chan;
+      else                                                  // for secondary channel
+         chan = phase_A_chan;
+      if(!(at_level & pin_bit))
+      {
+         Clear(flag0);
+         Clear(flag1);
+      }
+      else if (mode_current & QD_MODE_SLOW)
+         Set(flag1);
+      else
+         Set(flag0);
+      chan = tmp_chan;
+   }
+
+   if (mode_current & QD_MODE_SLOW)
+      SlowModeNextEdge();
+   WindowNextEdge();
+}
+
+/************************************************************
+* Leading Edge in Slow Mode
+************************************************************/
+_eTPU_thread QD::SlowModeLeadingEdge(_eTPU_matches_enabled)
+{
+   uint24_t tmp_period;
+
+   QD_PROF_HIT(prof_slow_normal);
+   seq += 1;                                                // Start of QD outputs update.
+   if(pins & QD_CONFIGURATION)                              // Pin not on its leading edge level - spurious edge
+   {
+      if(CurrentInputPin==0)
+         SpuriousEdge();
+   }
+   else if(CurrentInputPin==1)
+      SpuriousEdge();
+   Clear(flag1);                                            // No next edge is a leading edge
+   if(pins & QD_CONFIGURATION)                              // Both pins are on their leading edge level now
+   {
+      OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
+      pins = QD_PIN_A + QD_PIN_B + QD_CONFIGURATION;
+   }
+   else
+   {
+      OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
+      pins = 0;
+   }
+   if(QD_CHANNEL_SECONDARY)                                 // Lead/lag test - phase B completes
+   {
+      direction=QD_DIRECTION_INCREMENT;                     // the leading edge when incrementing
+      IllegalCheck(QD_PIN_B);
+   }
+   else
+   {
+      direction=QD_DIRECTION_DECREMENT;
+      IllegalCheck(QD_PIN_A);
+   }
+   CountEdge();
+   tmp_period = LeadingEdgePeriod();
+
+   if (!found_leading_edge)
+   {
+      found_leading_edge = TRUE;
+      mode_current |= QD_LEADING_EDGE_INDICATION;           // Set leading edge indication bit
+      SlowModeNextEdge();
+   }
+   if(tmp_period < slow_normal_threshold && period._data_8_24._data_8_msb == 0)      // Exit Slow mode and enter Normal mode.
+   {
+      QD_PROF_HIT(prof_mode_switch);
+      mode_current = QD_MODE_NORMAL + QD_LEADING_EDGE_INDICATION;
+      LeadingEdgeWindow();
+   }
+   mode_current = QD_MODE_SLOW + QD_LEADING_EDGE_INDICATION;
+   SlowModeNextEdge();
+}
+
+/************************************************************
+* Leading Edge in Normal Mode
+************************************************************/
+_eTPU_thread QD::NormalModeLeadingEdge(_eTPU_matches_enabled)
+{
+   uint24_t tmp_period;
+
+   QD_PROF_HIT(prof_slow_normal);
+   seq += 1;                                                // Start of QD outputs update.
+   Clear(flag0);                                            // No next edge is a leading edge
+   if(pins & QD_CONFIGURATION)                              // Both pins are on their leading edge level now
+   {
+      OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
+      pins = QD_PIN_A + QD_PIN_B + QD_CONFIGURATION;
+   }
+   else
+   {
+      OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
+      pins = 0;
+   }
+   if (!IsTransALatched())                                  // Detection window end?
+   {
+      erta = last_edge + (period._data_8_24._data_24_lsb >> 2);                        // Estimate edge time from previous egde and period
+      error_flags |= QD_ERROR_WINDOWING;
+#ifdef QD_ERROR_COUNTERS
+      if (window_count < QD_ERROR_COUNT_MAX)
+         window_count += 1;
+#endif
+   }
+   CountEdge();
+   tmp_period = LeadingEdgePeriod();
+
+   if(tmp_period < normal_fast_threshold)                   // Exit Normal mode and enter Fast mode
+   {
+      NormalToFast();
+   }
+   if(tmp_period > normal_slow_threshold)                   // Exit Normal mode and enter Slow mode
+   {
+      QD_PROF_HIT(prof_mode_switch);
+      mode_current = QD_LEADING_EDGE_INDICATION + QD_MODE_SLOW;
+      SlowModeNextEdge();
+   }
+   mode_current = QD_MODE_NORMAL + QD_LEADING_EDGE_INDICATION;
+   LeadingEdgeWindow();
+}
+
+/************************************************************
+* Period Overflow detected
+************************************************************/
+_eTPU_thread QD::PeriodOverflow(_eTPU_matches_enabled)
+{
+#ifdef QD_STANDSTILL
+   uint24_t tmp_elapsed;
+   uint8_t tmp_chan;
+#endif
+
+   QD_PROF_HIT(prof_overflow);
+   ClearMatchALatch();
+#ifdef QD_STANDSTILL
+   if (standstill)
+      StandstillOverflow();                                // Standstill - keep tcr_ext running
+#endif
+   period_accum._data_8_24._data_24_lsb += (erta - last_leading_edge);
+   if (CC.C)
+   {
+      period_accum._data_8_24._data_8_msb += 1;
+   }
+   last_leading_edge = erta;
+   last_leading_edge_ext = TimeExt(erta);
+#ifdef QD_PC_IRQ_COALESCING
+   if (irq_state & QD_IRQ_HOLD)                            // End of pc_interrupt minimum interval?
+   {
+      if ((uint24_t)(erta - irq_last_time) >= irq_min_interval)
+         irq_state &= ~QD_IRQ_HOLD;
+   }
+#endif
+#ifdef QD_STANDSTILL
+   tmp_elapsed = erta - last_edge;
+#endif
+   erta += 0x800000;
+#ifdef QD_STANDSTILL
+   if ((standstill_timeout != 0) && (mode_current & QD_MODE_SLOW))
+   {
+      if (tmp_elapsed >= standstill_timeout)               // Standstill detected
+      {
+         seq += 1;                                          // Start of QD outputs update.
+         standstill = TRUE;
+         seq += 1;                                          // End of QD outputs update.
+         if (standstill_irq)
+         {
+            SetChannelInterrupt();
+         }
+         tmp_chan = chan;                                   // The other channel's overflow matches end here
+         if(QD_CHANNEL_PRIMARY)
+            chan = phase_B_chan;
+         else
+            chan = phase_A_chan;
+         DisableMatchDetection();
+         ClearMatchALatch();
+         chan = tmp_chan;
+      }
+      else
+      {
+         erta = last_edge + standstill_timeout;             // Standstill detection match
+      }
+   }
+#endif
+   WriteErtAToMatchAAndEnable();
+}
+
+/************************************************************
+* FAST Mode, Edge Detected (always a leading edge)
+************************************************************/
+_eTPU_thread QD::FastModeEdge(_eTPU_matches_enabled)
+{
+   uint24_t tmp_period;
+#ifdef QD_FAST_REVERSAL
+   uint8_t tmp_chan;
+   int8_t at_level;
+#endif
+
+   QD_PROF_HIT(prof_fast);
+   seq += 1;                                               // Start of QD outputs update.
+   if (mode_current & QD_MODE_ULTRA_FAST)
+   {
+      UltraFastEdge();
+   }
+   if (!IsTransALatched())                                 // Transition detected or detection window end?
+   {
+      erta = last_edge + period._data_8_24._data_24_lsb;                            // Estimate edge time from previous egde and period
+      error_flags |= QD_ERROR_WINDOWING;
+#ifdef QD_ERROR_COUNTERS
+      if (window_count < QD_ERROR_COUNT_MAX)
+         window_count += 1;
+#endif
+   }
+#ifdef QD_FAST_REVERSAL
+   else if (fast_reversal)                                 // Reversal detection - sample the other pin
+   {
+      if(QD_TIMER_TCR1)
+         tmp_period = tcr1 - erta;
+      else
+         tmp_period = tcr2 - erta;
+      if (tmp_period < (period._data_8_24._data_24_lsb >> 2)) // Other pin not changed since the edge?
+      {
+         tmp_chan = chan;
+         if(QD_CHANNEL_PRIMARY)
+            chan = phase_B_chan;
+         else
+            chan = phase_A_chan;
+         at_level = CurrentInputPin;
+         chan = tmp_chan;
+         if(!(pins & QD_CONFIGURATION))
+            at_level ^= 1;
+         if (!at_level)
+         {
+            FastReversal();
+         }
+      }
+   }
+#endif
+   CountEdge();
+   tmp_period = LeadingEdgePeriod();
+
+   if(tmp_period > fast_normal_threshold)                  // Exit Fast mode and enter Normal mode
+   {
+      FastToNormal();
+   }
+   if((tmp_period < fast_tcr2_threshold) && QD_TIMER_TCR1) // Exit Fast mode and enter TCR2 mode
+   {
+      FastToTcr2();
+   }
+   if(tmp_period < fast_ultra_threshold)                   // Exit Fast mode and enter Ultra Fast mode
+   {
+      FastToUltra();
+   }
+   mode_current = QD_MODE_FAST + QD_LEADING_EDGE_INDICATION;
+   LeadingEdgeWindow();
+}
+
+/************************************************************
+* Fast Mode, match without a transition - Ultra Fast Mode
+* timeout or TCR2 Mode reconcile
+************************************************************/
+_eTPU_thread QD::FastModeMatch(_eTPU_matches_enabled)
+{
+   QD_PROF_HIT(prof_fast);
+   seq += 1;                                               // Start of QD outputs update.
+   ClearMatchALatch();
+   if (mode_current & QD_MODE_TCR2)
+   {
+      Tcr2Reconcile();
+   }
+   if (mode_current & QD_MODE_ULTRA_FAST)
+   {
+      UltraToSlow();
+   }
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/************************************************************
+* Switch from Fast to Ultra Fast Mode on a leading edge
+************************************************************/
+_eTPU_fragment QD::FastToUltra()
+{
+   QD_PROF_HIT(prof_mode_switch);
+   mode_current = QD_MODE_ULTRA_FAST + QD_LEADING_EDGE_INDICATION;
+   if (direction & QD_DIRECTION_BIT7)                      // If direction is negative
+   {
+      direction=QD_DIRECTION_DECREMENT_ULTRA;               // Direction = -8
+   }
+   else
+   {
+      direction=QD_DIRECTION_INCREMENT_ULTRA;               // Direction = 8
+   }
+   /* The second leading edge of a pair is detected by transition B */
+   if(pins & QD_CONFIGURATION)
+   {
+      OnTransB(LowHigh);                                    // Pin is configured to detect low high transitions.
+   }
+   else
+   {
+      OnTransB(HighLow);                                    // Pin is configured to detect high low transitions.
+   }
+   UltraNextEdges();
+}
+
+/************************************************************
+* Ultra Fast Mode, a pair of leading edges or the timeout
+* after one leading edge
+************************************************************/
+_eTPU_fragment QD::UltraFastEdge()
+{
+   uint24_t tmp_period;
+
+   if (IsTransBLatched())                                  // Both leading edges detected
+   {
+      last_leading_edge = erta;                             // Period between the two edges
+      erta = ertb;
+      CountEdge();                                          // Count both edges
+      tmp_period = LeadingEdgePeriod();
+      if(tmp_period > ultra_fast_threshold)                 // Exit Ultra Fast mode and enter Fast mode
+      {
+         QD_PROF_HIT(prof_mode_switch);
+         mode_current = QD_MODE_FAST + QD_LEADING_EDGE_INDICATION;
+         if (direction & QD_DIRECTION_BIT7)
+         {
+            direction=QD_DIRECTION_DECREMENT_FAST;           // Direction = -4
+         }
+         else
+         {
+            direction=QD_DIRECTION_INCREMENT_FAST;           // Direction = 4
+         }
+         LeadingEdgeWindow();
+      }
+      if((tmp_period < fast_tcr2_threshold) && QD_TIMER_TCR1) // Exit Ultra Fast mode and enter TCR2 mode
+      {
+         FastToTcr2();
+      }
+      mode_current = QD_MODE_ULTRA_FAST + QD_LEADING_EDGE_INDICATION;
+      UltraNextEdges();
+   }
+   if (IsTransALatched())                                  // One leading edge before the timeout
+   {
+      if (direction & QD_DIRECTION_BIT7)
+      {
+         direction=QD_DIRECTION_DECREMENT_FAST;
+      }
+      else
+      {
+         direction=QD_DIRECTION_INCREMENT_FAST;
+      }
+      CountEdge();
+      LeadingEdgePeriod();
+   }
+   UltraToSlow();
+}
+
+/************************************************************
+* Leave Ultra Fast Mode for Slow Mode (timeout) - set both
+* channels up from the pin states, like the initialization
+************************************************************/
+_eTPU_fragment QD::UltraToSlow()
+{
+   int8_t at_level;
+
+   DisableMatchDetection();                                // End the timeout match
+   at_level = SlowFromPins();
+   CountToPins(at_level);
+   SlowModeNextEdge();
+}
+
+/************************************************************
+* Set up the detection of the next pair of leading edges in
+* Ultra Fast Mode (no window, timeout match)
+************************************************************/
+_eTPU_fragment QD::UltraNextEdges()
+{
+   SingleMatchDoubleTransition();                          // Channel mode: Single Match Double Transition
+   ClearAllLatches();                                      // Negate all pending events.
+   erta = last_edge + (ultra_fast_threshold << 2);         // Timeout - twice the time of two slowest periods
+   WriteErtAToMatchAAndEnable();
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/************************************************************
+* Switch from Fast or Ultra Fast to TCR2 Mode on a leading
+* edge - TCR2 counts the edges of the phase wired to TCRCLK
+* (rise and fall), this channel stops detecting transitions
+************************************************************/
+_eTPU_fragment QD::FastToTcr2()
+{
+   int8_t at_level;
+
+   QD_PROF_HIT(prof_mode_switch);
+   mode_current = QD_MODE_TCR2;
+   if (direction & QD_DIRECTION_BIT7)
+   {
+      direction=QD_DIRECTION_DECREMENT;
+   }
+   else
+   {
+      direction=QD_DIRECTION_INCREMENT;
+   }
+   OnTransA(NoDetect);                                     // Pin is configured to detect no transitions.
+   SingleMatchSingleTransition();
+   ClearAllLatches();
+   ReadPins();
+   tcr2_base = tcr2;
+   last_edge = tcr1;
+   last_edge_ext = TimeExt(last_edge);
+   at_level = pins;                                        // Pins on their leading edge level
+   if(!(pins & QD_CONFIGURATION))
+      at_level = ~pins;
+   at_level &= QD_PIN_A + QD_PIN_B;
+   CountToPins(at_level);                                  // Edges since the leading edge
+   tcr2_state = PinState();
+   erta = last_edge + tcr2_interval;                       // First reconcile match
+   WriteErtAToMatchAAndEnable();
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/************************************************************
+* TCR2 Mode, reconcile pc, period and the edge time with the
+* TCR2 edge count. Each TCR2 tick is an edge of one phase,
+* i.e. every second count; the pin state selects the count
+* from the 3 candidates (2*ticks - 1 .. 2*ticks + 1). TCR2 is
+* read before and after the pins, so that both belong to the
+* same edge; when it changes twice the reconcile is skipped.
+************************************************************/
+_eTPU_fragment QD::Tcr2Reconcile()
+{
+   uint24_t tmp_tcr2;
+   uint24_t tmp_time;
+   uint24_t tmp_period;
+   uint24_t tmp_edges;
+   int24_t counts;
+   uint8_t state;
+
+   tmp_tcr2 = tcr2;
+   ReadPins();
+   if (tcr2 != tmp_tcr2)                                   // TCRCLK edge during the pin read?
+   {
+      tmp_tcr2 = tcr2;                                     // Read the pins again, once
+      ReadPins();
+      if (tcr2 != tmp_tcr2)
+      {
+         Tcr2NextMatch();                                  // Skip - reconcile at the next match
+      }
+   }
+   tmp_time = tcr1;
+   state = PinState();
+   counts = state - tcr2_state;
+   if (direction & QD_DIRECTION_BIT7)
+   {
+      counts = -counts;
+   }
+   tmp_edges = (tmp_tcr2 - tcr2_base) << 1;                // 2 * TCR2 ticks
+   counts = ((counts - tmp_edges + 1) & 3) + tmp_edges - 1;
+   if (direction & QD_DIRECTION_BIT7)
+   {
+      pc -= counts;
+      pc_sc -= counts;
+      PositionAdd(-counts);
+   }
+   else
+   {
+      pc += counts;
+      pc_sc += counts;
+      PositionAdd(counts);
+   }
+   tcr2_base = tmp_tcr2;
+   tcr2_state = state;
+   tmp_period = tmp_time - last_edge;
+   last_edge = tmp_time;
+   last_leading_edge = tmp_time;                           // No period overflow in TCR2 mode
+   last_edge_ext = TimeExt(tmp_time);
+   last_leading_edge_ext = last_edge_ext;
+   period_accum._data_32 = 0;
+   if(options & QD_PC_MAX_ENABLED)                         // If pc_max is enabled
+   {
+      if(__abs(pc)>=pc_max)
+      {
+         pc=0;                                              // Reset PC
+#ifdef QD_TRIGGER_TABLE
+         if(options & QD_TRIGGER_TABLE_ENABLED)
+            TriggerSeek();
+#endif
+      }
+   }
+   period._data_32 = QD_PERIOD_STANDSTILL;
+   if (counts > 0)
+   {
+      tmp_period = (tmp_period << 2) / (uint24_t)counts;    // Period of 4 counts
+      period._data_8_24._data_8_msb = 0;
+      period._data_8_24._data_24_lsb = tmp_period;
+   }
+   if ((counts <= 0) || (tmp_period > tcr2_fast_threshold)) // Exit TCR2 mode and enter Slow mode
+   {
+      SlowFromPins();
+      SlowModeNextEdge();
+   }
+   Tcr2NextMatch();
+}
+
+/************************************************************
+* TCR2 Mode, schedule the next reconcile match
+************************************************************/
+_eTPU_fragment QD::Tcr2NextMatch()
+{
+   erta += tcr2_interval;                                  // Next reconcile match
+   WriteErtAToMatchAAndEnable();
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/************************************************************
+* Switch from Normal to Fast Mode on a leading edge
+************************************************************/
+_eTPU_fragment QD::NormalToFast()
+{
+   uint8_t tmp_chan;
+
+   QD_PROF_HIT(prof_mode_switch);
+   mode_current = QD_MODE_FAST + QD_LEADING_EDGE_INDICATION;   // Set mode_current to fast.
+   if (direction & QD_DIRECTION_BIT7)                      // If direction is negative
+   {
+      direction=QD_DIRECTION_DECREMENT_FAST;                // Direction = -4
+   }
+   else
+   {
+      direction=QD_DIRECTION_INCREMENT_FAST;                // Direction = 4
+   }
+   Set(flag0);                                             // Set Fast mode
+   Set(flag1);
+   /* According to the configuration detect high_low/low_high edges */
+   if(pins & QD_CONFIGURATION)
+   {
+      OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
+   }
+   else
+   {
+      OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
+   }
+   tmp_chan = chan;
+   if(QD_CHANNEL_PRIMARY)                                  // for primary channel
+   {   
+      chan = phase_B_chan;
+   }
+   else                                                    // for secondary channel
+   {
+      chan = phase_A_chan; 
+   }
+   OnTransA(NoDetect);                                     // Pin is configured to detect no transitions.
+   DisableMatchDetection();                                // Prevent from end-window match
+   ClearAllLatches();
+   chan = tmp_chan;
+   LeadingEdgeWindow();
+}
+
+/************************************************************
+* Switch from Fast to Normal Mode on a leading edge
+************************************************************/
+_eTPU_fragment QD::FastToNormal()
+{
+   uint8_t tmp_chan;
+
+   QD_PROF_HIT(prof_mode_switch);
+   /* Set mode_current to normal and 
+      set the QD_FAST_TO_NORMAL_SWITCH bit to indicate 
+      the edge in which the mode swithes from Fast to Normal */
+   mode_current = QD_FAST_TO_NORMAL_SWITCH + QD_MODE_NORMAL + QD_LEADING_EDGE_INDICATION;
+
+   if (direction & QD_DIRECTION_BIT7)                      // If direction is negative
+   {
+      direction=QD_DIRECTION_DECREMENT;                     // Direction = -1
+   }
+   else
+   {
+      direction=QD_DIRECTION_INCREMENT;                     // Direction = 1
+   }
+   Clear(flag0);                                           // Set SLOW/NORMAL mode, the next edge
+   Clear(flag1);                                           // is not a leading edge
+   /* According to the configuration detect high_low/low_high edges */
+   if(pins & QD_CONFIGURATION)
+   {
+      OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
+   }
+   else
+   {
+      OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
+   }
+   /* The other channel misses its edge away from the leading edge level;
+      count it and continue with its next edge, which is the leading edge */
+   pc += direction;                                        // Decrement or Increment the PC.    
+   pc_sc += direction;                                     // Decrement or Increment the PC_SC. 
+   PositionAdd(direction);                                 // 48-bit absolute position
+   tmp_chan = chan;
+   if(QD_CHANNEL_PRIMARY)                                  // for primary channel
+   {   
+      chan = phase_B_chan;                                  // Switch to secondary channel
+      pins ^= QD_PIN_B;
+   }
+   else                                                    // for secondary channel
+   {
+      chan = phase_A_chan;                                  // Switch to primary channel
+      pins ^= QD_PIN_A;
+   }
+   /* According to the configuration detect high_low/low_high edges */
+   if(pins & QD_CONFIGURATION)
+   {
+      OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
+   }
+   else
+   {
+      OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
+   }
+   Set(flag0);                                             // Normal mode, the next edge is the leading edge
+   SingleMatchSingleTransition();                          // Channel mode: Both Match Single Transition.
+   chan = tmp_chan;
+   LeadingEdgeWindow();
+}
+
+#ifdef QD_FAST_REVERSAL
+/************************************************************
+* Direction reversal detected on an edge in Fast Mode - count
+* the edge and switch to Slow Mode with both channels detecting
+************************************************************/
+_eTPU_fragment QD::FastReversal()
+{
+   uint8_t tmp_chan;
+   int8_t pin_bit;
+
+   QD_PROF_HIT(prof_mode_switch);
+   /* This pin is on its leading edge level, the other one is not. The
+      shaft is one count beyond the last leading edge (it passed it and
+      turned back) or three counts before it, assume the former. */
+   if (direction & QD_DIRECTION_BIT7)
+      direction = QD_DIRECTION_DECREMENT;
+   else
+      direction = QD_DIRECTION_INCREMENT;
+   CountEdge();
+   direction = -direction;
+   error_flags |= QD_ERROR_REVERSAL;
+   mode_current = QD_MODE_SLOW;
+
+   if(QD_CHANNEL_PRIMARY)
+      pin_bit = QD_PIN_A;
+   else
+      pin_bit = QD_PIN_B;
+   Clear(flag0);                                           // The next edge of this channel is not
+   Clear(flag1);                                           // a leading edge
+   if(pins & QD_CONFIGURATION)
+   {
+      OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
+      pins = pin_bit + QD_CONFIGURATION;
+   }
+   else
+   {
+      OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
+      pins = pin_bit ^ (QD_PIN_A + QD_PIN_B);
+   }
+   tmp_chan = chan;
+   if(QD_CHANNEL_PRIMARY)                                  // for primary channel
+      chan = phase_B_chan;
+   else                                                    // for secondary channel
+      chan = phase_A_chan;
+   if(pins & QD_CONFIGURATION)
+   {
+      OnTransA(LowHigh);                                    // Pin is configured to detect low high transitions.
+   }
+   else
+   {
+      OnTransA(HighLow);                                    // Pin is configured to detect high low transitions.
+   }
+   Clear(flag0);                                           // Slow mode, the next edge of the other
+   Set(flag1);                                             // channel is the leading edge
+   SingleMatchSingleTransition();
+   ClearAllLatches();
+   chan = tmp_chan;
+   SlowModeNextEdge();
+}
+#endif
+
+/************************************************************
+* Set up the next edge detection in Slow Mode
+* (no window, period overflow match)
+************************************************************/
+_eTPU_fragment QD::SlowModeNextEdge()
+{
+   SingleMatchSingleTransition();                          // Channel mode: Single Match Single Transition when not windowing.
+   ClearAllLatches();                                      // Negate all pending events.
+   erta = last_edge + 0x800000;                            // start up period overflow match
+#ifdef QD_STANDSTILL
+   if (standstill_timeout != 0)
+   {
+      erta = last_edge + standstill_timeout;               // or standstill detection match
+   }
+#endif
+   WriteErtAToMatchAAndEnable();
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/************************************************************
+* Leading edge in Normal or Fast Mode - compute the detection
+* window offsets of the new period, then set up the next edge
+************************************************************/
+_eTPU_fragment QD::LeadingEdgeWindow()
+{
+   uint24_t tmp_period;
+
+   if((options & QD_WINDOWING_DISABLED)==0)
+   {
+      tmp_period = period._data_8_24._data_24_lsb;
+      if (mode_current & QD_MODE_NORMAL)
+         tmp_period >>= 1; // windowing based upon half period when in NORMAL mode
+      window_end = tmp_period + mulir(tmp_period, ratio2);
+      window_begin = mulir(tmp_period, ratio1);
+   }
+   WindowNextEdge();
+}
+
+/************************************************************
+* Set up the next edge detection in Normal or Fast Mode
+* (detection window unless windowing is disabled)
+************************************************************/
+_eTPU_fragment QD::WindowNextEdge()
+{
+   erta = last_edge;  // just in case erta is incorrect after channel changes etc.
+   if(options & QD_WINDOWING_DISABLED)
+   {
+      SingleMatchSingleTransition();                        // Channel mode: Single Match Single Transition when not windowing.
+      ClearAllLatches();                                    // Negate all pending events.
+   }
+   else
+   {
+      Match2SingleTransition();                             // Channel mode: Match B Single Transition
+      ertb = erta + window_end;                             // Setup next window end
+      /* When the transition did not come (Match B is latched) 
+         let the window opened, else setup next window beginning */
+      if(!(IsLatchedMatchB()))
+      {
+         erta += window_begin;                              // Setup next window beginning
+      }
+      ClearAllLatches();                                    // Negate all pending events.
+      WriteErtAToMatchAAndEnable();
+      WriteErtBToMatchBAndEnable();
+   }
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/************************************************************
+* Spurious edge in Slow Mode - the pin is back on its level
+* before the edge, the edge is not counted and the detection
+* stays as it is
+************************************************************/
+_eTPU_fragment QD::SpuriousEdge()
+{
+   error_flags |= QD_ERROR_SPURIOUS;
+#ifdef QD_ERROR_COUNTERS
+   if (spurious_count < QD_ERROR_COUNT_MAX)
+      spurious_count += 1;
+#endif
+   ClearTransLatch();                                      // Negate the transition event.
+   seq += 1;                                               // End of QD outputs update.
+}
+
+/************************************************************
+* Count an edge, any mode, and record it in the edge history
+************************************************************/
+void QD::CountEdge()
+{
+#ifdef QD_EDGE_HISTORY
+   union Data_32_or_8_24 *p_rec;
+#endif
+
+   DisableMatchDetection();                                // end any matches in progress
+
+   last_edge = erta;
+#ifdef QD_STANDSTILL
+   if (standstill)
+      StandstillEnd();                                     // tcr_ext may be up to a wrap behind
+#endif
+   last_edge_ext = TimeExt(erta);
+   pc+=direction;                                          // Decrement or Increment the PC.
+   pc_sc+=direction;                                       // Decrement or Increment the PC_SC.
+   PositionAdd(direction);                                 // 48-bit absolute position
+
+#ifdef QD_STANDSTILL
+   if (standstill)                                         // First edge after standstill
+   {
+      standstill = FALSE;
+      period_accum._data_32 = QD_PERIOD_STANDSTILL;
+      last_leading_edge = erta;
+      last_leading_edge_ext = last_edge_ext;
+   }
+#endif
+
+#ifdef QD_EDGE_HISTORY
+   if (options & QD_EDGE_HISTORY_ENABLED)                  // Append the edge to the edge history
+   {
+      hist_wr->_data_8_24._data_8_msb = direction;
+      hist_wr->_data_8_24._data_24_lsb = erta;
+      p_rec = hist_wr + 1;
+      if (p_rec >= hist_end)
+      {
+         p_rec = hist_start;
+      }
+      hist_wr = p_rec;
+   }
+#endif
+
+   if(options & QD_PC_INTERRUPT_ENABLED)
+      PcInterrupt();                                        // Generate interrupt when pc=pc_interrupt1 or pc=pc_interrupt2
+
+#ifdef QD_TRIGGER_TABLE
+   if(options & QD_TRIGGER_TABLE_ENABLED)
+      TriggerEdge();
+#endif
+}
+
+/************************************************************
+* pc_interrupt - interrupt when pc hits pc_interrupt1 or
+* pc_interrupt2. With QD_PC_IRQ_COALESCING a pc_interrupt
+* value which has triggered is disarmed until pc moves more
+* than irq_hysteresis counts away from it, an interrupt is
+* held off for irq_min_interval after the previous one, and
+* only every irq_rev_div-th revolution interrupts. Hits which
+* do not interrupt are counted in irq_suppressed.
+************************************************************/
+void QD::PcInterrupt()
+{
+#ifdef QD_PC_IRQ_COALESCING
+   uint8_t state;
+   uint8_t armed;
+   _Bool hit;
+
+   state = irq_state;
+   if (state & QD_IRQ_HOLD)                                // End of minimum interval?
+   {
+      if ((uint24_t)(erta - irq_last_time) >= irq_min_interval)
+         state &= ~QD_IRQ_HOLD;
+   }
+   hit = FALSE;
+   armed = 0;
+   if (pc == pc_interrupt1)
+   {
+      hit = TRUE;
+      armed = state & QD_IRQ_ARMED1;
+      state &= ~QD_IRQ_ARMED1;
+   }
+   else if (__abs(pc - pc_interrupt1) > irq_hysteresis)
+   {
+      state |= QD_IRQ_ARMED1;
+   }
+   if (pc == pc_interrupt2)
+   {
+      hit = TRUE;
+      armed |= state & QD_IRQ_ARMED2;
+      state &= ~QD_IRQ_ARMED2;
+   }
+   else if (__abs(pc - pc_interrupt2) > irq_hysteresis)
+   {
+      state |= QD_IRQ_ARMED2;
+   }
+   if (hit)
+   {
+      if (armed && !(state & QD_IRQ_HOLD) &&
+          ((irq_rev_div <= 1) || ((uint24_t)__abs(rc) % irq_rev_div == 0)))
+      {
+         SetChannelInterrupt();                            // Generate interrupt
+         if (irq_min_interval != 0)
+         {
+            irq_last_time = erta;
+            state |= QD_IRQ_HOLD;
+         }
+      }
+      else
+      {
+         irq_suppressed += 1;
+      }
+   }
+   irq_state = state;
+#else
+   if((pc==pc_interrupt1)||(pc==pc_interrupt2))
+      SetChannelInterrupt();                                // Generate interrupt each time when pc=pc_interrupt1 or pc=pc_interrupt2
+#endif
+}
+
+#ifdef QD_TRIGGER_TABLE
+/************************************************************
+* Position trigger table - fire the entries reached by this
+* edge. Only the next target in the direction of motion is
+* compared, more than one when pc steps by 4 (Fast mode).
+* An entry triggers when pc reaches its position, not when
+* pc leaves it.
+************************************************************/
+void QD::TriggerEdge()
+{
+   union Data_32_or_8_24 *p_trig;
+   int24_t tmp_pc;
+   uint8_t actions;
+   uint8_t tmp_chan;
+
+   tmp_pc = pc - direction;                                // pc before this edge
+   if (trig_new_start != 0)                                // Swap to the table posted by the host
+   {
+      trig_start = trig_new_start;
+      trig_end = trig_new_end;
+      trig_new_start = 0;
+      p_trig = trig_start;                                 // Seek from the pc before this edge, so
+      while ((p_trig < trig_end) && ((int24_t)p_trig->_data_8_24._data_24_lsb <= tmp_pc))
+      {                                                    // that an entry at pc fires below
+         p_trig += 1;
+      }
+      trig_next = p_trig;
+   }
+
+   actions = 0;
+   p_trig = trig_next;
+   if (direction & QD_DIRECTION_BIT7)
+   {
+      while ((p_trig > trig_start) && ((int24_t)(p_trig - 1)->_data_8_24._data_24_lsb > pc))
+      {
+         p_trig -= 1;
+         if ((int24_t)p_trig->_data_8_24._data_24_lsb != tmp_pc)
+         {
+            actions |= p_trig->_data_8_24._data_8_msb;
+            trig_last._data_32 = p_trig->_data_32;
+         }
+      }
+      if ((p_trig > trig_start) && ((int24_t)(p_trig - 1)->_data_8_24._data_24_lsb == pc))
+      {
+         actions |= (p_trig - 1)->_data_8_24._data_8_msb;
+         trig_last._data_32 = (p_trig - 1)->_data_32;
+      }
+   }
+   else
+   {
+      while ((p_trig < trig_end) && ((int24_t)p_trig->_data_8_24._data_24_lsb <= pc))
+      {
+         actions |= p_trig->_data_8_24._data_8_msb;
+         trig_last._data_32 = p_trig->_data_32;
+         p_trig += 1;
+      }
+   }
+   trig_next = p_trig;
+
+   if (actions & QD_TRIGGER_LINK)
+   {
+      link = trig_link_chan;
+   }
+   if (actions & (QD_TRIGGER_INTERRUPT + QD_TRIGGER_DMA))
+   {
+      tmp_chan = chan;                                     // Interrupt and DMA request on primary channel
+      chan = phase_A_chan;
+      if (actions & QD_TRIGGER_INTERRUPT)
+      {
+         SetChannelInterrupt();
+      }
+      if (actions & QD_TRIGGER_DMA)
       {
-         Clear(flag1);                                       // The next edge must be rising edge
-         pins &= ~QD_PIN_B;                                  // Clear secondary channel pin_B bit of pins parameter
+         SetDataTransferInterrupt();
       }
+      chan = tmp_chan;
    }
-   pc=0;                                                   // Set Position Counter to 0.
-   mode_current=QD_MODE_SLOW;                              // Set mode_current to slow
-   period_accum._data_32 = 0;
-   flag0=0;                                                // Slow/Normal mode.
-   
-   found_leading_edge = FALSE;
-   erta = last_leading_edge + 0x800000;
-   WriteErtAToMatchAAndEnable();
-   
-   EnableEventHandling();                                  // Enable channel.
 }
 
-/**********************************************
-* Latch the error flags and clear the working copy
-**********************************************/
-_eTPU_thread QD::LatchAndClearErrors(_eTPU_matches_enabled)
-{
-   error_flags_latched = error_flags;
-   error_flags = 0;
-}
-   
 /************************************************************
-* Falling Edge in Slow/Normal Mode
+* Position trigger table - find the next target above pc
+* after a table swap or a pc reset, without triggering
 ************************************************************/
-_eTPU_thread QD::SlowNormalFallingEdge(_eTPU_matches_enabled)
+void QD::TriggerSeek()
 {
-   OnTransA(LowHigh);                                       // Pin is configured to detect low high transitions.
-   if(QD_CHANNEL_PRIMARY)                                   // for primary channel
-   {   
-      Clear(flag1);                                          // The next edge must be rising edge
-      pins &= ~QD_PIN_A;                                     // Clear primary channel pin_A bit of pins parameter
-   }
-   else                                                     // for secondary channel
+   union Data_32_or_8_24 *p_trig;
+
+   p_trig = trig_start;
+   while ((p_trig < trig_end) && ((int24_t)p_trig->_data_8_24._data_24_lsb <= pc))
    {
-      Clear(flag1);                                          // The next edge must be rising edge
-      pins &= ~QD_PIN_B;                                     // Clear secondary channel pin_B bit of pins parameter
+      p_trig += 1;
    }
-   SlowNormalCommon();
+   trig_next = p_trig;
 }
+#endif
 
 /************************************************************
-* Rising Edge in Slow/Normal Mode
+* Read both input pins into pins
 ************************************************************/
-_eTPU_thread QD::SlowNormalModeRisingEdge(_eTPU_matches_enabled)
+void QD::ReadPins()
 {
-     OnTransA(HighLow);                                       // Pin is configured to detect high low transitions.   
-     if(QD_CHANNEL_PRIMARY)                                   // for primary channel                                 
-     {                                                                                                               
-       Set(flag1);                                            // The next edge must be falling edge
-       pins |= QD_PIN_A;                                      // Set primary channel pin_A bit of pins parameter
-     }                                                                                                               
-     else                                                     // for secondary channel                               
-     {                                                                                                               
-       Set(flag1);                                            // The next edge must be falling edge
-       pins |= QD_PIN_B;                                      // Set secondary channel pin_B bit of pins parameter
-     }
-     SlowNormalCommon();
+   uint8_t tmp_chan;
+
+   tmp_chan = chan;
+   pins &= QD_CONFIGURATION;
+   chan = phase_A_chan;
+   if(CurrentInputPin==1)
+      pins |= QD_PIN_A;
+   chan = phase_B_chan;
+   if(CurrentInputPin==1)
+      pins |= QD_PIN_B;
+   chan = tmp_chan;
 }
 
 /************************************************************
-* Common Slow/Normal Mode Processing
+* Position modulo 4 of the pins (0: A, B low, 1: A high,
+* 2: A, B high, 3: B high), it increments when the position
+* increments
 ************************************************************/
-_eTPU_fragment QD::SlowNormalCommon()
+uint8_t QD::PinState()
 {
-   if (mode_current & QD_MODE_SLOW)                         // For slow mode
+   uint8_t state;
+
+   state = 0;
+   if(pins & QD_PIN_B)
+      state = 3;
+   if(pins & QD_PIN_A)
+      state ^= 1;
+   return state;
+}
+
+/************************************************************
+* Switch to Slow Mode with both channels set up from the pin
+* states, like the initialization.
+* Returns the pins on their leading edge level.
+************************************************************/
+int8_t QD::SlowFromPins()
+{
+   uint8_t tmp_chan;
+   int8_t at_level;
+
+   QD_PROF_HIT(prof_mode_switch);
+   mode_current = QD_MODE_SLOW;
+   if (direction & QD_DIRECTION_BIT7)
    {
-      if((QD_CHANNEL_SECONDARY)^(pins & QD_PIN_A)^((pins & QD_PIN_B)>>1)) // Perform lead/lag test.
-         direction=QD_DIRECTION_INCREMENT;                   // Set direction.
-      else
-         direction=QD_DIRECTION_DECREMENT;                   // Set direction.
+      direction=QD_DIRECTION_DECREMENT;
    }
-   if (!IsTransALatched())                                  // Transition detected or detection window end?
+   else
    {
-      erta = last_edge + (period._data_8_24._data_24_lsb >> 2);                        // Estimate edge time from previous egde and period
-      error_flags |= QD_ERROR_WINDOWING;
+      direction=QD_DIRECTION_INCREMENT;
    }
-   Common();
+   ReadPins();
+   at_level = pins;                                        // Pins on their leading edge level
+   if(!(pins & QD_CONFIGURATION))
+      at_level = ~pins;
+   at_level &= QD_PIN_A + QD_PIN_B;
+   tmp_chan = chan;
+   chan = phase_A_chan;
+   if(pins & QD_PIN_A)
+      OnTransA(HighLow);
+   else
+      OnTransA(LowHigh);
+   SingleMatchSingleTransition();
+   ClearAllLatches();
+   Clear(flag0);
+   if(at_level == QD_PIN_B)
+      Set(flag1);                                          // The next phase A edge is the leading edge
+   else
+      Clear(flag1);
+   chan = phase_B_chan;
+   if(pins & QD_PIN_B)
+      OnTransA(HighLow);
+   else
+      OnTransA(LowHigh);
+   SingleMatchSingleTransition();
+   ClearAllLatches();
+   Clear(flag0);
+   if(at_level == QD_PIN_A)
+      Set(flag1);                                          // The next phase B edge is the leading edge
+   else
+      Clear(flag1);
+   chan = tmp_chan;
+   return at_level;
 }
 
 /************************************************************
-* Period Overflow detected
+* Count the edges since the last leading edge of this channel
+* (both pins on level): the other pin leaves the level first,
+* then this pin, then the other pin returns
 ************************************************************/
-_eTPU_thread QD::PeriodOverflow(_eTPU_matches_enabled)
+void QD::CountToPins(int8_t at_level)
 {
-   ClearMatchALatch();
-   period_accum._data_8_24._data_24_lsb += (erta - last_leading_edge);
-   if (CC.C)
+   int8_t pin_bit;
+   int24_t counts;
+
+   if(QD_CHANNEL_PRIMARY)
+      pin_bit = QD_PIN_A;
+   else
+      pin_bit = QD_PIN_B;
+   counts = 0;
+   if(at_level != QD_PIN_A + QD_PIN_B)
    {
-      period_accum._data_8_24._data_8_msb += 1;
+      counts = direction;
+      if(at_level != pin_bit)
+      {
+         counts += direction;
+         if(at_level != 0)
+         {
+            counts += direction;
+         }
+      }
    }
-   last_leading_edge = erta;
-   erta += 0x800000;
-   WriteErtAToMatchAAndEnable();
+   pc += counts;
+   pc_sc += counts;
+   PositionAdd(counts);
 }
 
 /************************************************************
-* FAST Mode, Edge Detected
+* Wrap extension (bits 24-31) of a TCR time. A time up to half
+* a TCR wrap after tcr_ext advances tcr_ext, counting a wrap
+* when the time is below it; an earlier time is extended from
+* tcr_ext unchanged.
 ************************************************************/
-_eTPU_thread QD::FastModeEdge(_eTPU_matches_enabled)
+uint8_t QD::TimeExt(uint24_t time)
 {
-   if (!IsTransALatched())                                 // Transition detected or detection window end?
+   if((uint24_t)(time - tcr_ext._data_8_24._data_24_lsb) <= 0x800000)
    {
-      erta = last_edge + period._data_8_24._data_24_lsb;                            // Estimate edge time from previous egde and period
-      error_flags |= QD_ERROR_WINDOWING;
+      if(time < tcr_ext._data_8_24._data_24_lsb)
+         tcr_ext._data_8_24._data_8_msb += 1;               // TCR wrapped
+      tcr_ext._data_8_24._data_24_lsb = time;
+      return tcr_ext._data_8_24._data_8_msb;
    }
-   Common();
+   if(time > tcr_ext._data_8_24._data_24_lsb)
+      return tcr_ext._data_8_24._data_8_msb - 1;            // Before the last wrap
+   return tcr_ext._data_8_24._data_8_msb;
+}
+
+#ifdef QD_STANDSTILL
+/************************************************************
+* Period overflow match at standstill - extend tcr_ext and
+* match again one TCR wrap from now
+************************************************************/
+_eTPU_fragment QD::StandstillOverflow()
+{
+   if(erta < tcr_ext._data_8_24._data_24_lsb)
+      tcr_ext._data_8_24._data_8_msb += 1;                  // TCR wrapped since the last match
+   tcr_ext._data_8_24._data_24_lsb = erta;
+   StandstillMatch();
+   erta -= 1;                                              // Equal only - one TCR wrap from now
+   WriteErtAToMatchAAndEnable();
+}
+
+/************************************************************
+* Standstill - action unit A of this channel matches equal
+* only, so that a match is serviced once per TCR wrap
+************************************************************/
+void QD::StandstillMatch()
+{
+   if(QD_TIMER_TCR1)
+      ActionUnitA( MatchTCR1, CaptureTCR1, EqualOnly);
+   else
+      ActionUnitA( MatchTCR2, CaptureTCR2, EqualOnly);
 }
 
 /************************************************************
-* Common Processing and any edge, all modes
+* First edge after standstill - the last standstill match was
+* less than a TCR wrap ago, so a lower time is one wrap on.
+* Both channels return to greater-equal matches.
 ************************************************************/
-_eTPU_fragment QD::Common()
+void QD::StandstillEnd()
 {
    uint8_t tmp_chan;
-   uint24_t tmp_period;
 
-   DisableMatchDetection();                                         // end any matches in progress
+   if(erta < tcr_ext._data_8_24._data_24_lsb)
+      tcr_ext._data_8_24._data_8_msb += 1;                  // TCR wrapped
+   tcr_ext._data_8_24._data_24_lsb = erta;
+   tmp_chan = chan;
+   chan = phase_A_chan;
+   DisableMatchDetection();
+   ClearMatchALatch();
+   if(QD_TIMER_TCR1)
+      ActionUnitA( MatchTCR1, CaptureTCR1, GreaterEqual);
+   else
+      ActionUnitA( MatchTCR2, CaptureTCR2, GreaterEqual);
+   chan = phase_B_chan;
+   DisableMatchDetection();
+   ClearMatchALatch();
+   if(QD_TIMER_TCR1)
+      ActionUnitA( MatchTCR1, CaptureTCR1, GreaterEqual);
+   else
+      ActionUnitA( MatchTCR2, CaptureTCR2, GreaterEqual);
+   chan = tmp_chan;
+}
+#endif
 
-   last_edge = erta;
-   pc+=direction;                                          // Decrement or Increment the PC.
-   pc_sc+=direction;                                       // Decrement or Increment the PC_SC.
+/************************************************************
+* Add counts to the 48-bit absolute position, with the carry
+* (borrow) from position_lo to position_hi
+************************************************************/
+void QD::PositionAdd(int24_t counts)
+{
+   uint24_t tmp_lo;
 
-   if((options & QD_PC_INTERRUPT_ENABLED) &&
-      ((pc==pc_interrupt1)||(pc==pc_interrupt2)))
-      SetChannelInterrupt();                                // Generate interrupt each time when pc=pc_interrupt1 or pc=pc_interrupt2
+   tmp_lo = position_lo;
+   position_lo += counts;
+   if(counts < 0)
+   {
+      if(position_lo > tmp_lo)
+         position_hi -= 1;                                  // Borrow
+   }
+   else
+   {
+      if(position_lo < tmp_lo)
+         position_hi += 1;                                  // Carry
+   }
+}
+
+/************************************************************
+* Illegal transition check in Slow Mode - the pin of the other
+* channel must still be on the level of its last edge
+************************************************************/
+void QD::IllegalCheck(int8_t pin_bit)
+{
+   uint8_t tmp_chan;
+   int8_t other_bit;
+   _Bool illegal;
+
+   illegal = FALSE;
+   other_bit = pin_bit ^ (QD_PIN_A+QD_PIN_B);
+   tmp_chan = chan;
+   if(pin_bit == QD_PIN_A)
+      chan = phase_B_chan;
+   else
+      chan = phase_A_chan;
+   if(pins & other_bit)
+   {
+      if(CurrentInputPin==0)
+         illegal = TRUE;
+   }
+   else if(CurrentInputPin==1)
+      illegal = TRUE;
+   chan = tmp_chan;
+   if (illegal)                                            // Both pins changed between two services
+   {
+      error_flags |= QD_ERROR_ILLEGAL;
+#ifdef QD_ERROR_COUNTERS
+      if (illegal_count < QD_ERROR_COUNT_MAX)
+         illegal_count += 1;
+#endif
+   }
+}
+
+/************************************************************
+* Leading edge processing, any mode: pc_max, period, period
+* average, edge ring
+* Returns the 24-bit period.
+************************************************************/
+uint24_t QD::LeadingEdgePeriod()
+{
+#ifdef QD_EDGE_RING
+   uint8_t tmp_chan;
+#endif
+   uint24_t tmp_period;
+#if defined(QD_EDGE_RING) || defined(QD_PERIOD_AVG)
+   union Data_32_or_8_24 *p_rec;
+#endif
 
-   if((pins==(QD_PIN_A+QD_PIN_B+QD_CONFIGURATION))||
-      (pins==0x0))                                         // If the current edge is the leading edge
+   if(options & QD_PC_MAX_ENABLED)                         // If pc_max is enabled
    {
-      if(options & QD_PC_MAX_ENABLED)                       // If pc_max is enabled
+      if(__abs(pc)>=pc_max)
       {
-         if(__abs(pc)>=pc_max)
-         {
-            pc=0;                                             // Reset PC
-         }
+         pc=0;                                              // Reset PC
+#ifdef QD_TRIGGER_TABLE
+         if(options & QD_TRIGGER_TABLE_ENABLED)
+            TriggerSeek();
+#endif
       }
-      tmp_period = period_accum._data_8_24._data_24_lsb += (erta - last_leading_edge);               // Period between two leading edges
-      if (CC.C)  // set if 24 bits of period overflows
+   }
+   tmp_period = period_accum._data_8_24._data_24_lsb += (erta - last_leading_edge);               // Period between two leading edges
+   if (CC.C)  // set if 24 bits of period overflows
+   {
+       period_accum._data_8_24._data_8_msb += 1;
+   }
+   period._data_32 = period_accum._data_32;
+   period_accum._data_32 = 0;
+   last_leading_edge = erta; 
+   last_leading_edge_ext = TimeExt(erta);
+#ifdef QD_PERIOD_AVG
+   if (options & QD_PERIOD_AVG_ENABLED)                    // Replace the oldest period of the average
+   {
+      period_sum._data_8_24._data_24_lsb += period._data_8_24._data_24_lsb;
+      if (CC.C)
       {
-          period_accum._data_8_24._data_8_msb += 1;
+         period_sum._data_8_24._data_8_msb += 1;
       }
-      period._data_32 = period_accum._data_32;
-      period_accum._data_32 = 0;
-      last_leading_edge = erta; 
-      if (!found_leading_edge)
+      period_sum._data_8_24._data_8_msb += period._data_8_24._data_8_msb;
+      if (period_sum._data_8_24._data_24_lsb < avg_wr->_data_8_24._data_24_lsb)
       {
-         found_leading_edge = TRUE;
-         mode_current |= QD_LEADING_EDGE_INDICATION;          // Set leading edge indication bit
-         goto QD_FINAL;
+         period_sum._data_8_24._data_8_msb -= 1;      // borrow
       }
-      
-      if (mode_current & QD_MODE_SLOW)                      // For slow mode
+      period_sum._data_8_24._data_24_lsb -= avg_wr->_data_8_24._data_24_lsb;
+      period_sum._data_8_24._data_8_msb -= avg_wr->_data_8_24._data_8_msb;
+      avg_wr->_data_32 = period._data_32;
+      p_rec = avg_wr + 1;
+      if (p_rec >= avg_end)
       {
-         if(tmp_period < slow_normal_threshold && period._data_8_24._data_8_msb == 0)                  // Exit Slow mode and enter Normal mode.
-         {
-            mode_current=QD_MODE_NORMAL;                       // Set mode_current to normal.
-            tmp_period >>= 1; // windowing based upon half period
-         }
+         p_rec = avg_start;
       }
-      else if (mode_current & QD_MODE_NORMAL)               // For normal mode
+      avg_wr = p_rec;
+      period_avg._data_8_24._data_24_lsb = (period_sum._data_8_24._data_24_lsb >> avg_shift) +
+                                           ((uint24_t)period_sum._data_8_24._data_8_msb << (24 - avg_shift));
+      period_avg._data_8_24._data_8_msb = period_sum._data_8_24._data_8_msb >> avg_shift;
+   }
+#endif
+#ifdef QD_EDGE_RING
+   if (options & QD_EDGE_RING_ENABLED)                     // Append a record to the edge ring
+   {
+      p_rec = ring_wr + 2;
+      if (p_rec >= ring_end)
       {
-         if(tmp_period < normal_fast_threshold)                  // Exit Normal mode and enter Fast mode
-         {
-            mode_current=QD_MODE_FAST;                        // Set mode_current to fast.
-            if (direction & QD_DIRECTION_BIT7)                // If direction is negative
-            {
-               direction=QD_DIRECTION_DECREMENT_FAST;          // Direction = -4
-            }
-            else
-            {
-               direction=QD_DIRECTION_INCREMENT_FAST;          // Direction = 4
-            }
-            Set(flag0);                                       // Set Fast mode
-            /* According to the configuration detect high_low/low_high edges */
-            if(pins & QD_CONFIGURATION)
-            {
-               OnTransA(LowHigh);                              // Pin is configured to detect low high transitions.
-               Clear(flag1);                                   // The next edge must be rising edge
-            }
-            else
-            {
-               OnTransA(HighLow);                              // Pin is configured to detect high low transitions.
-               Set(flag1);                                     // The next edge must be falling edge
-            }
-            tmp_chan = chan;
-            if(QD_CHANNEL_PRIMARY)                            // for primary channel
-            {   
-               chan = phase_B_chan;
-            }
-            else                                              // for secondary channel
-            {
-               chan = phase_A_chan; 
-            }
-            OnTransA(NoDetect);                               // Pin is configured to detect no transitions.
-            DisableMatchDetection();                          // Prevent from end-window match
-            ClearAllLatches();
-            chan = tmp_chan;
-         }
-         else if(tmp_period > normal_slow_threshold)             // Exit Normal mode and enter Slow mode
-         {
-            mode_current = (QD_LEADING_EDGE_INDICATION + QD_MODE_SLOW);   // Set mode_current to slow.
-            goto QD_FINAL;
-         }
-         else
-         {
-            tmp_period >>= 1; // windowing based upon half period when in NORMAL mode
-         }
+         p_rec = ring_start;
       }
-      else if (mode_current & QD_MODE_FAST)                 // For Fast mode
+      if (p_rec == ring_rd)                                // Ring full - drop the record
       {
-         if(tmp_period > fast_normal_threshold)                  // Exit Fast mode and enter Normal mode
-         {
-            /* Set mode_current to normal and 
-               set the QD_FAST_TO_NORMAL_SWITCH bit to indicate 
-               the edge in which the mode swithes from Fast to Normal */
-            mode_current= (QD_FAST_TO_NORMAL_SWITCH + QD_MODE_NORMAL);
-
-            if (direction & QD_DIRECTION_BIT7)                // If direction is negative
-            {
-               direction=QD_DIRECTION_DECREMENT;               // Direction = -1
-            }
-            else
-            {
-               direction=QD_DIRECTION_INCREMENT;               // Direction = 1
-            }
-            Clear(flag0);                                          // Set SLOW/NORMAL mode
-            /* According to the configuration detect high_low/low_high edges */
-            if(pins & QD_CONFIGURATION)
-            {
-               OnTransA(HighLow);                              // Pin is configured to detect high low transitions.
-               Set(flag1);                                     // The next edge must be falling edge
-            }
-            else
-            {
-               OnTransA(LowHigh);                              // Pin is configured to detect low high transitions.
-               Clear(flag1);                                   // The next edge must be rising edge
-            }
-            pc += direction;                                  // Decrement or Increment the PC.    
-            pc_sc += direction;                               // Decrement or Increment the PC_SC. 
-            tmp_chan = chan;
-            if(QD_CHANNEL_PRIMARY)                            // for primary channel
-            {   
-               chan = phase_B_chan;                                         // Switch to secondary channel
-            }
-            else                                              // for secondary channel
-            {
-               chan = phase_A_chan;                                         // Switch to primary channel
-            }
-            /* According to the configuration detect high_low/low_high edges */
-            if(pins & QD_CONFIGURATION)
-            {
-               OnTransA(LowHigh);                              // Pin is configured to detect low high transitions.
-               Clear(flag1);                                   // The next edge must be rising edge
-            }
-            else
-            {
-               OnTransA(HighLow);                              // Pin is configured to detect high low transitions.
-               Set(flag1);                                     // The next edge must be falling edge
-            }
-            SingleMatchSingleTransition();                      // Channel mode: Both Match Single Transition.
-            chan = tmp_chan;
-            tmp_period >>= 1; // windowing based upon half period when in NORMAL mode
-         }
+         ring_overflow += 1;
       }
-      mode_current |= QD_LEADING_EDGE_INDICATION;          // Set leading edge indication bit
-   }
-   else
-   {
-      /* Clear leading edge indication bit and Fast to Normal Switch indication bit */
-      mode_current &= (~(QD_LEADING_EDGE_INDICATION | QD_FAST_TO_NORMAL_SWITCH));
-      tmp_period = period._data_8_24._data_24_lsb;
-      if (mode_current & QD_MODE_NORMAL)
-          tmp_period >>= 1; // windowing based upon half period when in NORMAL mode
-   }
-
-   erta = last_edge;  // just in case erta is incorrect after channel changes etc.
-   
-   if(((options & QD_WINDOWING_DISABLED)==0) && ((mode_current & QD_MODE_SLOW)==0))  // For Fast or Normal mode
-   {
-      Match2SingleTransition();                           // Channel mode: Match B Single Transition
-      ertb = erta + tmp_period;                               // Setup next window end
-      ertb += mulir(tmp_period, ratio2);
-      /* When the transition did not come (Match B is latched) 
-         let the window opened, else setup next window beginning */
-      if(!(IsLatchedMatchB()))
+      else
       {
-         erta += mulir(tmp_period, ratio1);                    // Setup next window beginning
+         ring_wr->_data_8_24._data_8_msb = direction;
+         ring_wr->_data_8_24._data_24_lsb = erta;
+         ring_wr[1]._data_8_24._data_8_msb = ring_seq;
+         ring_wr[1]._data_8_24._data_24_lsb = pc;
+         ring_wr = p_rec;
+         tmp_chan = chan;                                  // Request DMA transfer on primary channel
+         chan = phase_A_chan;
+         SetDataTransferInterrupt();
+         chan = tmp_chan;
       }
-      ClearAllLatches();                                    // Negate all pending events.
-      WriteErtAToMatchAAndEnable();
-      WriteErtBToMatchBAndEnable();
-   }
-   else
-   {
-QD_FINAL:
-      SingleMatchSingleTransition();                        // Channel mode: Single Match Single Transition when not windowing.
-      ClearAllLatches();                                    // Negate all pending events.
-   }
-
-   if (mode_current & QD_MODE_SLOW)
-   {
-      erta += 0x800000;                               // start up period overflow match
-      WriteErtAToMatchAAndEnable();
+      ring_seq += 1;
    }
+#endif
+   return tmp_period;
 }
 
 
@@ -764,6 +2251,7 @@ QD_FINAL:
 **********************************************/
 _eTPU_thread QD::Home_Init(_eTPU_matches_disabled)
 {
+   QD_PROF_HIT(prof_init);
    if(QD_HOME_DETECT_ANY)                                 // FM==1x
    {
       OnTransA(AnyTrans);                                 // Pin is configured to detect any transition.
@@ -792,9 +2280,12 @@ _eTPU_thread QD::Home_Init(_eTPU_matches_disabled)
 **********************************************/
 _eTPU_thread QD::Home_Transition(_eTPU_matches_enabled)
 {
+   QD_PROF_HIT(prof_index_home);
    ClearTransLatch();                                     // Clear the transition latch to enable further transition detection.
+   seq += 1;                                              // Start of QD outputs update.
    rc=0;                                                  // Reset Revolution Counter to 0.
    pc=0;                                                  // Reset Position Counter to 0.
+   seq += 1;                                              // End of QD outputs update.
 }
 
 #endif
@@ -807,6 +2298,10 @@ _eTPU_thread QD::Home_Transition(_eTPU_matches_enabled)
 *
 * DESCRIPTION: Monitors an input signal that indicates each revolution 
 *              of the motion system. 
+*              The TCR1 time of the first transition of each index pulse
+*              is captured and the time between two pulses is published
+*              in rev_period/rev_period_ext. Match A is scheduled every
+*              0x800000 TCR1 ticks to extend the measurement beyond 24 bits.
 * FUNCTION PARAMETERS: same as for all QD functions
 *
 * CHANNEL FLAG USAGE: 
@@ -820,6 +2315,7 @@ _eTPU_thread QD::Home_Transition(_eTPU_matches_enabled)
 **********************************************/
 _eTPU_thread QD::Index_Init(_eTPU_matches_disabled)
 {
+   QD_PROF_HIT(prof_init);
    OnTransA(AnyTrans);                                    // Pin is configured to detect any transition.
    EitherMatchNonBlockingSingleTransition();              // Channel mode: Non Blocking Single Transition.
    ActionUnitA( MatchTCR1, CaptureTCR1, GreaterEqual);    // TCR1 clock selected.
@@ -840,8 +2336,70 @@ _eTPU_thread QD::Index_Init(_eTPU_matches_disabled)
 
    rc=0;                                                  // Reset Revolution Counter to 0.
 
+   rev_period._data_32 = 0;                               // No revolution period measured yet.
+   rev_period_ext = 0;
+   rev_accum._data_32 = 0;
+   rev_accum_ext = 0;
+   index_seen = FALSE;
+   last_index = tcr1;
+   erta = last_index + 0x800000;                          // start up revolution period overflow match
+   WriteErtAToMatchAAndEnable();
+
    EnableEventHandling();                                 // Enable channel.
 }
+
+/**********************************************
+* Revolution period overflow - the time from the
+* last index pulse exceeds 0x800000 TCR1 ticks.
+**********************************************/
+_eTPU_thread QD::Index_PeriodOverflow(_eTPU_matches_enabled)
+{
+   QD_PROF_HIT(prof_index_home);
+   ClearMatchALatch();
+   RevolutionAccum(0x800000);                             // The match time is known - erta may hold a transition capture.
+   last_index += 0x800000;
+   erta = last_index + 0x800000;
+   WriteErtAToMatchAAndEnable();
+}
+
+/**********************************************
+* Add ticks to the 40-bit revolution period accumulator
+**********************************************/
+void QD::RevolutionAccum(uint24_t ticks)
+{
+   rev_accum._data_8_24._data_24_lsb += ticks;
+   if (CC.C)
+   {
+      rev_accum._data_8_24._data_8_msb += 1;
+      if (rev_accum._data_8_24._data_8_msb == 0)
+      {
+         rev_accum_ext += 1;
+      }
+   }
+}
+
+/**********************************************
+* Revolution period on the first transition
+* of an index pulse (erta)
+**********************************************/
+void QD::RevolutionPeriod()
+{
+   ClearMatchALatch();                                    // A pending overflow is covered by erta - last_index.
+   RevolutionAccum(erta - last_index);
+   last_index = erta;
+   if (index_seen)
+   {
+      seq += 1;                                           // Start of QD outputs update.
+      rev_period._data_32 = rev_accum._data_32;
+      rev_period_ext = rev_accum_ext;
+      seq += 1;                                           // End of QD outputs update.
+   }
+   index_seen = TRUE;
+   rev_accum._data_32 = 0;
+   rev_accum_ext = 0;
+   erta += 0x800000;                                      // Restart the overflow match from this pulse.
+   WriteErtAToMatchAAndEnable();
+}
    
 /**********************************************
 ///////////// First Transition ////////////////
@@ -851,8 +2409,22 @@ _eTPU_thread QD::Index_Init(_eTPU_matches_disabled)
 **********************************************/
 _eTPU_thread QD::Index_FirstTransition(_eTPU_matches_enabled)
 {
+   QD_PROF_HIT(prof_index_home);
    ClearTransLatch();                                     // Clear the transition latch to enable further transition detection.
 
+   /* A transition serviced together with a pending link may be the
+      second one - only the first transition times the revolution. */
+   if(QD_INDEX_PULSE_POSITIVE)
+   {
+      if(CurrentInputPin==1)
+         RevolutionPeriod();
+   }
+   else
+   {
+      if(CurrentInputPin==0)
+         RevolutionPeriod();
+   }
+
    Index_FirstTransitionCommon();
 }
 
@@ -861,14 +2433,19 @@ _eTPU_thread QD::Index_FirstTransition(_eTPU_matches_enabled)
 **********************************************/
 _eTPU_fragment QD::Index_FirstTransitionCommon()
 {
+   uint24_t tmp_edges;
+
    /* The first transition could not come before leading edge, 
-      wait till the leading edge is reached */
-   if (!(mode_current & QD_LEADING_EDGE_INDICATION))
+      wait till the leading edge is reached. In TCR2 mode the QD
+      channels detect no transitions, so there is no leading edge
+      to wait for. */
+   if (!(mode_current & (QD_LEADING_EDGE_INDICATION | QD_MODE_TCR2)))
    {
       link=chan;                                          // Send link to self - wait for state after leading edge
    }
    else
    {
+      seq += 1;                                           // Start of QD outputs update.
       if(QD_INDEX_PC_RESET)                               // FM==1x
       {
          if(mode_current & QD_FAST_TO_NORMAL_SWITCH)
@@ -876,10 +2453,26 @@ _eTPU_fragment QD::Index_FirstTransitionCommon()
             pc=direction;                    // In case the first index transition come at the same time as the leading edge in which the mode swithes from Fast to Normal
                                              // (the next QD edge after this is not scheduled so the pc could not be reset to 0)
          }
+         else if(mode_current & QD_MODE_TCR2)
+         {
+            tmp_edges = (tcr2 - tcr2_base) << 1;           // Edges since the last reconcile, added by the next one
+            if(direction & QD_DIRECTION_BIT7)
+            {
+               pc=tmp_edges;
+            }
+            else
+            {
+               pc=-tmp_edges;
+            }
+         }
          else
          {
             pc=0;                            // Reset Position Counter to 0. 
          }                
+#ifdef QD_TRIGGER_TABLE
+         if(options & QD_TRIGGER_TABLE_ENABLED)
+            TriggerSeek();
+#endif
       }
          
       /* Decrement revolution counter when direction < 0, 
@@ -918,6 +2511,7 @@ _eTPU_fragment QD::Index_FirstTransitionCommon()
          }
          ClearAllLatches();
       }
+      seq += 1;                                           // End of QD outputs update.
    }
 }
    
@@ -927,6 +2521,7 @@ _eTPU_fragment QD::Index_FirstTransitionCommon()
 **********************************************/
 _eTPU_thread QD::Index_FirstTransitionLink(_eTPU_matches_enabled)
 {
+   QD_PROF_HIT(prof_index_home);
    ClearLinkServiceRequestEvent();
 
    Index_FirstTransitionCommon();
@@ -940,6 +2535,7 @@ _eTPU_thread QD::Index_FirstTransitionLink(_eTPU_matches_enabled)
 **********************************************/
 _eTPU_thread QD::Index_SecondTransition(_eTPU_matches_enabled)
 {
+   QD_PROF_HIT(prof_index_home);
    ClearTransLatch();                                     // Clear the transition latch to enable further transition detection.
       
    /* If transition is first after init(last_direction==0)=> skip the event.
@@ -964,6 +2560,7 @@ _eTPU_fragment QD::Index_SecondTransitionCommon()
       {
          /* Decrement revolution counter when direction < 0, 
             increment revolution counter when direction > 0 */
+         seq += 1;                                     // Start of QD outputs update.
          if(direction & QD_DIRECTION_BIT7)
          {
             rc--;
@@ -972,6 +2569,7 @@ _eTPU_fragment QD::Index_SecondTransitionCommon()
          {
             rc++;
          }
+         seq += 1;                                     // End of QD outputs update.
       }
    }
    else
@@ -986,6 +2584,7 @@ _eTPU_fragment QD::Index_SecondTransitionCommon()
 **********************************************/
 _eTPU_thread QD::Index_SecondTransitionLink(_eTPU_matches_enabled)
 {
+   QD_PROF_HIT(prof_index_home);
    ClearLinkServiceRequestEvent();
 
    Index_SecondTransitionCommon();
@@ -1067,6 +2666,76 @@ _eTPU_thread QD::Index_SecondTransitionLink(_eTPU_matches_enabled)
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PHASE_B_CHAN_OFFSET       ) ::ETPUlocation (QD, phase_B_chan) );
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ERROR_FLAGS_OFFSET        ) ::ETPUlocation (QD, error_flags) );
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_LATCHED_ERROR_FLAGS_OFFSET) ::ETPUlocation (QD, error_flags_latched) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_SEQ_OFFSET                ) ::ETPUlocation (QD, seq) );
+#ifdef QD_EDGE_RING
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_RING_START_OFFSET         ) ::ETPUlocation (QD, ring_start) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_RING_END_OFFSET           ) ::ETPUlocation (QD, ring_end) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_RING_WR_OFFSET            ) ::ETPUlocation (QD, ring_wr) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_RING_RD_OFFSET            ) ::ETPUlocation (QD, ring_rd) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_RING_OVERFLOW_OFFSET      ) ::ETPUlocation (QD, ring_overflow) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_RING_SEQ_OFFSET           ) ::ETPUlocation (QD, ring_seq) );
+#endif
+#ifdef QD_EDGE_HISTORY
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_HIST_START_OFFSET         ) ::ETPUlocation (QD, hist_start) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_HIST_END_OFFSET           ) ::ETPUlocation (QD, hist_end) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_HIST_WR_OFFSET            ) ::ETPUlocation (QD, hist_wr) );
+#endif
+#ifdef QD_PERIOD_AVG
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PERIOD_AVG_OFFSET         ) ::ETPUlocation (QD, period_avg) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PERIOD_SUM_OFFSET         ) ::ETPUlocation (QD, period_sum) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_AVG_START_OFFSET          ) ::ETPUlocation (QD, avg_start) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_AVG_END_OFFSET            ) ::ETPUlocation (QD, avg_end) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_AVG_WR_OFFSET             ) ::ETPUlocation (QD, avg_wr) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_AVG_SHIFT_OFFSET          ) ::ETPUlocation (QD, avg_shift) );
+#endif
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_REV_PERIOD_OFFSET         ) ::ETPUlocation (QD, rev_period) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_REV_PERIOD_EXT_OFFSET     ) ::ETPUlocation (QD, rev_period_ext) );
+#ifdef QD_TRIGGER_TABLE
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIG_START_OFFSET         ) ::ETPUlocation (QD, trig_start) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIG_END_OFFSET           ) ::ETPUlocation (QD, trig_end) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIG_NEXT_OFFSET          ) ::ETPUlocation (QD, trig_next) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIG_NEW_START_OFFSET     ) ::ETPUlocation (QD, trig_new_start) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIG_NEW_END_OFFSET       ) ::ETPUlocation (QD, trig_new_end) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIG_LAST_OFFSET          ) ::ETPUlocation (QD, trig_last) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIG_LINK_CHAN_OFFSET     ) ::ETPUlocation (QD, trig_link_chan) );
+#endif
+#ifdef QD_PC_IRQ_COALESCING
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET    ) ::ETPUlocation (QD, irq_min_interval) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_IRQ_SUPPRESSED_OFFSET      ) ::ETPUlocation (QD, irq_suppressed) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_IRQ_HYSTERESIS_OFFSET      ) ::ETPUlocation (QD, irq_hysteresis) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_IRQ_REV_DIV_OFFSET         ) ::ETPUlocation (QD, irq_rev_div) );
+#endif
+#ifdef QD_STANDSTILL
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_STANDSTILL_TIMEOUT_OFFSET  ) ::ETPUlocation (QD, standstill_timeout) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_STANDSTILL_OFFSET          ) ::ETPUlocation (QD, standstill) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_STANDSTILL_IRQ_OFFSET      ) ::ETPUlocation (QD, standstill_irq) );
+#endif
+#ifdef QD_FAST_REVERSAL
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_FAST_REVERSAL_OFFSET       ) ::ETPUlocation (QD, fast_reversal) );
+#endif
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_FAST_ULTRA_THR_OFFSET      ) ::ETPUlocation (QD, fast_ultra_threshold) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ULTRA_FAST_THR_OFFSET      ) ::ETPUlocation (QD, ultra_fast_threshold) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_FAST_TCR2_THR_OFFSET       ) ::ETPUlocation (QD, fast_tcr2_threshold) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TCR2_FAST_THR_OFFSET       ) ::ETPUlocation (QD, tcr2_fast_threshold) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TCR2_INTERVAL_OFFSET       ) ::ETPUlocation (QD, tcr2_interval) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_POSITION_LO_OFFSET         ) ::ETPUlocation (QD, position_lo) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_POSITION_HI_OFFSET         ) ::ETPUlocation (QD, position_hi) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TCR_EXT_OFFSET             ) ::ETPUlocation (QD, tcr_ext) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_LAST_LEADING_EDGE_EXT_OFFSET ) ::ETPUlocation (QD, last_leading_edge_ext) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_LAST_EDGE_EXT_OFFSET       ) ::ETPUlocation (QD, last_edge_ext) );
+#ifdef QD_ERROR_COUNTERS
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ILLEGAL_COUNT_OFFSET       ) ::ETPUlocation (QD, illegal_count) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_WINDOW_COUNT_OFFSET        ) ::ETPUlocation (QD, window_count) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_SPURIOUS_COUNT_OFFSET      ) ::ETPUlocation (QD, spurious_count) );
+#endif
+#ifdef QD_PROFILING
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PROF_INIT_OFFSET           ) ::ETPUlocation (QD, prof_init) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET    ) ::ETPUlocation (QD, prof_slow_normal) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PROF_FAST_OFFSET           ) ::ETPUlocation (QD, prof_fast) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PROF_OVERFLOW_OFFSET       ) ::ETPUlocation (QD, prof_overflow) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PROF_INDEX_HOME_OFFSET     ) ::ETPUlocation (QD, prof_index_home) );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET    ) ::ETPUlocation (QD, prof_mode_switch) );
+#endif
 #pragma write h, ( );
 #pragma write h, (/****************************************************************);
 #pragma write h, (* Value Definitions. );
@@ -1087,6 +2756,18 @@ _eTPU_thread QD::Index_SecondTransitionLink(_eTPU_matches_enabled)
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PC_MAX_ENABLED            ) QD_PC_MAX_ENABLED );
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PC_INTERRUPT_ENABLED      ) QD_PC_INTERRUPT_ENABLED );
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_WINDOWING_DISABLED        ) QD_WINDOWING_DISABLED );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_EDGE_RING_ENABLED         ) QD_EDGE_RING_ENABLED );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_EDGE_HISTORY_ENABLED      ) QD_EDGE_HISTORY_ENABLED );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PERIOD_AVG_ENABLED        ) QD_PERIOD_AVG_ENABLED );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIGGER_TABLE_ENABLED     ) QD_TRIGGER_TABLE_ENABLED );
+#pragma write h, ( );
+#pragma write h, (/* trigger table entry actions */ );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIGGER_INTERRUPT         ) QD_TRIGGER_INTERRUPT );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIGGER_DMA               ) QD_TRIGGER_DMA );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_TRIGGER_LINK              ) QD_TRIGGER_LINK );
+#pragma write h, ( );
+#pragma write h, (/* period after standstill */ );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PERIOD_STANDSTILL         ) QD_PERIOD_STANDSTILL );
 #pragma write h, ( );
 #pragma write h, (/* pins bits */ );
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_PINS_PIN_A                ) QD_PIN_A );
@@ -1095,6 +2776,10 @@ _eTPU_thread QD::Index_SecondTransitionLink(_eTPU_matches_enabled)
 #pragma write h, ( );
 #pragma write h, (/* error bits */ );
 #pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ERROR_WINDOWING           ) QD_ERROR_WINDOWING );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ERROR_REVERSAL            ) QD_ERROR_REVERSAL );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ERROR_ILLEGAL             ) QD_ERROR_ILLEGAL );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ERROR_SPURIOUS            ) QD_ERROR_SPURIOUS );
+#pragma write h, (::ETPUliteral(#define FS_ETPU_QD_ERROR_COUNT_MAX           ) QD_ERROR_COUNT_MAX );
 #pragma write h, ( );
 #pragma write h, (#endif);
 
@@ -22,14 +22,99 @@
 #include "etpu_auto_api.h"
 #include "etpu_eqd.h"            /* eTPU EQD API */
 
-extern uint32_t fs_etpu_data_ram_start;
-extern uint32_t fs_etpu_data_ram_ext;
+/* Conversions between pointers and the uint32_t DATA RAM addresses of the
+   eTPU utilities. unsigned long has the size of a pointer on the 32-bit
+   targets as well as on 64-bit (LP64) hosts. */
+#define FS_ETPU_QD_PTR_TO_ADDR(p)  ((uint32_t)(unsigned long)(p))
+#define FS_ETPU_QD_ADDR_TO_PTR(a)  ((uint32_t*)(unsigned long)(a))
 
 /*******************************************************************************
-*FUNCTION     : fs_etpu_eqd_init
-*PURPOSE      : To initialize an eTPU channels to implement QD.
+*FUNCTION     : fs_etpu_eqd_instance_clear
+*PURPOSE      : To clear the host side state of a QD instance - statistics,
+*               allocated buffers, the reciprocal cache and the alignment.
+*******************************************************************************/
+static void fs_etpu_eqd_instance_clear(struct eqd_instance_t *p_instance)
+{
+   p_instance->seq_retries = 0;
+   p_instance->edge_ring = 0;
+   p_instance->edge_ring_size = 0;
+   p_instance->edge_hist = 0;
+   p_instance->edge_hist_size = 0;
+   p_instance->period_avg_buf = 0;
+   p_instance->trig_buf = 0;
+   p_instance->trig_size = 0;
+   p_instance->trig_bank = 0;
+   p_instance->recip_period = 0;
+   p_instance->recip = 0;
+   p_instance->align_pending = 0;
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_resolve
+*PURPOSE      : To fill the module, primary channel and parameter base
+*               addresses of a QD instance from the channel configuration.
+*               The channel configuration register is read only once.
+*******************************************************************************/
+static void fs_etpu_eqd_resolve(ETPU_MODULE etpu_module,
+                                uint8_t channel_primary,
+                                struct eqd_instance_t *p_instance)
+{
+   volatile struct eTPU_struct * eTPU;
+   uint32_t data_ram_start;
+   uint32_t data_ram_ext;
+   uint32_t cpba_offset;
+
+   if (etpu_module == EM_AB)
+   {
+       eTPU = eTPU_AB;
+       data_ram_start = fs_etpu_data_ram_start;
+       data_ram_ext = fs_etpu_data_ram_ext;
+   }
+   else
+   {
+       eTPU = eTPU_C;
+       data_ram_start = fs_etpu_c_data_ram_start;
+       data_ram_ext = fs_etpu_c_data_ram_ext;
+   }
+
+   cpba_offset = eTPU->CHAN[channel_primary].CR.B.CPBA << 3;
+
+   p_instance->em = etpu_module;
+   p_instance->chan_primary = channel_primary;
+   p_instance->cpba = FS_ETPU_QD_ADDR_TO_PTR(data_ram_start + cpba_offset);
+   p_instance->cpba_pse = FS_ETPU_QD_ADDR_TO_PTR(data_ram_ext + cpba_offset);
+   fs_etpu_eqd_instance_clear(p_instance);
+}
+
+#if defined(FS_ETPU_QD_RING_START_OFFSET) || defined(FS_ETPU_QD_HIST_START_OFFSET) || \
+    defined(FS_ETPU_QD_PERIOD_AVG_OFFSET) || defined(FS_ETPU_QD_TRIG_START_OFFSET)
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_ram_offset
+*PURPOSE      : To get the eTPU address (offset in DATA RAM) of a block
+*               allocated by fs_etpu_malloc_ext.
+*******************************************************************************/
+static uint32_t fs_etpu_eqd_ram_offset(ETPU_MODULE etpu_module,
+                                       const uint32_t *p_block)
+{
+   if (etpu_module == EM_AB)
+      return(FS_ETPU_QD_PTR_TO_ADDR(p_block) - fs_etpu_data_ram_start);
+   else
+      return(FS_ETPU_QD_PTR_TO_ADDR(p_block) - fs_etpu_c_data_ram_start);
+}
+#endif
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_init_precomputed
+*PURPOSE      : To initialize an eTPU channels to implement QD. The mode
+*               switching thresholds are given as QD periods in TCR ticks,
+*               so no conversion is done at run time. Constant thresholds
+*               can be computed by FS_ETPU_QD_RPM_TO_PERIOD and checked by
+*               FS_ETPU_QD_RPM_TO_PERIOD_VALID at compile time.
 *INPUTS NOTES : This function has the following parameters:
 *
+*  p_instance            - This is a pointer to the QD instance structure
+*                          which is filled in. It can be used by the
+*                          fs_etpu_eqd_h_* functions afterwards.
 *  etpu_module           - Selects eTPU-AB module or eTPU-C module (only available 
 *                          on select parts)
 *  channel_primary       - This is the Primary channel number (Phase A).
@@ -68,14 +153,14 @@ extern uint32_t fs_etpu_data_ram_ext;
 *                          This parameter is optional and can be set to zero;
 *                          then the automatic Position Counter reset is not
 *                          performed.
-*  slow_normal_threshold - This is the threshold for automatic switching from
-*                          slow mode to normal mode, in [rpm].
-*  normal_slow_threshold - This is the threshold for automatic switching from
-*                          normal mode to slow mode, in [rpm].
-*  normal_fast_threshold - This is the threshold for automatic switching from
-*                          normal mode to fast mode, in [rpm].
-*  fast_normal_threshold - This is the threshold for automatic switching from
-*                          fast mode to normal mode, in [rpm].
+*  slow_normal_period    - This is the threshold for automatic switching from
+*                          slow mode to normal mode, QD period in TCR ticks.
+*  normal_slow_period    - This is the threshold for automatic switching from
+*                          normal mode to slow mode, QD period in TCR ticks.
+*  normal_fast_period    - This is the threshold for automatic switching from
+*                          normal mode to fast mode, QD period in TCR ticks.
+*  fast_normal_period    - This is the threshold for automatic switching from
+*                          fast mode to normal mode, QD period in TCR ticks.
 *                          (When all thresholds are set to zero QD function
 *                          runs in slow mode only.)
 *  window_ratio1         - This is the ratio which applies when scheduling
@@ -118,38 +203,34 @@ extern uint32_t fs_etpu_data_ram_ext;
 *                          FS_ETPU_QD_INDEX_PC_RESET.
 *                          This parameter is ignored if Index channel is not
 *                          used.
-*  etpu_tcr_freq         - This is the frequency of TCR module used by QD
-*                          channels, in [Hz].
-*  qd_pc_per_rev         - This is the number of QD Position Counter increments
-*                          per revolution.
 *
 * RETURNS NOTES: Error codes which can be returned are: FS_ETPU_ERROR_VALUE,
 *                FS_ETPU_ERROR_MALLOC
 ******************************************************************************/
-int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
-                         uint8_t   channel_primary,
-                         uint8_t   channel_secondary,
-                         uint8_t   channel_home,
-                         uint8_t   channel_index,
-                         uint8_t   signals,
-                         uint8_t   priority,
-                         uint8_t   configuration,
-                         uint8_t   timer,
-                         uint24_t  pc_max,
-                         uint24_t  slow_normal_threshold,
-                         uint24_t  normal_slow_threshold,
-                         uint24_t  normal_fast_threshold,
-                         uint24_t  fast_normal_threshold,
-                         fract24_t window_ratio1,
-                         fract24_t window_ratio2,
-                         uint8_t   home_transition,
-                         uint8_t   index_pulse,
-                         uint8_t   index_pc_reset,
-                         uint32_t  etpu_tcr_freq,
-                         uint24_t  pc_per_rev)
+int32_t fs_etpu_eqd_init_precomputed(struct eqd_instance_t *p_instance,
+                                     ETPU_MODULE etpu_module,
+                                     uint8_t   channel_primary,
+                                     uint8_t   channel_secondary,
+                                     uint8_t   channel_home,
+                                     uint8_t   channel_index,
+                                     uint8_t   signals,
+                                     uint8_t   priority,
+                                     uint8_t   configuration,
+                                     uint8_t   timer,
+                                     uint24_t  pc_max,
+                                     uint24_t  slow_normal_period,
+                                     uint24_t  normal_slow_period,
+                                     uint24_t  normal_fast_period,
+                                     uint24_t  fast_normal_period,
+                                     fract24_t window_ratio1,
+                                     fract24_t window_ratio2,
+                                     uint8_t   home_transition,
+                                     uint8_t   index_pulse,
+                                     uint8_t   index_pc_reset)
 {
    uint32_t * pba;
    uint32_t cpba_offset;
+   uint32_t data_ram_ext;
    volatile struct eTPU_struct * eTPU;
 
    uint8_t options = 0;
@@ -162,15 +243,16 @@ int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
       ((channel_secondary>31)&&(channel_secondary<64))||(channel_secondary>95)||
       (configuration>FS_ETPU_QD_CONFIGURATION_1)||
       (timer>FS_ETPU_TCR2)||
-      ((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
-       (signals==FS_ETPU_QD_PRIM_SEC_HOME))&&
-      (((channel_home>31)&&(channel_home<64))||
-       (channel_home>95)||(home_transition>FS_ETPU_QD_HOME_TRANS_ANY))||
-      ((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
-       (signals==FS_ETPU_QD_PRIM_SEC_INDEX))&&
-      (((channel_index>31)&&(channel_index<64))||
-       (channel_index>95)||(index_pulse>FS_ETPU_QD_INDEX_PULSE_NEGATIVE)||
-       (index_pc_reset>FS_ETPU_QD_INDEX_PC_RESET)))
+      (((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
+        (signals==FS_ETPU_QD_PRIM_SEC_HOME))&&
+       (((channel_home>31)&&(channel_home<64))||
+        (channel_home>95)||(home_transition>FS_ETPU_QD_HOME_TRANS_ANY)))||
+      (((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
+        (signals==FS_ETPU_QD_PRIM_SEC_INDEX))&&
+       (((channel_index>31)&&(channel_index<64))||
+        (channel_index>95)||(index_pulse>FS_ETPU_QD_INDEX_PULSE_NEGATIVE)||
+        (index_pc_reset>FS_ETPU_QD_INDEX_PC_RESET)))||
+      (p_instance == 0))
    {
       return(FS_ETPU_ERROR_VALUE);
    }
@@ -185,15 +267,31 @@ int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
    }
    if (etpu_module == EM_AB)
    {
-       cpba_offset = (uint32_t)pba - fs_etpu_data_ram_start;
+       cpba_offset = FS_ETPU_QD_PTR_TO_ADDR(pba) - fs_etpu_data_ram_start;
+       data_ram_ext = fs_etpu_data_ram_ext;
        eTPU = eTPU_AB;
    }
    else
    {
-       cpba_offset = (uint32_t)pba - fs_etpu_c_data_ram_start;
+       cpba_offset = FS_ETPU_QD_PTR_TO_ADDR(pba) - fs_etpu_c_data_ram_start;
+       data_ram_ext = fs_etpu_c_data_ram_ext;
        eTPU = eTPU_C;
    }
 
+   /****************************************
+    * Fill the instance structure.
+    ***************************************/
+   p_instance->em = etpu_module;
+   p_instance->chan_primary = channel_primary;
+   p_instance->chan_secondary = channel_secondary;
+   p_instance->chan_home = channel_home;
+   p_instance->chan_index = channel_index;
+   p_instance->signals = signals;
+   p_instance->priority = priority;
+   p_instance->cpba = pba;
+   p_instance->cpba_pse = FS_ETPU_QD_ADDR_TO_PTR(data_ram_ext + cpba_offset);
+   fs_etpu_eqd_instance_clear(p_instance);
+
    /****************************************
     * Write channel configuration registers
     * and FM (function mode) bits.
@@ -240,41 +338,6 @@ int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
    if ((window_ratio1 == 0) || (window_ratio2 == 0))
       options |= FS_ETPU_QD_WINDOWING_DISABLED;
 
-   if (pc_per_rev > 0)
-   {
-       /* prevent arithmetic overflow when high TCR frequencies are in use */
-       if (etpu_tcr_freq > 0xfffffffU / 60)
-       {
-           if (slow_normal_threshold > 0)
-               slow_normal_threshold = (uint24_t)(((etpu_tcr_freq/
-                                            (pc_per_rev*slow_normal_threshold))*60)<<2);
-           if (normal_slow_threshold > 0)
-               normal_slow_threshold = (uint24_t)(((etpu_tcr_freq/
-                                            (pc_per_rev*normal_slow_threshold))*60)<<2);
-           if (normal_fast_threshold > 0)
-               normal_fast_threshold = (uint24_t)(((etpu_tcr_freq/
-                                            (pc_per_rev*normal_fast_threshold))*60)<<2);
-           if (fast_normal_threshold > 0)
-               fast_normal_threshold = (uint24_t)(((etpu_tcr_freq/
-                                            (pc_per_rev*fast_normal_threshold))*60)<<2);
-       }
-       else
-       {
-           if (slow_normal_threshold > 0)
-               slow_normal_threshold = (uint24_t)(((60*etpu_tcr_freq)/
-                                            (pc_per_rev*slow_normal_threshold))<<2);
-           if (normal_slow_threshold > 0)
-               normal_slow_threshold = (uint24_t)(((60*etpu_tcr_freq)/
-                                            (pc_per_rev*normal_slow_threshold))<<2);
-           if (normal_fast_threshold > 0)
-               normal_fast_threshold = (uint24_t)(((60*etpu_tcr_freq)/
-                                            (pc_per_rev*normal_fast_threshold))<<2);
-           if (fast_normal_threshold > 0)
-               fast_normal_threshold = (uint24_t)(((60*etpu_tcr_freq)/
-                                            (pc_per_rev*fast_normal_threshold))<<2);
-       }
-   }
-
    *(pba + (FS_ETPU_QD_PERIOD_OFFSET>>2)) = 0;
 
    *(pba + ((FS_ETPU_QD_PC_OFFSET - 1)>>2)) = 0;
@@ -282,21 +345,58 @@ int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
    *(pba + ((FS_ETPU_QD_PCMAX_OFFSET - 1)>>2)) = pc_max;
    *(pba + ((FS_ETPU_QD_PCINTERRUPT1_OFFSET - 1)>>2)) = 0;
    *(pba + ((FS_ETPU_QD_PCINTERRUPT2_OFFSET - 1)>>2)) = 0;
-   *(pba + ((FS_ETPU_QD_SLOW_NORMAL_THR_OFFSET - 1)>>2))= slow_normal_threshold;
-   *(pba + ((FS_ETPU_QD_NORMAL_SLOW_THR_OFFSET - 1)>>2))= normal_slow_threshold;
-   *(pba + ((FS_ETPU_QD_NORMAL_FAST_THR_OFFSET - 1)>>2))= normal_fast_threshold;
-   *(pba + ((FS_ETPU_QD_FAST_NORMAL_THR_OFFSET - 1)>>2))= fast_normal_threshold;
+   *(pba + ((FS_ETPU_QD_SLOW_NORMAL_THR_OFFSET - 1)>>2))= slow_normal_period;
+   *(pba + ((FS_ETPU_QD_NORMAL_SLOW_THR_OFFSET - 1)>>2))= normal_slow_period;
+   *(pba + ((FS_ETPU_QD_NORMAL_FAST_THR_OFFSET - 1)>>2))= normal_fast_period;
+   *(pba + ((FS_ETPU_QD_FAST_NORMAL_THR_OFFSET - 1)>>2))= fast_normal_period;
    *(pba + ((FS_ETPU_QD_LAST_LEADING_EDGE_OFFSET - 1)>>2)) = 0;
    *(pba + ((FS_ETPU_QD_LAST_EDGE_OFFSET - 1)>>2)) = 0;
    *(pba + ((FS_ETPU_QD_PC_SC_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) = 0;
    *(pba + ((FS_ETPU_QD_RATIO1_OFFSET - 1)>>2)) = (uint32_t)window_ratio1;
    *(pba + ((FS_ETPU_QD_RATIO2_OFFSET - 1)>>2)) = (uint32_t)window_ratio2 -
                                                   0x00800000;
+   *(pba + ((FS_ETPU_QD_FAST_ULTRA_THR_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_ULTRA_FAST_THR_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_FAST_TCR2_THR_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_TCR2_FAST_THR_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_TCR2_INTERVAL_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_POSITION_LO_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_POSITION_HI_OFFSET - 1)>>2)) = 0;
+   *(pba + (FS_ETPU_QD_TCR_EXT_OFFSET>>2)) = 0;
+   /* the 8-bit parameters, also those of the build options, share the top
+      bytes of the words above, so they are written after them */
    *((uint8_t*)pba + FS_ETPU_QD_DIRECTION_OFFSET) = 0;
    *((uint8_t*)pba + FS_ETPU_QD_PINS_OFFSET) = (uint8_t)(configuration << 2);
    *((uint8_t*)pba + FS_ETPU_QD_OPTIONS_OFFSET) = options;
    *((uint8_t*)pba + FS_ETPU_QD_PHASE_A_CHAN_OFFSET) = channel_primary & 0x1f;
    *((uint8_t*)pba + FS_ETPU_QD_PHASE_B_CHAN_OFFSET) = channel_secondary & 0x1f;
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+   *(pba + ((FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_IRQ_SUPPRESSED_OFFSET - 1)>>2)) = 0;
+   *((uint8_t*)pba + FS_ETPU_QD_IRQ_HYSTERESIS_OFFSET) = 0;
+   *((uint8_t*)pba + FS_ETPU_QD_IRQ_REV_DIV_OFFSET) = 0;
+#endif
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   *(pba + ((FS_ETPU_QD_STANDSTILL_TIMEOUT_OFFSET - 1)>>2)) = 0;
+   *((uint8_t*)pba + FS_ETPU_QD_STANDSTILL_IRQ_OFFSET) = 0;
+#endif
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+   *((uint8_t*)pba + FS_ETPU_QD_FAST_REVERSAL_OFFSET) = 0;
+#endif
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+   *(pba + ((FS_ETPU_QD_ILLEGAL_COUNT_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_WINDOW_COUNT_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_SPURIOUS_COUNT_OFFSET - 1)>>2)) = 0;
+#endif
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+   *(pba + ((FS_ETPU_QD_PROF_INIT_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_PROF_FAST_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_PROF_OVERFLOW_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_PROF_INDEX_HOME_OFFSET - 1)>>2)) = 0;
+   *(pba + ((FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET - 1)>>2)) = 0;
+#endif
 
    /****************************************
     * Write HSR.
@@ -324,6 +424,243 @@ int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
 
    return(0);
 }
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_rpm_to_period
+*PURPOSE      : To convert a speed threshold to the QD period (4 Position
+*               Counter increments) in TCR ticks, rounded to nearest. Periods
+*               longer than 24 bits are limited to 0xFFFFFF.
+*               This is the run-time equivalent of FS_ETPU_QD_RPM_TO_PERIOD.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  etpu_tcr_freq   - This is the frequency of TCR module, in [Hz].
+*  pc_per_rev      - This is the number of QD Position Counter increments
+*                    per revolution.
+*  rpm             - This is the speed threshold, in [rpm]. Zero is
+*                    converted to zero.
+*
+*RETURNS NOTES: QD period in TCR ticks.
+*******************************************************************************/
+uint24_t fs_etpu_eqd_rpm_to_period(uint32_t etpu_tcr_freq,
+                                   uint24_t pc_per_rev,
+                                   uint24_t rpm)
+{
+   unsigned long long period;
+
+   period = FS_ETPU_QD_RPM_TO_PERIOD(etpu_tcr_freq, pc_per_rev, rpm);
+   if (period > 0xffffff)
+      period = 0xffffff;
+
+   return((uint24_t)period);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_init_instance
+*PURPOSE      : To initialize an eTPU channels to implement QD.
+*INPUTS NOTES : This function has the following parameters:
+*
+*  p_instance            - This is a pointer to the QD instance structure
+*                          which is filled in. It can be used by the
+*                          fs_etpu_eqd_h_* functions afterwards.
+*  etpu_module           - Selects eTPU-AB module or eTPU-C module (only available 
+*                          on select parts)
+*  channel_primary       - This is the Primary channel number (Phase A).
+*                          one higner.
+*                          0-31 for ETPU_A/C and 64-95 for ETPU_B.
+*  channel_secondary     - This is the Secondary channel number (Phase B).
+*                          0-31 for ETPU_A/C and 64-95 for ETPU_B.
+*  channel_home          - If a Home signal is processed, this is the Home
+*                          channel number.
+*                          0-31 for ETPU_A/C and 64-95 for ETPU_B.
+*  channel_index         - If an Index signal is processed, this is the Index
+*                          channel number.
+*                          0-31 for ETPU_A and 64-95 for ETPU_B.
+*  signals               - This parameter determines which QD signals are used.
+*                          This parameter should be assigned a value of:
+*                          FS_ETPU_QD_PRIM_SEC
+*                          FS_ETPU_QD_PRIM_SEC_INDEX
+*                          FS_ETPU_QD_PRIM_SEC_HOME
+*                          FS_ETPU_QD_PRIM_SEC_INDEX_HOME.
+*  priority              - This is the priority to assign to the QD function.
+*                          This parameter should be assigned a value of:
+*                          FS_ETPU_PRIORITY_HIGH or
+*                          FS_ETPU_PRIORITY_MIDDLE or
+*                          FS_ETPU_PRIORITY_LOW or
+*                          FS_ETPU_PRIORITY_DISABLED.
+*  configuration         - This is the configuration of channels.
+*                          This parameter should be assigned a value of:
+*                          FS_ETPU_QD_CONFIGURATION_0 or
+*                          FS_ETPU_QD_CONFIGURATION_1.
+*  timer                 - This is the timer to use as a reference for the QD
+*                          signals.
+*                          This parameter should be assigned to a value of:
+*                          FS_ETPU_TCR1 or
+*                          FS_ETPU_TCR2.
+*  pc_max                - Maximum value of Position Counter.
+*                          This parameter is optional and can be set to zero;
+*                          then the automatic Position Counter reset is not
+*                          performed.
+*  slow_normal_threshold - This is the threshold for automatic switching from
+*                          slow mode to normal mode, in [rpm].
+*  normal_slow_threshold - This is the threshold for automatic switching from
+*                          normal mode to slow mode, in [rpm].
+*  normal_fast_threshold - This is the threshold for automatic switching from
+*                          normal mode to fast mode, in [rpm].
+*  fast_normal_threshold - This is the threshold for automatic switching from
+*                          fast mode to normal mode, in [rpm].
+*                          (When all thresholds are set to zero QD function
+*                          runs in slow mode only.)
+*  window_ratio1         - This is the ratio which applies when scheduling
+*                          the window beginning (in normal and fast mode).
+*                          This parameter determines how much time prior the
+*                          expected next QD edge the window opens.
+*                          This is a fractional value in format (9.15)
+*                          (0x00800000 corresponds to 1.0)
+*                          and should be assigned a value between
+*                          0.5 (0x00400000) and 0.9 (0x00733333).
+*                          Setting this value to 0 disables windowing at all.
+*  window_ratio2         - This is the ratio which applies when scheduling
+*                          the window ending (in normal and fast mode).
+*                          This parameter determines how much time after the
+*                          expected next QD edge the window opens.
+*                          This is a fractional value in format (9.15)
+*                          (0x00800000 corresponds to 1.0)
+*                          and should be assigned a value between
+*                          1.1 (0x008CCCCC) and 1.5 (0x00C00000).
+*                          Setting this value to 0 disables windowing at all.
+*  home_transition       - This parameter selects a type of Home signal
+*                          transition to detect.
+*                          This parameter should be assigned a value of:
+*                          FS_ETPU_QD_HOME_TRANS_LOW_HIGH,
+*                          FS_ETPU_QD_HOME_TRANS_HIGH_LOW or
+*                          FS_ETPU_QD_HOME_TRANS_ANY.
+*                          This parameter is ignored if Home channel is not 
+*                          used.
+*  index_pulse           - This parameter selects a type of Index signal pulse
+*                          to detect.
+*                          This parameter should be assigned to a value of:
+*                          FS_ETPU_QD_INDEX_PULSE_POSITIVE or
+*                          FS_ETPU_QD_INDEX_PULSE_NEGATIVE.
+*                          This parameter is ignored if Index channel is not
+*                          used.
+*  index_pc_reset        - This parameter selects an action to perform on Index
+*                          signal detection.
+*                          This parameter should be assigned to a value of:
+*                          FS_ETPU_QD_INDEX_PC_NO_RESET or
+*                          FS_ETPU_QD_INDEX_PC_RESET.
+*                          This parameter is ignored if Index channel is not
+*                          used.
+*  etpu_tcr_freq         - This is the frequency of TCR module used by QD
+*                          channels, in [Hz].
+*  qd_pc_per_rev         - This is the number of QD Position Counter increments
+*                          per revolution. When set to zero the thresholds
+*                          are used as QD periods in TCR ticks.
+*
+*  The thresholds are converted by fs_etpu_eqd_rpm_to_period and the channels
+*  are initialized by fs_etpu_eqd_init_precomputed.
+*
+* RETURNS NOTES: Error codes which can be returned are: FS_ETPU_ERROR_VALUE,
+*                FS_ETPU_ERROR_MALLOC
+******************************************************************************/
+int32_t fs_etpu_eqd_init_instance(struct eqd_instance_t *p_instance,
+                                  ETPU_MODULE etpu_module,
+                                  uint8_t   channel_primary,
+                                  uint8_t   channel_secondary,
+                                  uint8_t   channel_home,
+                                  uint8_t   channel_index,
+                                  uint8_t   signals,
+                                  uint8_t   priority,
+                                  uint8_t   configuration,
+                                  uint8_t   timer,
+                                  uint24_t  pc_max,
+                                  uint24_t  slow_normal_threshold,
+                                  uint24_t  normal_slow_threshold,
+                                  uint24_t  normal_fast_threshold,
+                                  uint24_t  fast_normal_threshold,
+                                  fract24_t window_ratio1,
+                                  fract24_t window_ratio2,
+                                  uint8_t   home_transition,
+                                  uint8_t   index_pulse,
+                                  uint8_t   index_pc_reset,
+                                  uint32_t  etpu_tcr_freq,
+                                  uint24_t  pc_per_rev)
+{
+   if (pc_per_rev > 0)
+   {
+      slow_normal_threshold = fs_etpu_eqd_rpm_to_period(etpu_tcr_freq, pc_per_rev, slow_normal_threshold);
+      normal_slow_threshold = fs_etpu_eqd_rpm_to_period(etpu_tcr_freq, pc_per_rev, normal_slow_threshold);
+      normal_fast_threshold = fs_etpu_eqd_rpm_to_period(etpu_tcr_freq, pc_per_rev, normal_fast_threshold);
+      fast_normal_threshold = fs_etpu_eqd_rpm_to_period(etpu_tcr_freq, pc_per_rev, fast_normal_threshold);
+   }
+
+   return(fs_etpu_eqd_init_precomputed(p_instance, etpu_module,
+                                       channel_primary, channel_secondary,
+                                       channel_home, channel_index,
+                                       signals, priority, configuration, timer,
+                                       pc_max,
+                                       slow_normal_threshold, normal_slow_threshold,
+                                       normal_fast_threshold, fast_normal_threshold,
+                                       window_ratio1, window_ratio2,
+                                       home_transition, index_pulse, index_pc_reset));
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_init
+*PURPOSE      : To initialize an eTPU channels to implement QD.
+*               See fs_etpu_eqd_init_instance for the parameter description.
+*               Use fs_etpu_eqd_get_instance to resolve the instance later.
+*
+* RETURNS NOTES: Error codes which can be returned are: FS_ETPU_ERROR_VALUE,
+*                FS_ETPU_ERROR_MALLOC
+******************************************************************************/
+int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
+                         uint8_t   channel_primary,
+                         uint8_t   channel_secondary,
+                         uint8_t   channel_home,
+                         uint8_t   channel_index,
+                         uint8_t   signals,
+                         uint8_t   priority,
+                         uint8_t   configuration,
+                         uint8_t   timer,
+                         uint24_t  pc_max,
+                         uint24_t  slow_normal_threshold,
+                         uint24_t  normal_slow_threshold,
+                         uint24_t  normal_fast_threshold,
+                         uint24_t  fast_normal_threshold,
+                         fract24_t window_ratio1,
+                         fract24_t window_ratio2,
+                         uint8_t   home_transition,
+                         uint8_t   index_pulse,
+                         uint8_t   index_pc_reset,
+                         uint32_t  etpu_tcr_freq,
+                         uint24_t  pc_per_rev)
+{
+    struct eqd_instance_t instance;
+
+    return fs_etpu_eqd_init_instance(
+        &instance,
+        etpu_module,
+        channel_primary,
+        channel_secondary,
+        channel_home,
+        channel_index,
+        signals,
+        priority,
+        configuration,
+        timer,
+        pc_max,
+        slow_normal_threshold,
+        normal_slow_threshold,
+        normal_fast_threshold,
+        fast_normal_threshold,
+        window_ratio1,
+        window_ratio2,
+        home_transition,
+        index_pulse,
+        index_pc_reset,
+        etpu_tcr_freq,
+        pc_per_rev);
+}
 /* for backwards compatibility */
 int32_t fs_etpu_qd_init( uint8_t   channel_primary,
                          uint8_t   channel_home,
@@ -408,12 +745,12 @@ int32_t fs_etpu_eqd_disable(ETPU_MODULE etpu_module,
    #ifdef FS_ETPU_MC_PARAM_CHECK
    if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95)||
       ((channel_secondary>31)&&(channel_secondary<64))||(channel_secondary>95)||
-      ((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
-       (signals==FS_ETPU_QD_PRIM_SEC_HOME))&&
-      (((channel_home>31)&&(channel_home<64))||(channel_home>95))||
-      ((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
-       (signals==FS_ETPU_QD_PRIM_SEC_INDEX))&&
-      (((channel_index>31)&&(channel_index<64))||(channel_index>95)))
+      (((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
+        (signals==FS_ETPU_QD_PRIM_SEC_HOME))&&
+       (((channel_home>31)&&(channel_home<64))||(channel_home>95)))||
+      (((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
+        (signals==FS_ETPU_QD_PRIM_SEC_INDEX))&&
+       (((channel_index>31)&&(channel_index<64))||(channel_index>95))))
    {
       return(FS_ETPU_ERROR_VALUE);
    }
@@ -492,12 +829,12 @@ int32_t fs_etpu_eqd_enable(ETPU_MODULE etpu_module,
    #ifdef FS_ETPU_MC_PARAM_CHECK
    if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95)||
       ((channel_secondary>31)&&(channel_secondary<64))||(channel_secondary>95)||
-      ((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
-       (signals==FS_ETPU_QD_PRIM_SEC_HOME))&&
-      (((channel_home>31)&&(channel_home<64))||(channel_home>95))||
-      ((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
-       (signals==FS_ETPU_QD_PRIM_SEC_INDEX))&&
-      (((channel_index>31)&&(channel_index<64))||(channel_index>95))||
+      (((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
+        (signals==FS_ETPU_QD_PRIM_SEC_HOME))&&
+       (((channel_home>31)&&(channel_home<64))||(channel_home>95)))||
+      (((signals==FS_ETPU_QD_PRIM_SEC_INDEX_HOME)||
+        (signals==FS_ETPU_QD_PRIM_SEC_INDEX))&&
+       (((channel_index>31)&&(channel_index<64))||(channel_index>95)))||
       (priority>FS_ETPU_PRIORITY_HIGH))
    {
       return(FS_ETPU_ERROR_VALUE);
@@ -542,6 +879,9 @@ int32_t fs_etpu_qd_enable( uint8_t channel_primary,
 *               on QD Configuration, and of the QD Primary and
 *               Secondary pin states.
 *               Position Counter dedicated for SC is reset to 0.
+*               This function waits until the eTPU services the
+*               initialization; fs_etpu_eqd_h_align_start and
+*               fs_etpu_eqd_h_align_poll do the same without waiting.
 *INPUTS NOTES : This function has 4 parameters:
 *
 *  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
@@ -561,8 +901,8 @@ int32_t fs_etpu_eqd_align(ETPU_MODULE etpu_module,
                           uint8_t channel_secondary,
                           int24_t pc)
 {
-   volatile struct eTPU_struct * eTPU;
-   uint8_t pins;
+   struct eqd_instance_t instance;
+   int32_t err_code;
 
    /* Parameters bounds check */
    #ifdef FS_ETPU_MC_PARAM_CHECK
@@ -572,28 +912,141 @@ int32_t fs_etpu_eqd_align(ETPU_MODULE etpu_module,
    }
    #endif
 
-   if (etpu_module == EM_AB)
-   {
-       eTPU = eTPU_AB;
-   }
-   else
-   {
-       eTPU = eTPU_C;
-   }
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   instance.chan_secondary = channel_secondary;
 
-   eTPU->CHAN[channel_primary].HSRR.R = FS_ETPU_QD_INIT;
-   eTPU->CHAN[channel_secondary].HSRR.R = FS_ETPU_QD_INIT;
+   /* Wait till the HSRs are accepted and the initialization is finished */
+   while ((err_code = fs_etpu_eqd_h_align_start(&instance, pc, 0))
+          == FS_ETPU_ERROR_NOT_READY) {}
+   if (err_code != 0)
+      return(err_code);
+   while ((err_code = fs_etpu_eqd_h_align_poll(&instance))
+          == FS_ETPU_ERROR_NOT_READY) {}
 
-   /* Wait till initialization is finished */
-   while (eTPU->CHAN[channel_secondary].HSRR.R != 0) {}
+   return(err_code);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_align_start
+*PURPOSE      : This function starts the QD alignment (see fs_etpu_eqd_align)
+*               by issuing the initialization HSRs on the Primary and
+*               Secondary channels. It does not wait; the alignment is
+*               completed by fs_etpu_eqd_h_align_poll. Several QD instances
+*               can be aligned at the same time.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  pc              - This is the Position Counter value to be set.
+*                    The actual value set is in range from pc-1 to pc+2,
+*                    to ensure PC divisibility by 4 on the leading edge.
+*  timeout_polls   - This is the number of fs_etpu_eqd_h_align_poll calls
+*                    after which the alignment is abandoned.
+*                    0 means no timeout.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY - a previous HSR is still pending on
+*               one of the channels, nothing has been done.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_align_start(struct eqd_instance_t *p_instance,
+                                  int24_t pc,
+                                  uint32_t timeout_polls)
+{
+   volatile struct eTPU_struct * eTPU;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(p_instance == 0)
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   if (p_instance->em == EM_AB)
+   {
+       eTPU = eTPU_AB;
+   }
+   else
+   {
+       eTPU = eTPU_C;
+   }
+
+   if ((eTPU->CHAN[p_instance->chan_primary].HSRR.R != 0) ||
+       (eTPU->CHAN[p_instance->chan_secondary].HSRR.R != 0))
+   {
+       return(FS_ETPU_ERROR_NOT_READY);
+   }
+
+   p_instance->align_pc = pc;
+   p_instance->align_polls = timeout_polls;
+   p_instance->align_pending = 1;
+
+   eTPU->CHAN[p_instance->chan_primary].HSRR.R = FS_ETPU_QD_INIT;
+   eTPU->CHAN[p_instance->chan_secondary].HSRR.R = FS_ETPU_QD_INIT;
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_align_poll
+*PURPOSE      : This function completes the QD alignment started by
+*               fs_etpu_eqd_h_align_start. When the eTPU has serviced both
+*               initialization HSRs, the Position Counter is adjusted
+*               according to the pin states and written, and the Position
+*               Counter dedicated for SC is reset to 0.
+*INPUTS NOTES : p_instance - This is a pointer to the QD instance structure.
+*
+*RETURNS NOTES: 0 - the alignment is done.
+*               Error codes that can be returned are: FS_ETPU_ERROR_VALUE -
+*               no alignment has been started,
+*               FS_ETPU_ERROR_NOT_READY - the HSRs have not been serviced yet,
+*               FS_ETPU_ERROR_TIMING - the HSRs have not been serviced within
+*               timeout_polls calls, the alignment is abandoned. The HSRs
+*               stay pending; when serviced, they reset the Position Counter
+*               to 0.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_align_poll(struct eqd_instance_t *p_instance)
+{
+   volatile struct eTPU_struct * eTPU;
+   uint8_t pins;
+   int24_t pc;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_instance->align_pending == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   if (p_instance->em == EM_AB)
+   {
+       eTPU = eTPU_AB;
+   }
+   else
+   {
+       eTPU = eTPU_C;
+   }
+
+   if ((eTPU->CHAN[p_instance->chan_primary].HSRR.R != 0) ||
+       (eTPU->CHAN[p_instance->chan_secondary].HSRR.R != 0))
+   {
+       if (p_instance->align_polls != 0)
+       {
+           if (--p_instance->align_polls == 0)
+           {
+               p_instance->align_pending = 0;
+               return(FS_ETPU_ERROR_TIMING);
+           }
+       }
+       return(FS_ETPU_ERROR_NOT_READY);
+   }
+   p_instance->align_pending = 0;
 
    /* Read actual pins state */
-   pins = (uint8_t)(fs_etpu_get_chan_local_8_ext(
-                    etpu_module,
-                    channel_primary,
-                    FS_ETPU_QD_PINS_OFFSET) & 0x07);
+   pins = (uint8_t)(*((uint8_t*)p_instance->cpba + FS_ETPU_QD_PINS_OFFSET) & 0x07);
 
    /* Adjust pc so that the leading edge counts a multiple of 4 */
+   pc = p_instance->align_pc;
    if ((pins == 0x01) || (pins == 0x06))
        pc += 1;
    else if ((pins == 0x02) || (pins == 0x05))
@@ -602,11 +1055,12 @@ int32_t fs_etpu_eqd_align(ETPU_MODULE etpu_module,
        pc += 2;
 
    /* Write pc and reset pc_sc */
-   fs_etpu_set_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_PC_OFFSET,(uint24_t)pc);
-   fs_etpu_set_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_PC_SC_OFFSET, 0);
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_PC_OFFSET - 1)>>2)) = (uint24_t)pc;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_PC_SC_OFFSET - 1)>>2)) = 0;
 
    return(0);
 }
+
 /* for backwards compatibility */
 int32_t fs_etpu_qd_align(uint8_t channel_primary,
                          int24_t pc)
@@ -740,6 +1194,331 @@ int32_t fs_etpu_qd_disable_pc_interrupts(uint8_t channel_primary)
     return fs_etpu_eqd_disable_pc_interrupts(EM_AB, channel_primary);
 }
 
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_set_pc_interrupt_coalescing
+*PURPOSE      : This function configures the coalescing of the pc_interrupts,
+*               which prevents an interrupt storm when the shaft dithers
+*               around a pc_interrupt value. A pc_interrupt value which has
+*               interrupted is re-armed only after pc has moved more than
+*               hysteresis counts away from it. All zero parameters (the
+*               init values) give an interrupt each time pc reaches a
+*               pc_interrupt value. Coalescing is available with the
+*               microcode built with QD_PC_IRQ_COALESCING.
+*INPUTS NOTES : This function has 5 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*  min_interval    - This is the minimum time between two interrupts, in
+*                    TCR ticks, 0 = no limit. 0 to
+*                    FS_ETPU_QD_IRQ_MIN_INTERVAL_MAX.
+*  hysteresis      - This is the hysteresis band, in Position Counter
+*                    increments.
+*  rev_divider     - This is N of the "every Nth revolution" mode - the
+*                    interrupt is generated only while the Revolution
+*                    Counter is a multiple of N. 0 or 1 = every revolution.
+*                    The Revolution Counter is maintained on the Index
+*                    channel.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_set_pc_interrupt_coalescing(ETPU_MODULE etpu_module,
+                                                uint8_t channel_primary,
+                                                uint24_t min_interval,
+                                                uint8_t hysteresis,
+                                                uint8_t rev_divider)
+{
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95)||
+      (min_interval>FS_ETPU_QD_IRQ_MIN_INTERVAL_MAX))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET,
+                             min_interval);
+   fs_etpu_set_chan_local_8_ext(etpu_module, channel_primary, FS_ETPU_QD_IRQ_HYSTERESIS_OFFSET,
+                            hysteresis);
+   fs_etpu_set_chan_local_8_ext(etpu_module, channel_primary, FS_ETPU_QD_IRQ_REV_DIV_OFFSET,
+                            rev_divider);
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_pc_interrupts_suppressed
+*PURPOSE      : This function returns the number of pc_interrupts suppressed
+*               by coalescing, see fs_etpu_eqd_set_pc_interrupt_coalescing.
+*               The counter is free running and wraps at 2^24; the host
+*               computes the difference of two reads.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*
+*RETURNS NOTES: Number of suppressed pc_interrupts.
+*******************************************************************************/
+uint24_t fs_etpu_eqd_get_pc_interrupts_suppressed(ETPU_MODULE etpu_module,
+                                                  uint8_t channel_primary)
+{
+   return(fs_etpu_get_chan_local_24_ext(etpu_module, channel_primary,
+                                    FS_ETPU_QD_IRQ_SUPPRESSED_OFFSET));
+}
+#endif
+
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_set_standstill
+*PURPOSE      : This function configures the standstill (zero speed)
+*               detection. In slow mode, when no transition is detected for
+*               timeout TCR ticks, the standstill flag is set and the period
+*               overflow matches are stopped until the next transition, so
+*               an idle axis consumes no eTPU engine time. The first period
+*               measured after standstill is FS_ETPU_QD_PERIOD_STANDSTILL
+*               or greater. The detection is available with the microcode
+*               built with QD_STANDSTILL.
+*INPUTS NOTES : This function has 4 parameters:
+*
+*  etpu_module      - Selects eTPU-AB module or eTPU-C module (only available 
+*                     on select parts)
+*  channel_primary  - This is the Primary channel number (Phase A).
+*                     0-31 for ETPU_A and 64-95 for ETPU_B.
+*  timeout          - This is the standstill timeout, in TCR ticks,
+*                     0 = detection disabled. 0 to
+*                     FS_ETPU_QD_STANDSTILL_TIMEOUT_MAX. It takes effect
+*                     from the next transition.
+*  interrupt_enable - This is FS_ETPU_QD_STANDSTILL_IRQ_ENABLE to generate
+*                     an interrupt on the Phase A or Phase B channel when
+*                     standstill is detected, 0 otherwise.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_set_standstill(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   uint24_t timeout,
+                                   uint8_t interrupt_enable)
+{
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95)||
+      (timeout>FS_ETPU_QD_STANDSTILL_TIMEOUT_MAX))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_set_chan_local_8_ext(etpu_module, channel_primary, FS_ETPU_QD_STANDSTILL_IRQ_OFFSET,
+                            interrupt_enable ? FS_ETPU_QD_STANDSTILL_IRQ_ENABLE : 0);
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_STANDSTILL_TIMEOUT_OFFSET,
+                             timeout);
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_standstill
+*PURPOSE      : This function returns the standstill flag, see
+*               fs_etpu_eqd_set_standstill.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*
+*RETURNS NOTES: 1 at standstill, 0 otherwise.
+*******************************************************************************/
+uint8_t fs_etpu_eqd_get_standstill(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary)
+{
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_standstill(&instance));
+}
+#endif
+
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_set_fast_reversal
+*PURPOSE      : This function enables or disables the direction reversal
+*               detection in FAST mode. In FAST mode only the leading edges
+*               of one channel are detected; with the detection enabled
+*               the pin of the other channel is sampled on each of them. A
+*               reversal is counted on the next leading edge, the direction
+*               is flipped, FS_ETPU_QD_ERROR_REVERSAL is set in the error
+*               flags and the QD continues in SLOW mode. The position after
+*               a reversal may be off by 4 counts when the shaft reversed
+*               right after a leading edge.
+*               The pin is sampled only when the edge thread starts within
+*               a quarter of the QD period after the edge; edges which end
+*               the detection window (FS_ETPU_QD_ERROR_WINDOWING) are not
+*               checked. The detection is available with the microcode
+*               built with QD_FAST_REVERSAL.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*  enable          - This is FS_ETPU_QD_FAST_REVERSAL_ENABLE to enable the
+*                    detection, 0 to disable it.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_set_fast_reversal(ETPU_MODULE etpu_module,
+                                      uint8_t channel_primary,
+                                      uint8_t enable)
+{
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_set_chan_local_8_ext(etpu_module, channel_primary, FS_ETPU_QD_FAST_REVERSAL_OFFSET,
+                            enable ? FS_ETPU_QD_FAST_REVERSAL_ENABLE : 0);
+
+   return(0);
+}
+#endif
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_set_ultra_fast
+*PURPOSE      : This function configures the ULTRA FAST mode, which extends
+*               FAST mode to higher speeds. In ULTRA FAST mode the channel
+*               detects the leading edges in pairs (double transition mode)
+*               and the eTPU services one thread per two leading edges, the
+*               Position Counter steps by 8.
+*               The QD switches from FAST to ULTRA FAST mode when the period
+*               drops below fast_ultra_period and back to FAST mode when it
+*               rises above ultra_fast_period. When the second leading edge
+*               of a pair does not come within 4 * ultra_fast_period, the
+*               QD leaves for SLOW mode and recovers the position from the
+*               pin states.
+*               In ULTRA FAST mode there is no windowing and no reversal
+*               detection, the edge history, pc_interrupt values, triggers
+*               and pc_max are checked only on every second leading edge,
+*               so use positions which are multiples of 8. A pc reset by
+*               the index may be off by 4 counts.
+*INPUTS NOTES : This function has 4 parameters:
+*
+*  etpu_module       - Selects eTPU-AB module or eTPU-C module (only
+*                      available on select parts)
+*  channel_primary   - This is the Primary channel number (Phase A).
+*                      0-31 for ETPU_A and 64-95 for ETPU_B.
+*  fast_ultra_period - This is the FAST to ULTRA FAST mode threshold, in TCR
+*                      ticks, 0 = ULTRA FAST mode disabled. It must be
+*                      below the normal_fast threshold.
+*  ultra_fast_period - This is the ULTRA FAST to FAST mode threshold, in TCR
+*                      ticks, fast_ultra_period to
+*                      FS_ETPU_QD_ULTRA_FAST_PERIOD_MAX.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_set_ultra_fast(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   uint24_t fast_ultra_period,
+                                   uint24_t ultra_fast_period)
+{
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95)||
+      (ultra_fast_period<fast_ultra_period)||
+      (ultra_fast_period>FS_ETPU_QD_ULTRA_FAST_PERIOD_MAX))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   /* no switch to ULTRA FAST mode while the thresholds change */
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_FAST_ULTRA_THR_OFFSET,
+                             0);
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_ULTRA_FAST_THR_OFFSET,
+                             ultra_fast_period);
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_FAST_ULTRA_THR_OFFSET,
+                             fast_ultra_period);
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_set_tcr2_counting
+*PURPOSE      : This function configures the TCR2 counting mode, which
+*               extends FAST mode to speeds beyond the eTPU edge servicing
+*               rate. In TCR2 counting mode no edge is serviced - TCR2 counts
+*               the phase A edges in hardware and a periodic match, every
+*               interval TCR1 ticks, adds the edges counted since the last
+*               match to the Position Counter and computes the period from
+*               them. The pin state at the match resolves the count to the
+*               exact quadrature state.
+*               The QD switches from FAST (or ULTRA FAST) to TCR2 counting
+*               mode when the period drops below fast_tcr2_period and to
+*               SLOW mode when the period computed at a match rises above
+*               tcr2_fast_period or no edge was counted.
+*               It requires the QD to run on TCR1 and the TCR2 of the engine
+*               to be clocked by the rise and fall of TCRCLK, wired to
+*               phase A (see QD_TCR2_TCRCLK in etpu_gct.h). The direction
+*               is held, there is no windowing and no reversal detection,
+*               the edge history, pc_interrupt values, triggers and pc_max
+*               are checked only at the match.
+*INPUTS NOTES : This function has 5 parameters:
+*
+*  etpu_module      - Selects eTPU-AB module or eTPU-C module (only
+*                     available on select parts)
+*  channel_primary  - This is the Primary channel number (Phase A).
+*                     0-31 for ETPU_A and 64-95 for ETPU_B.
+*  fast_tcr2_period - This is the FAST to TCR2 counting mode threshold, in
+*                     TCR1 ticks, 0 = TCR2 counting mode disabled. It must
+*                     be below the normal_fast threshold.
+*  tcr2_fast_period - This is the TCR2 counting to SLOW mode threshold, in
+*                     TCR1 ticks, fast_tcr2_period to
+*                     FS_ETPU_QD_TCR2_PERIOD_MAX.
+*  interval         - This is the match interval, in TCR1 ticks, 1 to
+*                     FS_ETPU_QD_TCR2_PERIOD_MAX. The Position Counter is
+*                     updated once per interval.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_set_tcr2_counting(ETPU_MODULE etpu_module,
+                                      uint8_t channel_primary,
+                                      uint24_t fast_tcr2_period,
+                                      uint24_t tcr2_fast_period,
+                                      uint24_t interval)
+{
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95)||
+      (tcr2_fast_period<fast_tcr2_period)||
+      (tcr2_fast_period>FS_ETPU_QD_TCR2_PERIOD_MAX)||
+      (interval>FS_ETPU_QD_TCR2_PERIOD_MAX)||
+      ((interval==0)&&(fast_tcr2_period!=0)))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   /* no switch to TCR2 counting mode while the settings change */
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_FAST_TCR2_THR_OFFSET,
+                             0);
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_TCR2_INTERVAL_OFFSET,
+                             interval);
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_TCR2_FAST_THR_OFFSET,
+                             tcr2_fast_period);
+   fs_etpu_set_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_FAST_TCR2_THR_OFFSET,
+                             fast_tcr2_period);
+
+   return(0);
+}
+
 /*******************************************************************************
 *FUNCTION     : fs_etpu_eqd_set_pc
 *PURPOSE      : This function changes the Position Counter value.
@@ -767,6 +1546,20 @@ int32_t fs_etpu_eqd_set_pc(ETPU_MODULE etpu_module,
 
    fs_etpu_set_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_PC_OFFSET,(uint24_t)pc);
 
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+   /* Re-post the active trigger table, the eTPU finds the next target
+      from the new pc on the next edge */
+   if((fs_etpu_get_chan_local_8_ext(etpu_module,channel_primary,FS_ETPU_QD_OPTIONS_OFFSET) &
+       FS_ETPU_QD_TRIGGER_TABLE_ENABLED) &&
+      (fs_etpu_get_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_TRIG_NEW_START_OFFSET) == 0))
+   {
+      fs_etpu_set_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_TRIG_NEW_END_OFFSET,
+         fs_etpu_get_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_TRIG_END_OFFSET));
+      fs_etpu_set_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_TRIG_NEW_START_OFFSET,
+         fs_etpu_get_chan_local_24_ext(etpu_module,channel_primary,FS_ETPU_QD_TRIG_START_OFFSET));
+   }
+#endif
+
    return(0);
 }
 /* for backwards compatibility */
@@ -861,7 +1654,10 @@ int32_t fs_etpu_qd_set_slow_mode(uint8_t channel_primary)
 int24_t fs_etpu_eqd_get_pc(ETPU_MODULE etpu_module,
                            uint8_t channel_primary)
 {
-   return (fs_etpu_get_chan_local_24s_ext(etpu_module, channel_primary, FS_ETPU_QD_PC_OFFSET));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_pc(&instance));
 }
 /* for backwards compatibility */
 int24_t fs_etpu_qd_get_pc( uint8_t channel_primary)
@@ -884,7 +1680,10 @@ int24_t fs_etpu_qd_get_pc( uint8_t channel_primary)
 int24_t fs_etpu_eqd_get_pc_sc(ETPU_MODULE etpu_module,
                               uint8_t channel_primary)
 {
-   return(fs_etpu_get_chan_local_24s_ext(etpu_module, channel_primary, FS_ETPU_QD_PC_SC_OFFSET));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_pc_sc(&instance));
 }
 /* for backwards compatibility */
 int24_t fs_etpu_qd_get_pc_sc( uint8_t channel_primary)
@@ -907,7 +1706,10 @@ int24_t fs_etpu_qd_get_pc_sc( uint8_t channel_primary)
 int24_t fs_etpu_eqd_get_rc(ETPU_MODULE etpu_module,
                            uint8_t channel_primary)
 {
-   return(fs_etpu_get_chan_local_24s_ext(etpu_module, channel_primary, FS_ETPU_QD_RC_OFFSET));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_rc(&instance));
 }
 /* for backwards compatibility */
 int24_t fs_etpu_qd_get_rc( uint8_t channel_primary)
@@ -932,11 +1734,10 @@ int24_t fs_etpu_qd_get_rc( uint8_t channel_primary)
 int8_t fs_etpu_eqd_get_direction(ETPU_MODULE etpu_module,
                                  uint8_t channel_primary)
 {
-   if ((int8_t)(fs_etpu_get_chan_local_8_ext(etpu_module, channel_primary,
-       FS_ETPU_QD_DIRECTION_OFFSET)) > 0)
-      return(FS_ETPU_QD_DIRECTION_INC);
-   else
-      return(FS_ETPU_QD_DIRECTION_DEC);
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_direction(&instance));
 }
 /* for backwards compatibility */
 int8_t fs_etpu_qd_get_direction(uint8_t channel_primary)
@@ -958,12 +1759,16 @@ int8_t fs_etpu_qd_get_direction(uint8_t channel_primary)
 *               1 - FS_ETPU_QD_MODE_SLOW
 *               2 - FS_ETPU_QD_MODE_NORMAL
 *               4 - FS_ETPU_QD_MODE_FAST
+*               0x20 - FS_ETPU_QD_MODE_ULTRA_FAST
+*               0x40 - FS_ETPU_QD_MODE_TCR2
 *******************************************************************************/
 uint8_t fs_etpu_eqd_get_mode(ETPU_MODULE etpu_module,
                              uint8_t channel_primary)
 {
-   return((uint8_t)(fs_etpu_get_chan_local_8_ext(etpu_module, channel_primary,
-                                        FS_ETPU_QD_MODE_CURRENT_OFFSET) & 0x7));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_mode(&instance));
 }
 /* for backwards compatibility */
 uint8_t fs_etpu_qd_get_mode(uint8_t channel_primary)
@@ -987,7 +1792,10 @@ uint8_t fs_etpu_qd_get_mode(uint8_t channel_primary)
 uint24_t fs_etpu_eqd_get_tcr(ETPU_MODULE etpu_module,
                              uint8_t channel_primary)
 {
-   return(fs_etpu_get_chan_local_24_ext(etpu_module, channel_primary, FS_ETPU_QD_LAST_EDGE_OFFSET));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_tcr(&instance));
 }
 /* for backwards compatibility */
 uint24_t fs_etpu_qd_get_tcr( uint8_t channel_primary)
@@ -995,6 +1803,30 @@ uint24_t fs_etpu_qd_get_tcr( uint8_t channel_primary)
     return fs_etpu_eqd_get_tcr(EM_AB, channel_primary);
 }
 
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_tcr32
+*PURPOSE      : This function returns the TCR time of the last detected
+*               transition extended to 32 bits, see fs_etpu_eqd_h_get_tcr32.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*
+*RETURNS NOTES: 32-bit TCR time of the last transition.
+*******************************************************************************/
+uint32_t fs_etpu_eqd_get_tcr32(ETPU_MODULE etpu_module,
+                               uint8_t channel_primary)
+{
+   struct eqd_instance_t instance;
+   uint32_t last_edge = 0;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   fs_etpu_eqd_h_get_tcr32(&instance, &last_edge, 0);
+   return(last_edge);
+}
+
 /*******************************************************************************
 *FUNCTION     : fs_etpu_eqd_get_period
 *PURPOSE      : This function returns the QD period.
@@ -1010,7 +1842,10 @@ uint24_t fs_etpu_qd_get_tcr( uint8_t channel_primary)
 uint32_t fs_etpu_eqd_get_period(ETPU_MODULE etpu_module,
                                 uint8_t channel_primary)
 {
-   return(fs_etpu_get_chan_local_32_ext(etpu_module, channel_primary, FS_ETPU_QD_PERIOD_OFFSET));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_period(&instance));
 }
 /* for backwards compatibility */
 uint24_t fs_etpu_qd_get_period( uint8_t channel_primary)
@@ -1018,10 +1853,12 @@ uint24_t fs_etpu_qd_get_period( uint8_t channel_primary)
     return (uint24_t)fs_etpu_eqd_get_period(EM_AB, channel_primary);
 }
 
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
 /*******************************************************************************
-*FUNCTION     : fs_etpu_eqd_get_pinA
-*PURPOSE      : This function returns the current state of Primary (Phase A)
-*               input signal.
+*FUNCTION     : fs_etpu_eqd_get_period_avg
+*PURPOSE      : This function returns the moving average of the QD period
+*               of a microcode built with QD_PERIOD_AVG, see
+*               fs_etpu_eqd_h_period_avg_init.
 *INPUTS NOTES : This function has 2 parameters:
 *
 *  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
@@ -1029,50 +1866,150 @@ uint24_t fs_etpu_qd_get_period( uint8_t channel_primary)
 *  channel_primary - This is the Primary channel number (Phase A).
 *                    0-31 for ETPU_A and 64-95 for ETPU_B.
 *
-*RETURNS NOTES: State of Phase A input channel.
+*RETURNS NOTES: Average QD period.
 *******************************************************************************/
-uint8_t fs_etpu_eqd_get_pinA(ETPU_MODULE etpu_module,
-                             uint8_t channel_primary)
+uint32_t fs_etpu_eqd_get_period_avg(ETPU_MODULE etpu_module,
+                                    uint8_t channel_primary)
 {
-   return((uint8_t)(fs_etpu_get_chan_local_8_ext(etpu_module, channel_primary,
-                   FS_ETPU_QD_PINS_OFFSET) & 0x1));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_period_avg(&instance));
 }
-/* for backwards compatibility */
-uint8_t fs_etpu_qd_get_pinA( uint8_t channel_primary)
+#endif
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_rev_period
+*PURPOSE      : This function returns the revolution period measured on the
+*               index channel, see fs_etpu_eqd_h_get_rev_period.
+*INPUTS NOTES : This function has 4 parameters:
+*
+*  etpu_module      - Selects eTPU-AB module or eTPU-C module (only available 
+*                     on select parts)
+*  channel_primary  - This is the Primary channel number (Phase A).
+*                     0-31 for ETPU_A and 64-95 for ETPU_B.
+*  p_rev_period     - This is a pointer to the revolution period, bits 0-31.
+*  p_rev_period_ext - This is a pointer to the revolution period overflow
+*                     extension, bits 32-39. It may be 0.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY.
+*******************************************************************************/
+int32_t fs_etpu_eqd_get_rev_period(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   uint32_t *p_rev_period,
+                                   uint8_t *p_rev_period_ext)
 {
-    return fs_etpu_eqd_get_pinA(EM_AB, channel_primary);
+   struct eqd_instance_t instance;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_rev_period(&instance, p_rev_period, p_rev_period_ext));
 }
 
 /*******************************************************************************
-*FUNCTION     : fs_etpu_eqd_get_pinB
-*PURPOSE      : This function returns the current state of Secondary (Phase B)
-*               input signal.
-*INPUTS NOTES : This function has 2 parameters:
+*FUNCTION     : fs_etpu_eqd_get_position64
+*PURPOSE      : This function returns the 48-bit absolute position, see
+*               fs_etpu_eqd_h_get_position64.
+*INPUTS NOTES : This function has 3 parameters:
 *
 *  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
 *                    on select parts)
 *  channel_primary - This is the Primary channel number (Phase A).
 *                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*  p_position      - This is a pointer to the absolute position.
 *
-*RETURNS NOTES: State of Phase B input channel.
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY.
 *******************************************************************************/
-uint8_t fs_etpu_eqd_get_pinB(ETPU_MODULE etpu_module,
-                             uint8_t channel_primary)
-{
-   return((uint8_t)((fs_etpu_get_chan_local_8_ext(etpu_module, channel_primary,
-                    FS_ETPU_QD_PINS_OFFSET) &  0x2) >> 1));
-}
-/* for backwards compatibility */
-uint8_t fs_etpu_qd_get_pinB( uint8_t channel_primary)
+int32_t fs_etpu_eqd_get_position64(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   long long *p_position)
 {
-    return fs_etpu_eqd_get_pinB(EM_AB, channel_primary);
+   struct eqd_instance_t instance;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_position64(&instance, p_position));
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_pinA
+*PURPOSE      : This function returns the current state of Primary (Phase A)
+*               input signal.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*
+*RETURNS NOTES: State of Phase A input channel.
+*******************************************************************************/
+uint8_t fs_etpu_eqd_get_pinA(ETPU_MODULE etpu_module,
+                             uint8_t channel_primary)
+{
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_pinA(&instance));
+}
+/* for backwards compatibility */
+uint8_t fs_etpu_qd_get_pinA( uint8_t channel_primary)
+{
+    return fs_etpu_eqd_get_pinA(EM_AB, channel_primary);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_pinB
+*PURPOSE      : This function returns the current state of Secondary (Phase B)
+*               input signal.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*
+*RETURNS NOTES: State of Phase B input channel.
+*******************************************************************************/
+uint8_t fs_etpu_eqd_get_pinB(ETPU_MODULE etpu_module,
+                             uint8_t channel_primary)
+{
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_pinB(&instance));
+}
+/* for backwards compatibility */
+uint8_t fs_etpu_qd_get_pinB( uint8_t channel_primary)
+{
+    return fs_etpu_eqd_get_pinB(EM_AB, channel_primary);
 }
 
 
 /*******************************************************************************
 *FUNCTION     : fs_etpu_eqd_get_current_error_flags
 *PURPOSE      : This function returns the current state of the QD error flags.
-*               See the auto header file for error bit definitions. 
+*               See the auto header file for error bit definitions:
+*               FS_ETPU_QD_ERROR_WINDOWING, _REVERSAL, _ILLEGAL (Slow mode,
+*               both pins changed between two edges) and _SPURIOUS (Slow
+*               mode, the pin was back on its level before the edge was
+*               serviced - the edge is not counted).
 *INPUTS NOTES : This function has 2 parameters:
 *
 *  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
@@ -1085,14 +2022,16 @@ uint8_t fs_etpu_qd_get_pinB( uint8_t channel_primary)
 uint8_t fs_etpu_eqd_get_current_error_flags(ETPU_MODULE etpu_module,
                                             uint8_t channel_primary)
 {
-   return((uint8_t)fs_etpu_get_chan_local_8_ext(etpu_module, channel_primary,
-                                        FS_ETPU_QD_ERROR_FLAGS_OFFSET));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_current_error_flags(&instance));
 }
 
 /*******************************************************************************
 *FUNCTION     : fs_etpu_eqd_get_latched_error_flags
 *PURPOSE      : This function returns the latched value of the QD error flags.
-*               See the auto header file for error bit definitions. 
+*               See fs_etpu_eqd_get_current_error_flags.
 *INPUTS NOTES : This function has 2 parameters:
 *
 *  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
@@ -1105,8 +2044,10 @@ uint8_t fs_etpu_eqd_get_current_error_flags(ETPU_MODULE etpu_module,
 uint8_t fs_etpu_eqd_get_latched_error_flags(ETPU_MODULE etpu_module,
                                             uint8_t channel_primary)
 {
-   return((uint8_t)fs_etpu_get_chan_local_8_ext(etpu_module, channel_primary,
-                                        FS_ETPU_QD_LATCHED_ERROR_FLAGS_OFFSET));
+   struct eqd_instance_t instance;
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_latched_error_flags(&instance));
 }
 
 /*******************************************************************************
@@ -1154,6 +2095,1439 @@ int32_t fs_etpu_eqd_latch_and_clear_error_flags(ETPU_MODULE etpu_module,
    return 0;
 }
 
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_error_counters
+*PURPOSE      : This function returns the QD error counters, see
+*               fs_etpu_eqd_h_get_error_counters. It is available with the
+*               microcode built with QD_ERROR_COUNTERS.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*  p_counters      - This is a pointer to the structure the counters are
+*                    written to.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_get_error_counters(ETPU_MODULE etpu_module,
+                                       uint8_t channel_primary,
+                                       struct eqd_error_counters_t *p_counters)
+{
+   struct eqd_instance_t instance;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   fs_etpu_eqd_h_get_error_counters(&instance, p_counters);
+   return(0);
+}
+#endif
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_state
+*PURPOSE      : This function reads all QD outputs into one structure.
+*               See fs_etpu_eqd_h_get_state.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*  p_state         - This is a pointer to the structure the QD outputs are
+*                    written to.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_get_state(ETPU_MODULE etpu_module,
+                              uint8_t channel_primary,
+                              struct eqd_state_t *p_state)
+{
+   struct eqd_instance_t instance;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   return(fs_etpu_eqd_h_get_state(&instance, p_state));
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_get_instance
+*PURPOSE      : This function fills a QD instance structure for QD channels
+*               initialized by fs_etpu_eqd_init. Only the module, the primary
+*               channel and the parameter base addresses are filled, which is
+*               all the fs_etpu_eqd_h_* accessors need.
+*               The edge ring, edge history, period average and trigger
+*               table buffers belong to the instance that allocated them by
+*               the fs_etpu_eqd_h_*_init functions. The filled instance has
+*               no buffers, so the accessors that need one return
+*               FS_ETPU_ERROR_VALUE on it. Do not call the *_init functions
+*               on it for an option that is already initialized, that would
+*               allocate a second buffer.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*  p_instance      - This is a pointer to the QD instance structure.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_get_instance(ETPU_MODULE etpu_module,
+                                 uint8_t channel_primary,
+                                 struct eqd_instance_t *p_instance)
+{
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95)||
+      (p_instance == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, p_instance);
+   p_instance->chan_secondary = channel_primary + 1;
+   p_instance->chan_home = 0;
+   p_instance->chan_index = 0;
+   p_instance->signals = FS_ETPU_QD_PRIM_SEC;
+   p_instance->priority = FS_ETPU_PRIORITY_DISABLE;
+
+   return(0);
+}
+
+/*******************************************************************************
+*=============== Instance Based Accessors ======================================
+* The fs_etpu_eqd_h_* functions use the parameter base addresses resolved in
+* the QD instance structure. Each of them is a single DATA RAM access.
+*
+*INPUTS NOTES : p_instance - This is a pointer to the QD instance structure,
+*                            filled by fs_etpu_eqd_init_instance or
+*                            fs_etpu_eqd_get_instance.
+*******************************************************************************/
+
+/* Position Counter value */
+int24_t fs_etpu_eqd_h_get_pc(const struct eqd_instance_t *p_instance)
+{
+   return(*(int32_t*)(p_instance->cpba_pse + ((FS_ETPU_QD_PC_OFFSET - 1)>>2)));
+}
+
+/* Position Counter for SC value */
+int24_t fs_etpu_eqd_h_get_pc_sc(const struct eqd_instance_t *p_instance)
+{
+   return(*(int32_t*)(p_instance->cpba_pse + ((FS_ETPU_QD_PC_SC_OFFSET - 1)>>2)));
+}
+
+/* Revolution Counter value */
+int24_t fs_etpu_eqd_h_get_rc(const struct eqd_instance_t *p_instance)
+{
+   return(*(int32_t*)(p_instance->cpba_pse + ((FS_ETPU_QD_RC_OFFSET - 1)>>2)));
+}
+
+/* FS_ETPU_QD_DIRECTION_INC or FS_ETPU_QD_DIRECTION_DEC */
+int8_t fs_etpu_eqd_h_get_direction(const struct eqd_instance_t *p_instance)
+{
+   if (*((int8_t*)p_instance->cpba + FS_ETPU_QD_DIRECTION_OFFSET) > 0)
+      return(FS_ETPU_QD_DIRECTION_INC);
+   else
+      return(FS_ETPU_QD_DIRECTION_DEC);
+}
+
+/* FS_ETPU_QD_MODE_SLOW, _NORMAL, _FAST, _ULTRA_FAST or _TCR2 */
+uint8_t fs_etpu_eqd_h_get_mode(const struct eqd_instance_t *p_instance)
+{
+   return((uint8_t)(*((uint8_t*)p_instance->cpba + FS_ETPU_QD_MODE_CURRENT_OFFSET) & FS_ETPU_QD_MODE_MASK));
+}
+
+/* TCR time of the last transition */
+uint24_t fs_etpu_eqd_h_get_tcr(const struct eqd_instance_t *p_instance)
+{
+   return(*(p_instance->cpba + ((FS_ETPU_QD_LAST_EDGE_OFFSET - 1)>>2)) & 0xffffff);
+}
+
+/* QD period */
+uint32_t fs_etpu_eqd_h_get_period(const struct eqd_instance_t *p_instance)
+{
+   return(*(p_instance->cpba + (FS_ETPU_QD_PERIOD_OFFSET>>2)));
+}
+
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+/* Moving average of the QD period */
+uint32_t fs_etpu_eqd_h_get_period_avg(const struct eqd_instance_t *p_instance)
+{
+   return(*(p_instance->cpba + (FS_ETPU_QD_PERIOD_AVG_OFFSET>>2)));
+}
+#endif
+
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+/* 1 at standstill, 0 otherwise */
+uint8_t fs_etpu_eqd_h_get_standstill(const struct eqd_instance_t *p_instance)
+{
+   return(*((uint8_t*)p_instance->cpba + FS_ETPU_QD_STANDSTILL_OFFSET) ? 1 : 0);
+}
+#endif
+
+/* State of Phase A input channel */
+uint8_t fs_etpu_eqd_h_get_pinA(const struct eqd_instance_t *p_instance)
+{
+   return((uint8_t)(*((uint8_t*)p_instance->cpba + FS_ETPU_QD_PINS_OFFSET) & 0x1));
+}
+
+/* State of Phase B input channel */
+uint8_t fs_etpu_eqd_h_get_pinB(const struct eqd_instance_t *p_instance)
+{
+   return((uint8_t)((*((uint8_t*)p_instance->cpba + FS_ETPU_QD_PINS_OFFSET) & 0x2) >> 1));
+}
+
+/* Current error flags */
+uint8_t fs_etpu_eqd_h_get_current_error_flags(const struct eqd_instance_t *p_instance)
+{
+   return(*((uint8_t*)p_instance->cpba + FS_ETPU_QD_ERROR_FLAGS_OFFSET));
+}
+
+/* Latched error flags */
+uint8_t fs_etpu_eqd_h_get_latched_error_flags(const struct eqd_instance_t *p_instance)
+{
+   return(*((uint8_t*)p_instance->cpba + FS_ETPU_QD_LATCHED_ERROR_FLAGS_OFFSET));
+}
+
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+/* Error counters - illegal transitions, window ends without an edge and
+   spurious edges, each saturated at FS_ETPU_QD_ERROR_COUNT_MAX. They are
+   cleared only by the QD initialization; take differences to monitor an
+   encoder over time. */
+void fs_etpu_eqd_h_get_error_counters(const struct eqd_instance_t *p_instance,
+                                      struct eqd_error_counters_t *p_counters)
+{
+   p_counters->illegal = (uint16_t)(*(p_instance->cpba + ((FS_ETPU_QD_ILLEGAL_COUNT_OFFSET - 1)>>2)) & 0xffff);
+   p_counters->window = (uint16_t)(*(p_instance->cpba + ((FS_ETPU_QD_WINDOW_COUNT_OFFSET - 1)>>2)) & 0xffff);
+   p_counters->spurious = (uint16_t)(*(p_instance->cpba + ((FS_ETPU_QD_SPURIOUS_COUNT_OFFSET - 1)>>2)) & 0xffff);
+}
+#endif
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_get_state
+*PURPOSE      : This function reads all QD outputs into one structure.
+*               The pair pc/last_edge and the pair period/last_edge are read
+*               using the Coherent Dual-Parameter Controller (CDC). The
+*               snapshot is marked coherent when both transfers succeed and
+*               return the same last_edge, i.e. pc, last_edge and period
+*               belong to the same transition. Otherwise the values are read
+*               one by one and the coherent flag is cleared.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  p_state         - This is a pointer to the structure the QD outputs are
+*                    written to.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_get_state(const struct eqd_instance_t *p_instance,
+                                struct eqd_state_t *p_state)
+{
+   uint32_t * pba;
+   uint32_t * pba_pse;
+   int32_t  pc;
+   int32_t  last_edge;
+   uint32_t period;
+   uint32_t last_edge_32;
+   uint8_t  coherent = 0;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_state == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   pba = p_instance->cpba;
+   pba_pse = p_instance->cpba_pse;
+
+   if ((fs_etpu_coherent_read_24_ext(p_instance->em, p_instance->chan_primary,
+                                     FS_ETPU_QD_PC_OFFSET,
+                                     FS_ETPU_QD_LAST_EDGE_OFFSET,
+                                     &pc, &last_edge) == 0) &&
+       (fs_etpu_coherent_read_32_ext(p_instance->em, p_instance->chan_primary,
+                                     FS_ETPU_QD_PERIOD_OFFSET,
+                                     FS_ETPU_QD_LAST_EDGE_OFFSET - 1,
+                                     &period, &last_edge_32) == 0) &&
+       ((uint24_t)(last_edge_32 & 0xffffff) == (uint24_t)(last_edge & 0xffffff)))
+   {
+      coherent = 1;
+   }
+   else
+   {
+      pc = *(int32_t*)(pba_pse + ((FS_ETPU_QD_PC_OFFSET - 1)>>2));
+      last_edge = *(int32_t*)(pba_pse + ((FS_ETPU_QD_LAST_EDGE_OFFSET - 1)>>2));
+      period = *(pba + (FS_ETPU_QD_PERIOD_OFFSET>>2));
+   }
+
+   p_state->pc = pc;
+   p_state->last_edge = (uint24_t)(last_edge & 0xffffff);
+   p_state->period = period;
+   p_state->coherent = coherent;
+   p_state->pc_sc = *(int32_t*)(pba_pse + ((FS_ETPU_QD_PC_SC_OFFSET - 1)>>2));
+   p_state->rc = *(int32_t*)(pba_pse + ((FS_ETPU_QD_RC_OFFSET - 1)>>2));
+   if (*((int8_t*)pba + FS_ETPU_QD_DIRECTION_OFFSET) > 0)
+      p_state->direction = FS_ETPU_QD_DIRECTION_INC;
+   else
+      p_state->direction = FS_ETPU_QD_DIRECTION_DEC;
+   p_state->mode = (uint8_t)(*((uint8_t*)pba + FS_ETPU_QD_MODE_CURRENT_OFFSET) & FS_ETPU_QD_MODE_MASK);
+   p_state->pins = (uint8_t)(*((uint8_t*)pba + FS_ETPU_QD_PINS_OFFSET) & 0x3);
+   p_state->error_flags = *((uint8_t*)pba + FS_ETPU_QD_ERROR_FLAGS_OFFSET);
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_get_state_seq
+*PURPOSE      : This function reads all QD outputs into one structure without
+*               using the CDC. The eTPU increments the seq parameter before
+*               and after it updates the QD outputs. The outputs are read
+*               between two reads of seq; when seq is odd or has changed the
+*               read is repeated, up to FS_ETPU_QD_SEQ_RETRY_MAX times.
+*               Each repeated read is counted in p_instance->seq_retries.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  p_state         - This is a pointer to the structure the QD outputs are
+*                    written to.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY - a consistent set of outputs could not
+*               be read within FS_ETPU_QD_SEQ_RETRY_MAX re-reads. p_state
+*               holds the last read values with the coherent flag cleared.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_get_state_seq(struct eqd_instance_t *p_instance,
+                                    struct eqd_state_t *p_state)
+{
+   /* volatile - the DATA RAM reads must not be reordered around seq */
+   volatile uint32_t * pba;
+   volatile uint32_t * pba_pse;
+   uint32_t seq1;
+   uint32_t seq2;
+   uint32_t retries = 0;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_state == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   pba = p_instance->cpba;
+   pba_pse = p_instance->cpba_pse;
+
+   for (;;)
+   {
+      seq1 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+
+      p_state->pc = *(volatile int32_t*)(pba_pse + ((FS_ETPU_QD_PC_OFFSET - 1)>>2));
+      p_state->pc_sc = *(volatile int32_t*)(pba_pse + ((FS_ETPU_QD_PC_SC_OFFSET - 1)>>2));
+      p_state->rc = *(volatile int32_t*)(pba_pse + ((FS_ETPU_QD_RC_OFFSET - 1)>>2));
+      p_state->period = *(pba + (FS_ETPU_QD_PERIOD_OFFSET>>2));
+      p_state->last_edge = *(pba + ((FS_ETPU_QD_LAST_EDGE_OFFSET - 1)>>2)) & 0xffffff;
+      if (*((volatile int8_t*)pba + FS_ETPU_QD_DIRECTION_OFFSET) > 0)
+         p_state->direction = FS_ETPU_QD_DIRECTION_INC;
+      else
+         p_state->direction = FS_ETPU_QD_DIRECTION_DEC;
+      p_state->mode = (uint8_t)(*((volatile uint8_t*)pba + FS_ETPU_QD_MODE_CURRENT_OFFSET) & FS_ETPU_QD_MODE_MASK);
+      p_state->pins = (uint8_t)(*((volatile uint8_t*)pba + FS_ETPU_QD_PINS_OFFSET) & 0x3);
+      p_state->error_flags = *((volatile uint8_t*)pba + FS_ETPU_QD_ERROR_FLAGS_OFFSET);
+
+      seq2 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+
+      if ((seq1 == seq2) && ((seq1 & 1) == 0))
+      {
+         p_state->coherent = 1;
+         return(0);
+      }
+      if (retries >= FS_ETPU_QD_SEQ_RETRY_MAX)
+      {
+         p_state->coherent = 0;
+         return(FS_ETPU_ERROR_NOT_READY);
+      }
+      retries++;
+      p_instance->seq_retries++;
+   }
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_get_rev_period
+*PURPOSE      : This function returns the revolution period - the TCR1 time
+*               between the first transitions of the last two index pulses.
+*               It does not depend on the encoder line spacing. The eTPU
+*               extends it by an overflow match every 0x800000 TCR1 ticks,
+*               so it is 40 bits wide: the 32-bit period and an 8-bit
+*               overflow extension, read coherently using seq. The period
+*               is 0 until two index pulses have been seen after the index
+*               channel initialization. After a direction reversal it is
+*               the time between two crossings of the index position, not
+*               a full revolution.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance       - This is a pointer to the QD instance structure.
+*  p_rev_period     - This is a pointer to the revolution period, bits 0-31.
+*  p_rev_period_ext - This is a pointer to the revolution period overflow
+*                     extension, bits 32-39. It may be 0.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY - a consistent value could not be read
+*               within FS_ETPU_QD_SEQ_RETRY_MAX re-reads.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_get_rev_period(struct eqd_instance_t *p_instance,
+                                     uint32_t *p_rev_period,
+                                     uint8_t *p_rev_period_ext)
+{
+   /* volatile - the DATA RAM reads must not be reordered around seq */
+   volatile uint32_t * pba;
+   uint32_t seq1;
+   uint32_t seq2;
+   uint32_t rev_period;
+   uint8_t  rev_period_ext;
+   uint32_t retries = 0;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_rev_period == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   pba = p_instance->cpba;
+
+   for (;;)
+   {
+      seq1 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+      rev_period = *(pba + (FS_ETPU_QD_REV_PERIOD_OFFSET>>2));
+      rev_period_ext = *((volatile uint8_t*)pba + FS_ETPU_QD_REV_PERIOD_EXT_OFFSET);
+      seq2 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+
+      if ((seq1 == seq2) && ((seq1 & 1) == 0))
+      {
+         break;
+      }
+      if (retries >= FS_ETPU_QD_SEQ_RETRY_MAX)
+      {
+         return(FS_ETPU_ERROR_NOT_READY);
+      }
+      retries++;
+      p_instance->seq_retries++;
+   }
+
+   *p_rev_period = rev_period;
+   if (p_rev_period_ext != 0)
+   {
+      *p_rev_period_ext = rev_period_ext;
+   }
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_get_tcr32
+*PURPOSE      : This function returns the last edge and the last leading edge
+*               times extended to 32 bits. The eTPU counts the TCR wraps since
+*               the QD initialization on the edges and on the period overflow
+*               match, which keeps running at standstill, and stores the
+*               wrap count with each edge time as bits 24-31. The times are
+*               read coherently using seq. QD instances initialized within
+*               the same TCR wrap share the 32-bit time base.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance          - This is a pointer to the QD instance structure.
+*  p_last_edge         - This is a pointer to the last edge time.
+*  p_last_leading_edge - This is a pointer to the last leading edge time. It
+*                        may be 0.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY - consistent values could not be read
+*               within FS_ETPU_QD_SEQ_RETRY_MAX re-reads; the last read values
+*               are returned.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_get_tcr32(struct eqd_instance_t *p_instance,
+                                uint32_t *p_last_edge,
+                                uint32_t *p_last_leading_edge)
+{
+   /* volatile - the DATA RAM reads must not be reordered around seq */
+   volatile uint32_t * pba;
+   uint32_t seq1;
+   uint32_t seq2;
+   uint32_t last_edge;
+   uint32_t last_leading_edge;
+   uint32_t retries = 0;
+   int32_t  result = 0;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_last_edge == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   pba = p_instance->cpba;
+
+   for (;;)
+   {
+      seq1 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+      last_edge = (*(pba + ((FS_ETPU_QD_LAST_EDGE_OFFSET - 1)>>2)) & 0xffffff) |
+                  ((uint32_t)*((volatile uint8_t*)pba + FS_ETPU_QD_LAST_EDGE_EXT_OFFSET) << 24);
+      last_leading_edge = (*(pba + ((FS_ETPU_QD_LAST_LEADING_EDGE_OFFSET - 1)>>2)) & 0xffffff) |
+                  ((uint32_t)*((volatile uint8_t*)pba + FS_ETPU_QD_LAST_LEADING_EDGE_EXT_OFFSET) << 24);
+      seq2 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+
+      if ((seq1 == seq2) && ((seq1 & 1) == 0))
+      {
+         break;
+      }
+      if (retries >= FS_ETPU_QD_SEQ_RETRY_MAX)
+      {
+         result = FS_ETPU_ERROR_NOT_READY;
+         break;
+      }
+      retries++;
+      p_instance->seq_retries++;
+   }
+
+   *p_last_edge = last_edge;
+   if (p_last_leading_edge != 0)
+   {
+      *p_last_leading_edge = last_leading_edge;
+   }
+   return(result);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_get_position64
+*PURPOSE      : This function returns the 48-bit absolute position. The eTPU
+*               counts it on every edge like pc_sc, with the carry from the
+*               low to the high 24 bits, and never resets it - neither
+*               pc_max, the index nor fs_etpu_eqd_set_pc/align change it. It
+*               is 0 after fs_etpu_eqd_init. Both halves are read coherently
+*               using seq, so the host does not need to poll it faster than
+*               pc wraps.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  p_instance - This is a pointer to the QD instance structure.
+*  p_position - This is a pointer to the absolute position.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY - a consistent value could not be read
+*               within FS_ETPU_QD_SEQ_RETRY_MAX re-reads.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_get_position64(struct eqd_instance_t *p_instance,
+                                     long long *p_position)
+{
+   /* volatile - the DATA RAM reads must not be reordered around seq */
+   volatile uint32_t * pba;
+   uint32_t seq1;
+   uint32_t seq2;
+   uint32_t position_lo;
+   uint32_t position_hi;
+   uint32_t retries = 0;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_position == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   pba = p_instance->cpba;
+
+   for (;;)
+   {
+      seq1 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+      position_lo = *(pba + ((FS_ETPU_QD_POSITION_LO_OFFSET - 1)>>2)) & 0xffffff;
+      position_hi = *(pba + ((FS_ETPU_QD_POSITION_HI_OFFSET - 1)>>2)) & 0xffffff;
+      seq2 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+
+      if ((seq1 == seq2) && ((seq1 & 1) == 0))
+      {
+         break;
+      }
+      if (retries >= FS_ETPU_QD_SEQ_RETRY_MAX)
+      {
+         return(FS_ETPU_ERROR_NOT_READY);
+      }
+      retries++;
+      p_instance->seq_retries++;
+   }
+
+   /* sign-extend the high 24 bits */
+   *p_position = (long long)(((int32_t)(position_hi << 8)) >> 8) * 0x1000000LL +
+                 position_lo;
+   return(0);
+}
+
+#ifdef FS_ETPU_QD_RING_START_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_edge_ring_init
+*PURPOSE      : This function allocates the edge ring in the eTPU DATA RAM and
+*               enables it. On each leading edge the eTPU appends a record
+*               {direction, last_edge}, {sequence, pc} to the ring and raises
+*               a DMA request on the primary channel. The 8-bit sequence
+*               number counts the leading edges, recorded or dropped.
+*               In FS_ETPU_QD_EDGE_RING_DMA mode the ring is expected to be
+*               drained by a DMA channel triggered by the primary channel,
+*               8 bytes per request, with the source address reset by the
+*               ring size at the end of the major loop. The eTPU does not
+*               check for a full ring; records overwritten or merged into
+*               one DMA request before they were transferred show as a gap
+*               in the sequence, see fs_etpu_eqd_edge_ring_lost.
+*               In FS_ETPU_QD_EDGE_RING_POLLED mode the host reads the ring
+*               and releases the consumed records by
+*               fs_etpu_eqd_h_edge_ring_set_rd_index. Records are dropped
+*               and counted while the ring is full.
+*               The ring can be allocated only once per instance. It is
+*               available with the microcode built with QD_EDGE_RING.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  num_records     - This is the number of ring records,
+*                    FS_ETPU_QD_EDGE_RING_MIN to FS_ETPU_QD_EDGE_RING_MAX
+*                    (8 bytes of DATA RAM each). One record is always left
+*                    empty in the POLLED mode.
+*  mode            - This parameter should be assigned a value of:
+*                    FS_ETPU_QD_EDGE_RING_DMA or
+*                    FS_ETPU_QD_EDGE_RING_POLLED.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_MALLOC.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_edge_ring_init(struct eqd_instance_t *p_instance,
+                                     uint16_t num_records,
+                                     uint8_t  mode)
+{
+   uint32_t * p_ring;
+   uint32_t ring_start;
+   uint8_t options;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_instance->edge_ring != 0)||
+      (num_records < FS_ETPU_QD_EDGE_RING_MIN)||
+      (num_records > FS_ETPU_QD_EDGE_RING_MAX)||
+      (mode > FS_ETPU_QD_EDGE_RING_POLLED))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   if ((p_ring = fs_etpu_malloc_ext(p_instance->em, (uint16_t)(num_records << 3))) == 0)
+   {
+      return(FS_ETPU_ERROR_MALLOC);
+   }
+   p_instance->edge_ring = p_ring;
+   p_instance->edge_ring_size = num_records;
+
+   /* eTPU address of the ring */
+   ring_start = fs_etpu_eqd_ram_offset(p_instance->em, p_ring);
+
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_RING_START_OFFSET - 1)>>2)) = ring_start;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_RING_END_OFFSET - 1)>>2)) = ring_start + ((uint32_t)num_records << 3);
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_RING_WR_OFFSET - 1)>>2)) = ring_start;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_RING_OVERFLOW_OFFSET - 1)>>2)) = 0;
+   *((uint8_t*)p_instance->cpba + FS_ETPU_QD_RING_SEQ_OFFSET) = 0;
+   if (mode == FS_ETPU_QD_EDGE_RING_POLLED)
+   {
+      *(p_instance->cpba_pse + ((FS_ETPU_QD_RING_RD_OFFSET - 1)>>2)) = ring_start;
+   }
+   else
+   {
+      *(p_instance->cpba_pse + ((FS_ETPU_QD_RING_RD_OFFSET - 1)>>2)) = 0;
+      fs_etpu_dma_enable_ext(p_instance->em, p_instance->chan_primary);
+   }
+
+   options = *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET);
+   options |= FS_ETPU_QD_EDGE_RING_ENABLED;
+   *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET) = options;
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_edge_ring_get_wr_index
+*PURPOSE      : This function returns the index of the edge ring record the
+*               eTPU writes next. The records from the read index up to it
+*               are valid.
+*INPUTS NOTES : p_instance - This is a pointer to the QD instance structure.
+*
+*RETURNS NOTES: Write index, 0 to num_records-1.
+*******************************************************************************/
+uint24_t fs_etpu_eqd_h_edge_ring_get_wr_index(const struct eqd_instance_t *p_instance)
+{
+   return(((*(p_instance->cpba + ((FS_ETPU_QD_RING_WR_OFFSET - 1)>>2)) -
+            *(p_instance->cpba + ((FS_ETPU_QD_RING_START_OFFSET - 1)>>2))) & 0xffffff) >> 3);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_edge_ring_get_overflow
+*PURPOSE      : This function returns the number of edge records dropped
+*               because the ring was full (FS_ETPU_QD_EDGE_RING_POLLED mode).
+*INPUTS NOTES : p_instance - This is a pointer to the QD instance structure.
+*
+*RETURNS NOTES: Number of dropped records.
+*******************************************************************************/
+uint24_t fs_etpu_eqd_h_edge_ring_get_overflow(const struct eqd_instance_t *p_instance)
+{
+   return(*(p_instance->cpba + ((FS_ETPU_QD_RING_OVERFLOW_OFFSET - 1)>>2)) & 0xffffff);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_edge_ring_lost
+*PURPOSE      : This function returns the number of edge records lost between
+*               two records received one after the other, e.g. from the
+*               destination buffer of the DMA draining the ring
+*               (FS_ETPU_QD_EDGE_RING_DMA mode), from their sequence numbers.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  p_prev_record   - This is a pointer to the previous record received.
+*  p_record        - This is a pointer to the record received after it.
+*
+*RETURNS NOTES: Number of lost records, modulo 256.
+*******************************************************************************/
+uint8_t fs_etpu_eqd_edge_ring_lost(const uint32_t *p_prev_record,
+                                   const uint32_t *p_record)
+{
+   return((uint8_t)((p_record[1] >> 24) - (p_prev_record[1] >> 24) - 1));
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_edge_ring_set_rd_index
+*PURPOSE      : This function releases the edge ring records up to, but not
+*               including, rd_index back to the eTPU
+*               (FS_ETPU_QD_EDGE_RING_POLLED mode only).
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  rd_index        - This is the index of the next record to be read.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_edge_ring_set_rd_index(const struct eqd_instance_t *p_instance,
+                                             uint24_t rd_index)
+{
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(rd_index >= p_instance->edge_ring_size)
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_RING_RD_OFFSET - 1)>>2)) =
+      (*(p_instance->cpba + ((FS_ETPU_QD_RING_START_OFFSET - 1)>>2)) & 0xffffff) + (rd_index << 3);
+
+   return(0);
+}
+#endif
+
+#ifdef FS_ETPU_QD_HIST_START_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_edge_history_init
+*PURPOSE      : This function allocates the edge history in the eTPU DATA RAM
+*               and enables it. On each counted edge the eTPU writes an entry
+*               {direction, last_edge} to the history, overwriting the oldest
+*               one. One entry more than num_entries is allocated, so that
+*               all num_entries can be read while the next one is written.
+*               The history can be allocated only once per instance. It is
+*               available with the microcode built with QD_EDGE_HISTORY.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  num_entries     - This is the number of history entries,
+*                    FS_ETPU_QD_EDGE_HISTORY_MIN to FS_ETPU_QD_EDGE_HISTORY_MAX.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_MALLOC.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_edge_history_init(struct eqd_instance_t *p_instance,
+                                        uint8_t num_entries)
+{
+   uint32_t * p_hist;
+   uint32_t hist_start;
+   uint8_t options;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_instance->edge_hist != 0)||
+      (num_entries < FS_ETPU_QD_EDGE_HISTORY_MIN)||
+      (num_entries > FS_ETPU_QD_EDGE_HISTORY_MAX))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   if ((p_hist = fs_etpu_malloc_ext(p_instance->em, (uint16_t)((num_entries + 1) << 2))) == 0)
+   {
+      return(FS_ETPU_ERROR_MALLOC);
+   }
+   p_instance->edge_hist = p_hist;
+   p_instance->edge_hist_size = num_entries + 1;
+
+   /* eTPU address of the history */
+   hist_start = fs_etpu_eqd_ram_offset(p_instance->em, p_hist);
+
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_HIST_START_OFFSET - 1)>>2)) = hist_start;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_HIST_END_OFFSET - 1)>>2)) = hist_start + ((uint32_t)(num_entries + 1) << 2);
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_HIST_WR_OFFSET - 1)>>2)) = hist_start;
+
+   options = *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET);
+   options |= FS_ETPU_QD_EDGE_HISTORY_ENABLED;
+   *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET) = options;
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_edge_history_get
+*PURPOSE      : This function copies the most recent edge history entries,
+*               the most recent one first. Each entry is one word: bits
+*               31-24 direction (as int8_t), bits 23-0 the edge TCR value.
+*               The copy is taken between two reads of the seq parameter.
+*               It is repeated, up to FS_ETPU_QD_SEQ_RETRY_MAX times, when
+*               the eTPU could have overwritten a copied entry in between.
+*               Entries not yet written since the history was enabled read
+*               as 0.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  num_entries     - This is the number of entries to copy, 1 to the
+*                    num_entries the history was allocated with.
+*  p_entries       - This is a pointer to the array the entries are
+*                    copied to.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY - no coherent copy could be taken
+*               within FS_ETPU_QD_SEQ_RETRY_MAX re-reads.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_edge_history_get(struct eqd_instance_t *p_instance,
+                                       uint8_t num_entries,
+                                       uint32_t *p_entries)
+{
+   /* volatile - the DATA RAM reads must not be reordered around seq */
+   volatile uint32_t * pba;
+   volatile uint32_t * p_hist;
+   uint32_t seq1;
+   uint32_t seq2;
+   uint32_t wr;
+   uint32_t retries = 0;
+   uint8_t size;
+   uint8_t i;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_instance->edge_hist == 0)||(p_entries == 0)||
+      (num_entries == 0)||(num_entries >= p_instance->edge_hist_size))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   pba = p_instance->cpba;
+   p_hist = p_instance->edge_hist;
+   size = p_instance->edge_hist_size;
+
+   for (;;)
+   {
+      seq1 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+      wr = (((*(pba + ((FS_ETPU_QD_HIST_WR_OFFSET - 1)>>2)) -
+              *(pba + ((FS_ETPU_QD_HIST_START_OFFSET - 1)>>2))) & 0xffffff) >> 2);
+      for (i = 0; i < num_entries; i++)
+      {
+         wr = (wr == 0) ? (uint32_t)size - 1 : wr - 1;
+         p_entries[i] = *(p_hist + wr);
+      }
+      seq2 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+
+      /* Each edge thread writes at most one entry between its two seq
+         increments, so at most (seq2-seq1)/2+1 entries were written
+         during the copy, starting at the write index read. */
+      if (((seq2 - seq1) & 0xffffff)/2 + 1 <= (uint32_t)(size - num_entries))
+      {
+         return(0);
+      }
+      if (retries >= FS_ETPU_QD_SEQ_RETRY_MAX)
+      {
+         return(FS_ETPU_ERROR_NOT_READY);
+      }
+      retries++;
+      p_instance->seq_retries++;
+   }
+}
+#endif
+
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_period_avg_init
+*PURPOSE      : This function allocates the period average buffer in the eTPU
+*               DATA RAM and enables the moving average period_avg. On each
+*               leading edge the eTPU replaces the oldest period in the
+*               buffer and publishes the average of the last num_periods
+*               periods. The buffer starts with zero periods, so the average
+*               settles after num_periods leading edges. The average is
+*               valid while the periods are below 2^32/num_periods TCR ticks.
+*               The buffer can be allocated only once per instance. It is
+*               available with the microcode built with QD_PERIOD_AVG.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  num_periods     - This is the number of averaged periods, a power of two,
+*                    2 to FS_ETPU_QD_PERIOD_AVG_MAX.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_MALLOC.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_period_avg_init(struct eqd_instance_t *p_instance,
+                                      uint8_t num_periods)
+{
+   uint32_t * p_buf;
+   uint32_t avg_start;
+   uint8_t shift;
+   uint8_t options;
+   uint8_t i;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_instance->period_avg_buf != 0)||
+      (num_periods < 2)||(num_periods > FS_ETPU_QD_PERIOD_AVG_MAX)||
+      ((num_periods & (num_periods - 1)) != 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   if ((p_buf = fs_etpu_malloc_ext(p_instance->em, (uint16_t)(num_periods << 2))) == 0)
+   {
+      return(FS_ETPU_ERROR_MALLOC);
+   }
+   p_instance->period_avg_buf = p_buf;
+   for (i = 0; i < num_periods; i++)
+   {
+      p_buf[i] = 0;
+   }
+   for (shift = 0; (1 << shift) < num_periods; shift++)
+      ;
+
+   /* eTPU address of the buffer */
+   avg_start = fs_etpu_eqd_ram_offset(p_instance->em, p_buf);
+
+   *(p_instance->cpba + (FS_ETPU_QD_PERIOD_AVG_OFFSET>>2)) = 0;
+   *(p_instance->cpba + (FS_ETPU_QD_PERIOD_SUM_OFFSET>>2)) = 0;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_AVG_START_OFFSET - 1)>>2)) = avg_start;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_AVG_END_OFFSET - 1)>>2)) = avg_start + ((uint32_t)num_periods << 2);
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_AVG_WR_OFFSET - 1)>>2)) = avg_start;
+   *((uint8_t*)p_instance->cpba + FS_ETPU_QD_AVG_SHIFT_OFFSET) = shift;
+
+   options = *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET);
+   options |= FS_ETPU_QD_PERIOD_AVG_ENABLED;
+   *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET) = options;
+
+   return(0);
+}
+#endif
+
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_trigger_init
+*PURPOSE      : This function allocates two position trigger table buffers in
+*               the eTPU DATA RAM and enables the trigger table, empty. Tables
+*               are loaded by fs_etpu_eqd_h_trigger_load. The buffers can be
+*               allocated only once per instance. The trigger table is
+*               available with the microcode built with QD_TRIGGER_TABLE.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  max_triggers    - This is the maximum number of entries of a table,
+*                    1 to FS_ETPU_QD_TRIGGER_MAX.
+*  link_chan       - This is the channel linked by the entries with
+*                    FS_ETPU_QD_TRIGGER_LINK, 0-31 within the eTPU engine.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_MALLOC.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_trigger_init(struct eqd_instance_t *p_instance,
+                                   uint8_t max_triggers,
+                                   uint8_t link_chan)
+{
+   uint32_t * p_buf;
+   uint32_t trig_start;
+   uint8_t options;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_instance->trig_buf != 0)||
+      (max_triggers == 0)||(max_triggers > FS_ETPU_QD_TRIGGER_MAX)||
+      (link_chan > 31))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   if ((p_buf = fs_etpu_malloc_ext(p_instance->em, (uint16_t)(max_triggers << 3))) == 0)
+   {
+      return(FS_ETPU_ERROR_MALLOC);
+   }
+   p_instance->trig_buf = p_buf;
+   p_instance->trig_size = max_triggers;
+   p_instance->trig_bank = 0;
+
+   /* eTPU address of the first buffer */
+   trig_start = fs_etpu_eqd_ram_offset(p_instance->em, p_buf);
+
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_TRIG_START_OFFSET - 1)>>2)) = trig_start;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_TRIG_END_OFFSET - 1)>>2)) = trig_start;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_TRIG_NEXT_OFFSET - 1)>>2)) = trig_start;
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_TRIG_NEW_START_OFFSET - 1)>>2)) = 0;
+   *(p_instance->cpba + (FS_ETPU_QD_TRIG_LAST_OFFSET>>2)) = 0;
+   *((uint8_t*)p_instance->cpba + FS_ETPU_QD_TRIG_LINK_CHAN_OFFSET) = link_chan;
+
+   options = *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET);
+   options |= FS_ETPU_QD_TRIGGER_TABLE_ENABLED;
+   *((uint8_t*)p_instance->cpba + FS_ETPU_QD_OPTIONS_OFFSET) = options;
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_trigger_load
+*PURPOSE      : This function loads a position trigger table. The table is
+*               written to the buffer the eTPU does not use and posted; the
+*               eTPU swaps to it on the next QD edge, in one step, and finds
+*               the next target from the pc before that edge, so that edge
+*               triggers an entry at its pc. An entry triggers when pc
+*               reaches its position in
+*               either direction (pc stepping over it in Fast mode counts):
+*               an interrupt and/or DMA request on the primary channel
+*               and/or a link to the link channel. The eTPU compares only
+*               the next target in the direction of motion on each edge.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  p_triggers      - This is a pointer to the table entries, sorted by
+*                    ascending position, with no duplicate positions.
+*  num_triggers    - This is the number of entries, 0 to the max_triggers
+*                    of fs_etpu_eqd_h_trigger_init.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE,
+*               FS_ETPU_ERROR_NOT_READY - the previously loaded table has not
+*               been taken over by the eTPU yet (no QD edge since), try again.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_trigger_load(struct eqd_instance_t *p_instance,
+                                   const struct eqd_trigger_t *p_triggers,
+                                   uint8_t num_triggers)
+{
+   uint32_t * p_buf;
+   uint32_t trig_start;
+   uint8_t i;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_instance->trig_buf == 0)||
+      (num_triggers > p_instance->trig_size)||
+      ((p_triggers == 0)&&(num_triggers != 0)))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   for (i = 1; i < num_triggers; i++)
+   {
+      if (p_triggers[i].position <= p_triggers[i-1].position)
+      {
+         return(FS_ETPU_ERROR_VALUE);
+      }
+   }
+   #endif
+
+   if ((*(p_instance->cpba + ((FS_ETPU_QD_TRIG_NEW_START_OFFSET - 1)>>2)) & 0xffffff) != 0)
+   {
+      return(FS_ETPU_ERROR_NOT_READY);
+   }
+
+   /* the buffer not in use by the eTPU */
+   p_instance->trig_bank ^= 1;
+   p_buf = p_instance->trig_buf + (p_instance->trig_bank ? p_instance->trig_size : 0);
+   for (i = 0; i < num_triggers; i++)
+   {
+      p_buf[i] = ((uint32_t)p_triggers[i].actions << 24) |
+                 ((uint32_t)p_triggers[i].position & 0xffffff);
+   }
+
+   trig_start = fs_etpu_eqd_ram_offset(p_instance->em, p_buf);
+
+   /* post - trig_new_start last, the eTPU swaps when it is not 0 */
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_TRIG_NEW_END_OFFSET - 1)>>2)) = trig_start + ((uint32_t)num_triggers << 2);
+   *(p_instance->cpba_pse + ((FS_ETPU_QD_TRIG_NEW_START_OFFSET - 1)>>2)) = trig_start;
+
+   return(0);
+}
+
+/* Last trigger table entry that triggered, bits 31-24 actions, 23-0 position */
+uint32_t fs_etpu_eqd_h_trigger_get_last(const struct eqd_instance_t *p_instance)
+{
+   return(*(p_instance->cpba + (FS_ETPU_QD_TRIG_LAST_OFFSET>>2)));
+}
+#endif
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_read_many
+*PURPOSE      : This function reads the outputs of several QD instances into
+*               one structure of arrays. The reads are grouped by eTPU
+*               module (all eTPU_AB instances, then all eTPU_C instances)
+*               and, within a module, by parameter, so consecutive reads go
+*               to the same DATA RAM and the same parameter offset.
+*               The sequence counter of each instance is read before and
+*               after its outputs; instances updated in between are flagged
+*               in p_readout->incoherent. Such an instance can be re-read by
+*               fs_etpu_eqd_h_get_state_seq.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instances     - This is a pointer to an array of QD instance structures.
+*  num_axes        - This is the number of instances, 1 to
+*                    FS_ETPU_QD_MAX_AXES.
+*  p_readout       - This is a pointer to the structure the QD outputs are
+*                    written to.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_read_many(const struct eqd_instance_t *p_instances,
+                                uint8_t num_axes,
+                                struct eqd_readout_t *p_readout)
+{
+   /* volatile - the DATA RAM reads must not be reordered around seq */
+   volatile uint32_t * pba[FS_ETPU_QD_MAX_AXES];
+   volatile uint32_t * pba_pse[FS_ETPU_QD_MAX_AXES];
+   uint32_t seq[FS_ETPU_QD_MAX_AXES];
+   uint8_t order[FS_ETPU_QD_MAX_AXES];
+   uint32_t incoherent;
+   uint32_t seq2;
+   uint8_t i;
+   uint8_t k;
+   uint8_t n;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instances == 0)||(p_readout == 0)||
+      (num_axes == 0)||(num_axes > FS_ETPU_QD_MAX_AXES))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   /* order the axes by module: eTPU_AB first, then eTPU_C */
+   n = 0;
+   for (i = 0; i < num_axes; i++)
+      if (p_instances[i].em == EM_AB) order[n++] = i;
+   for (i = 0; i < num_axes; i++)
+      if (p_instances[i].em != EM_AB) order[n++] = i;
+
+   for (k = 0; k < num_axes; k++)
+   {
+      i = order[k];
+      pba[k] = p_instances[i].cpba;
+      pba_pse[k] = p_instances[i].cpba_pse;
+   }
+
+   for (k = 0; k < num_axes; k++)
+      seq[k] = *(pba[k] + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2));
+   for (k = 0; k < num_axes; k++)
+      p_readout->pc[order[k]] = *(volatile int32_t*)(pba_pse[k] + ((FS_ETPU_QD_PC_OFFSET - 1)>>2));
+   for (k = 0; k < num_axes; k++)
+      p_readout->pc_sc[order[k]] = *(volatile int32_t*)(pba_pse[k] + ((FS_ETPU_QD_PC_SC_OFFSET - 1)>>2));
+   for (k = 0; k < num_axes; k++)
+      p_readout->rc[order[k]] = *(volatile int32_t*)(pba_pse[k] + ((FS_ETPU_QD_RC_OFFSET - 1)>>2));
+   for (k = 0; k < num_axes; k++)
+      p_readout->period[order[k]] = *(pba[k] + (FS_ETPU_QD_PERIOD_OFFSET>>2));
+   for (k = 0; k < num_axes; k++)
+      p_readout->last_edge[order[k]] = *(pba[k] + ((FS_ETPU_QD_LAST_EDGE_OFFSET - 1)>>2)) & 0xffffff;
+   for (k = 0; k < num_axes; k++)
+   {
+      if (*((volatile int8_t*)pba[k] + FS_ETPU_QD_DIRECTION_OFFSET) > 0)
+         p_readout->direction[order[k]] = FS_ETPU_QD_DIRECTION_INC;
+      else
+         p_readout->direction[order[k]] = FS_ETPU_QD_DIRECTION_DEC;
+   }
+   for (k = 0; k < num_axes; k++)
+      p_readout->mode[order[k]] = (uint8_t)(*((volatile uint8_t*)pba[k] + FS_ETPU_QD_MODE_CURRENT_OFFSET) & FS_ETPU_QD_MODE_MASK);
+   for (k = 0; k < num_axes; k++)
+      p_readout->error_flags[order[k]] = *((volatile uint8_t*)pba[k] + FS_ETPU_QD_ERROR_FLAGS_OFFSET);
+
+   incoherent = 0;
+   for (k = 0; k < num_axes; k++)
+   {
+      seq2 = *(pba[k] + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2));
+      if (((seq[k] ^ seq2) & 0xffffff) || (seq2 & 1))
+         incoherent |= (uint32_t)1 << order[k];
+   }
+   p_readout->incoherent = incoherent;
+
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_h_get_position_at
+*PURPOSE      : This function returns the position at the time tcr_now,
+*               extrapolated from the last edge using the period and the
+*               direction. The fractional part is the time since the last
+*               edge divided by the time of one count (period/4), limited to
+*               one pc step (1 count, or 4 counts in FAST mode).
+*               pc, period, last_edge and direction are read under the
+*               sequence counter. The division by the period is replaced by
+*               a multiplication by its reciprocal, which is recalculated
+*               only when the period changes, that is at most once per
+*               leading edge.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_instance      - This is a pointer to the QD instance structure.
+*  tcr_now         - This is the time (TCR value of the QD time base) to get
+*                    the position at. It must be within half a TCR wrap
+*                    after the last edge.
+*  p_position      - This is a pointer to the position, in counts with
+*                    FS_ETPU_QD_POSITION_FRAC_BITS fractional bits. It
+*                    saturates at the int32_t range near the ends of the
+*                    24-bit pc range.
+*
+*RETURNS NOTES: Error codes that can be returned are: FS_ETPU_ERROR_VALUE
+*               (also when tcr_now is before the last edge),
+*               FS_ETPU_ERROR_NOT_READY (the eTPU kept updating the QD
+*               outputs).
+*******************************************************************************/
+int32_t fs_etpu_eqd_h_get_position_at(struct eqd_instance_t *p_instance,
+                                      uint24_t tcr_now,
+                                      int32_t  *p_position)
+{
+   /* volatile - the DATA RAM reads must not be reordered around seq */
+   volatile uint32_t * pba;
+   volatile uint32_t * pba_pse;
+   uint32_t seq1;
+   uint32_t seq2;
+   uint32_t retries = 0;
+   int32_t pc;
+   uint32_t period;
+   uint32_t last_edge;
+   int8_t direction;
+   uint32_t dt;
+   unsigned long long frac64;
+   uint32_t frac;
+   uint32_t frac_max;
+   long long position;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if((p_instance == 0)||(p_position == 0))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   pba = p_instance->cpba;
+   pba_pse = p_instance->cpba_pse;
+
+   for (;;)
+   {
+      seq1 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+      pc = *(volatile int32_t*)(pba_pse + ((FS_ETPU_QD_PC_OFFSET - 1)>>2));
+      period = *(pba + (FS_ETPU_QD_PERIOD_OFFSET>>2));
+      last_edge = *(pba + ((FS_ETPU_QD_LAST_EDGE_OFFSET - 1)>>2));
+      direction = *((volatile int8_t*)pba + FS_ETPU_QD_DIRECTION_OFFSET);
+      seq2 = *(pba + ((FS_ETPU_QD_SEQ_OFFSET - 1)>>2)) & 0xffffff;
+      if ((seq1 == seq2) && ((seq1 & 1) == 0))
+      {
+         break;
+      }
+      if (retries >= FS_ETPU_QD_SEQ_RETRY_MAX)
+      {
+         return(FS_ETPU_ERROR_NOT_READY);
+      }
+      retries++;
+      p_instance->seq_retries++;
+   }
+
+   if (period != p_instance->recip_period)
+   {
+      p_instance->recip_period = period;
+      p_instance->recip = (period == 0) ? 0 : (0xFFFFFFFF / period);
+   }
+
+   /* time since the last edge, 24-bit wrap-safe */
+   dt = (tcr_now - last_edge) & 0xffffff;
+   if (dt & 0x800000)
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+
+   /* frac = dt * 4 * 2^FRAC_BITS / period, limited to one pc step */
+   frac64 = ((unsigned long long)dt * p_instance->recip) >>
+            (32 - 2 - FS_ETPU_QD_POSITION_FRAC_BITS);
+   if (direction < 0)
+      frac_max = (uint32_t)(-direction) << FS_ETPU_QD_POSITION_FRAC_BITS;
+   else
+      frac_max = (uint32_t)direction << FS_ETPU_QD_POSITION_FRAC_BITS;
+   frac = (frac64 > frac_max) ? frac_max : (uint32_t)frac64;
+
+   /* pc*2^FRAC_BITS +/- frac exceeds int32_t at the ends of the pc range */
+   position = (long long)pc*(1 << FS_ETPU_QD_POSITION_FRAC_BITS);
+   if (direction < 0)
+      position -= frac;
+   else
+      position += frac;
+   if (position > 0x7FFFFFFFLL)
+      position = 0x7FFFFFFFLL;
+   else if (position < -0x80000000LL)
+      position = -0x80000000LL;
+   *p_position = (int32_t)position;
+   return(0);
+}
+
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_prof_get
+*PURPOSE      : This function returns the thread hit counters of a microcode
+*               built with QD_PROFILING, see fs_etpu_eqd_h_prof_get.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*  p_prof          - This is a pointer to the structure the counters are
+*                    written to.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_prof_get(ETPU_MODULE etpu_module,
+                             uint8_t channel_primary,
+                             struct eqd_prof_t *p_prof)
+{
+   struct eqd_instance_t instance;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   fs_etpu_eqd_h_prof_get(&instance, p_prof);
+   return(0);
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_prof_reset
+*PURPOSE      : This function clears the thread hit counters of a microcode
+*               built with QD_PROFILING, see fs_etpu_eqd_h_prof_reset.
+*INPUTS NOTES : This function has 2 parameters:
+*
+*  etpu_module     - Selects eTPU-AB module or eTPU-C module (only available 
+*                    on select parts)
+*  channel_primary - This is the Primary channel number (Phase A).
+*                    0-31 for ETPU_A and 64-95 for ETPU_B.
+*
+*RETURNS NOTES: Error code that can be returned is: FS_ETPU_ERROR_VALUE.
+*******************************************************************************/
+int32_t fs_etpu_eqd_prof_reset(ETPU_MODULE etpu_module,
+                               uint8_t channel_primary)
+{
+   struct eqd_instance_t instance;
+
+   /* Parameters bounds check */
+   #ifdef FS_ETPU_MC_PARAM_CHECK
+   if(((channel_primary>31)&&(channel_primary<64))||(channel_primary>95))
+   {
+      return(FS_ETPU_ERROR_VALUE);
+   }
+   #endif
+
+   fs_etpu_eqd_resolve(etpu_module, channel_primary, &instance);
+   fs_etpu_eqd_h_prof_reset(&instance);
+   return(0);
+}
+
+/* Thread hit counters - all threads of the QD, QD HOME and QD INDEX channels
+   of the instance count in its frame */
+void fs_etpu_eqd_h_prof_get(const struct eqd_instance_t *p_instance,
+                            struct eqd_prof_t *p_prof)
+{
+   p_prof->init = *(p_instance->cpba + ((FS_ETPU_QD_PROF_INIT_OFFSET - 1)>>2)) & 0xffffff;
+   p_prof->slow_normal = *(p_instance->cpba + ((FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET - 1)>>2)) & 0xffffff;
+   p_prof->fast = *(p_instance->cpba + ((FS_ETPU_QD_PROF_FAST_OFFSET - 1)>>2)) & 0xffffff;
+   p_prof->overflow = *(p_instance->cpba + ((FS_ETPU_QD_PROF_OVERFLOW_OFFSET - 1)>>2)) & 0xffffff;
+   p_prof->index_home = *(p_instance->cpba + ((FS_ETPU_QD_PROF_INDEX_HOME_OFFSET - 1)>>2)) & 0xffffff;
+   p_prof->mode_switch = *(p_instance->cpba + ((FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET - 1)>>2)) & 0xffffff;
+}
+
+/* Clear the thread hit counters. A hit counted by a thread running at the
+   same time may be lost. */
+void fs_etpu_eqd_h_prof_reset(const struct eqd_instance_t *p_instance)
+{
+   *(p_instance->cpba + ((FS_ETPU_QD_PROF_INIT_OFFSET - 1)>>2)) = 0;
+   *(p_instance->cpba + ((FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET - 1)>>2)) = 0;
+   *(p_instance->cpba + ((FS_ETPU_QD_PROF_FAST_OFFSET - 1)>>2)) = 0;
+   *(p_instance->cpba + ((FS_ETPU_QD_PROF_OVERFLOW_OFFSET - 1)>>2)) = 0;
+   *(p_instance->cpba + ((FS_ETPU_QD_PROF_INDEX_HOME_OFFSET - 1)>>2)) = 0;
+   *(p_instance->cpba + ((FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET - 1)>>2)) = 0;
+}
+
+/*******************************************************************************
+*FUNCTION     : fs_etpu_eqd_prof_utilization
+*PURPOSE      : This function estimates the eTPU engine utilization of one
+*               QD axis from its thread hit counters, using the
+*               FS_ETPU_QD_PROF_*_INSTR instruction counts.
+*INPUTS NOTES : This function has 3 parameters:
+*
+*  p_prof          - This is a pointer to the counters collected over the
+*                    interval, e.g. read after fs_etpu_eqd_prof_reset. The
+*                    24-bit counters must not wrap within the interval.
+*  etpu_clock_freq - This is the eTPU engine (system) clock frequency in Hz.
+*  interval_us     - This is the counting interval in microseconds.
+*
+*RETURNS NOTES: Utilization, FS_ETPU_QD_PROF_UTIL_FULL = 100 % (not limited).
+*               0 when the interval is 0.
+*******************************************************************************/
+uint32_t fs_etpu_eqd_prof_utilization(const struct eqd_prof_t *p_prof,
+                                      uint32_t etpu_clock_freq,
+                                      uint32_t interval_us)
+{
+   unsigned long long clocks;
+   unsigned long long interval_clocks;
+
+   clocks = (unsigned long long)p_prof->init * FS_ETPU_QD_PROF_INIT_INSTR +
+            (unsigned long long)p_prof->slow_normal * FS_ETPU_QD_PROF_SLOW_NORMAL_INSTR +
+            (unsigned long long)p_prof->fast * FS_ETPU_QD_PROF_FAST_INSTR +
+            (unsigned long long)p_prof->overflow * FS_ETPU_QD_PROF_OVERFLOW_INSTR +
+            (unsigned long long)p_prof->index_home * FS_ETPU_QD_PROF_INDEX_HOME_INSTR +
+            (unsigned long long)p_prof->mode_switch * FS_ETPU_QD_PROF_MODE_SWITCH_INSTR;
+   clocks *= FS_ETPU_QD_PROF_CLKS_PER_INSTR;
+   interval_clocks = (unsigned long long)interval_us * etpu_clock_freq / 1000000;
+   if (interval_clocks == 0)
+   {
+      return(0);
+   }
+   return((uint32_t)(clocks * FS_ETPU_QD_PROF_UTIL_FULL / interval_clocks));
+}
+#endif
+
 
 /*******************************************************************************
 *=============== TPU3 API Compatibility Functions ==============================
@@ -1180,6 +3554,7 @@ void tpu_fqd_init(struct TPU3_tag *tpu,
                   uint8_t priority,
                   int16_t init_position)
 {
+   (void)tpu;
    fs_etpu_qd_init( channel,
                     0,
                     0,
@@ -1206,6 +3581,7 @@ void tpu_fqd_init(struct TPU3_tag *tpu,
 uint8_t tpu_fqd_current_mode(struct TPU3_tag *tpu,
                            uint8_t channel)
 {
+   (void)tpu;
    return ((uint8_t)fs_etpu_qd_get_mode(channel));
 }
 
@@ -1222,6 +3598,7 @@ uint8_t tpu_fqd_current_mode(struct TPU3_tag *tpu,
 int16_t tpu_fqd_position(struct TPU3_tag *tpu,
                        uint8_t channel)
 {
+   (void)tpu;
    return((int16_t)fs_etpu_qd_get_pc(channel));
 }
 
@@ -1248,6 +3625,7 @@ void tpu_fqd_data(struct TPU3_tag *tpu,
                   int16_t *primary_pin,
                   int16_t *secondary_pin)
 {
+   (void)tpu;
    *tcr1=(int16_t)(eTPU_AB->TB1R_A.R);
    *edge=(int16_t)(fs_etpu_qd_get_tcr(channel));
    *primary_pin  =(int16_t)(fs_etpu_qd_get_pinA(channel));
@@ -70,12 +70,258 @@
 #define FS_ETPU_QD_MODE_SLOW             (1) /* Slow mode */
 #define FS_ETPU_QD_MODE_NORMAL           (2) /* Normal mode */
 #define FS_ETPU_QD_MODE_FAST             (4) /* Fast mode */
+#define FS_ETPU_QD_MODE_ULTRA_FAST       (0x20) /* Ultra fast mode */
+#define FS_ETPU_QD_MODE_TCR2             (0x40) /* TCR2 counting mode */
+#define FS_ETPU_QD_MODE_MASK             (0x67) /* mode bits of mode_current */
+
+/* maximum number of re-reads done by fs_etpu_eqd_h_get_state_seq */
+#define FS_ETPU_QD_SEQ_RETRY_MAX         (8)
+
+/* edge ring modes */
+#define FS_ETPU_QD_EDGE_RING_DMA         (0) /* Drained by DMA, no flow control. */
+#define FS_ETPU_QD_EDGE_RING_POLLED      (1) /* Read by host, full ring drops records. */
+
+/* edge ring size limits (records of 8 bytes) */
+#define FS_ETPU_QD_EDGE_RING_MIN         (2)
+#define FS_ETPU_QD_EDGE_RING_MAX         (64)
+
+/* edge history size limits (entries) */
+#define FS_ETPU_QD_EDGE_HISTORY_MIN      (4)
+#define FS_ETPU_QD_EDGE_HISTORY_MAX      (64)
+
+/* maximum number of periods in the period average (a power of two) */
+#define FS_ETPU_QD_PERIOD_AVG_MAX        (64)
+
+/* maximum number of entries of a position trigger table */
+#define FS_ETPU_QD_TRIGGER_MAX           (64)
+
+/* pc_interrupt coalescing - maximum minimum interval (TCR ticks) */
+#define FS_ETPU_QD_IRQ_MIN_INTERVAL_MAX  (0x7FFFFF)
+
+/* standstill detection - maximum timeout (TCR ticks) */
+#define FS_ETPU_QD_STANDSTILL_TIMEOUT_MAX (0x7FFFFF)
+
+/* standstill detection - interrupt_enable */
+#define FS_ETPU_QD_STANDSTILL_IRQ_ENABLE (1)
+
+/* FAST mode reversal detection - enable */
+#define FS_ETPU_QD_FAST_REVERSAL_ENABLE  (1)
+
+/* ultra fast mode - maximum period threshold (TCR ticks) */
+#define FS_ETPU_QD_ULTRA_FAST_PERIOD_MAX (0x3FFFFF)
+
+/* TCR2 counting mode - maximum period threshold and interval (TCR1 ticks) */
+#define FS_ETPU_QD_TCR2_PERIOD_MAX       (0x3FFFFF)
+
+/* number of fractional bits of the interpolated position */
+#define FS_ETPU_QD_POSITION_FRAC_BITS    (8)
+
+/* QD_PROFILING - estimated eTPU instructions per counted thread, including
+   the thread entry, and per mode switch on top of its thread. Estimates of
+   the typical paths; override them with the figures of the ETEC analysis
+   file of the actual build. */
+#ifndef FS_ETPU_QD_PROF_INIT_INSTR
+#define FS_ETPU_QD_PROF_INIT_INSTR        (40)
+#define FS_ETPU_QD_PROF_SLOW_NORMAL_INSTR (70)
+#define FS_ETPU_QD_PROF_FAST_INSTR        (80)
+#define FS_ETPU_QD_PROF_OVERFLOW_INSTR    (25)
+#define FS_ETPU_QD_PROF_INDEX_HOME_INSTR  (40)
+#define FS_ETPU_QD_PROF_MODE_SWITCH_INSTR (30)
+#endif
+
+/* QD_PROFILING - system clocks per eTPU instruction */
+#define FS_ETPU_QD_PROF_CLKS_PER_INSTR    (2)
+
+/* QD_PROFILING - engine utilization of 100 % */
+#define FS_ETPU_QD_PROF_UTIL_FULL         (10000)
+
+/* QD period (4 Position Counter increments) in TCR ticks for the speed rpm,
+   rounded to nearest. freq is the TCR frequency in [Hz], ppr the number of
+   Position Counter increments per revolution. A constant expression when all
+   arguments are constants; rpm of zero gives zero. */
+#define FS_ETPU_QD_RPM_TO_PERIOD(freq, ppr, rpm) \
+   (((unsigned long long)(ppr)*(rpm) == 0) ? 0ULL : \
+    ((240ULL*(freq) + ((unsigned long long)(ppr)*(rpm))/2) / \
+     ((unsigned long long)(ppr)*(rpm) + ((unsigned long long)(ppr)*(rpm) == 0))))
+
+/* Nonzero when the FS_ETPU_QD_RPM_TO_PERIOD result fits the 24-bit threshold
+   parameters. Can be used to check constant configurations at compile time:
+   typedef char qd_check[FS_ETPU_QD_RPM_TO_PERIOD_VALID(f, ppr, rpm) ? 1 : -1]; */
+#define FS_ETPU_QD_RPM_TO_PERIOD_VALID(freq, ppr, rpm) \
+   (FS_ETPU_QD_RPM_TO_PERIOD(freq, ppr, rpm) <= 0xffffffULL)
+
+/* maximum number of axes read by fs_etpu_eqd_h_read_many (32 at most) */
+#ifndef FS_ETPU_QD_MAX_AXES
+#define FS_ETPU_QD_MAX_AXES              (16)
+#endif
+
+/*******************************************************************************
+*                       Type Definitions
+*******************************************************************************/
+/* QD instance, filled by fs_etpu_eqd_init_instance. The channel parameter
+   base is resolved once so the fs_etpu_eqd_h_* accessors need no eTPU
+   register access. */
+struct eqd_instance_t
+{
+   ETPU_MODULE em;                /* eTPU module (EM_AB or EM_C) */
+   uint8_t   chan_primary;        /* Primary channel (Phase A) */
+   uint8_t   chan_secondary;      /* Secondary channel (Phase B) */
+   uint8_t   chan_home;           /* Home channel */
+   uint8_t   chan_index;          /* Index channel */
+   uint8_t   signals;             /* FS_ETPU_QD_PRIM_SEC... */
+   uint8_t   priority;            /* channel priority */
+   uint32_t  *cpba;               /* channel parameter base address */
+   uint32_t  *cpba_pse;           /* channel parameter base address in the
+                                     sign-extended (PSE) DATA RAM mirror */
+   uint32_t  seq_retries;         /* statistics - number of re-reads done by
+                                     fs_etpu_eqd_h_get_state_seq */
+   /* buffers allocated by the fs_etpu_eqd_h_*_init functions of this
+      instance, none in an instance filled by fs_etpu_eqd_get_instance */
+   uint32_t  *edge_ring;          /* edge ring records, 2 words each:
+                                     [0] bits 31-24 direction, 23-0 last_edge
+                                     [1] bits 31-24 record sequence number,
+                                         23-0 pc */
+   uint24_t  edge_ring_size;      /* number of edge ring records */
+   uint32_t  *edge_hist;          /* edge history entries, 1 word each:
+                                     bits 31-24 direction, 23-0 edge TCR */
+   uint8_t   edge_hist_size;      /* number of allocated history entries
+                                     (requested number + 1) */
+   uint32_t  *period_avg_buf;     /* period average buffer, 1 period each */
+   uint32_t  *trig_buf;           /* two trigger table buffers of trig_size
+                                     entries, 1 word each: bits 31-24
+                                     actions, 23-0 position */
+   uint8_t   trig_size;           /* max. number of trigger table entries */
+   uint8_t   trig_bank;           /* buffer of the last loaded table */
+   uint32_t  recip_period;        /* period the recip value belongs to */
+   uint32_t  recip;               /* 0xFFFFFFFF / recip_period, used by
+                                     fs_etpu_eqd_h_get_position_at */
+   int24_t   align_pc;            /* pc to be set by fs_etpu_eqd_h_align_poll */
+   uint32_t  align_polls;         /* remaining polls before align timeout */
+   uint8_t   align_pending;       /* 1 while an align is in progress */
+};
+
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+/* Position trigger table entry, see fs_etpu_eqd_h_trigger_load. */
+struct eqd_trigger_t
+{
+   int24_t   position;    /* Position Counter value */
+   uint8_t   actions;     /* FS_ETPU_QD_TRIGGER_INTERRUPT, _DMA and/or _LINK */
+};
+#endif
+
+/* Snapshot of the QD outputs, filled by the fs_etpu_eqd_*get_state* functions. */
+struct eqd_state_t
+{
+   int24_t   pc;          /* Position Counter */
+   int24_t   pc_sc;       /* Position Counter for SC */
+   int24_t   rc;          /* Revolution Counter */
+   uint32_t  period;      /* QD period (32-bit) */
+   uint24_t  last_edge;   /* TCR time of the last transition */
+   int8_t    direction;   /* FS_ETPU_QD_DIRECTION_INC or _DEC */
+   uint8_t   mode;        /* FS_ETPU_QD_MODE_SLOW, _NORMAL, _FAST, _ULTRA_FAST or _TCR2 */
+   uint8_t   pins;        /* Phase A (bit 0) and Phase B (bit 1) pin states */
+   uint8_t   error_flags; /* current error flags */
+   uint8_t   coherent;    /* 1 when all values belong to the same QD
+                             update, 0 otherwise */
+};
+
+/* QD outputs of several axes, filled by fs_etpu_eqd_h_read_many. Array
+   index i holds the outputs of the i-th instance. */
+struct eqd_readout_t
+{
+   int24_t   pc[FS_ETPU_QD_MAX_AXES];          /* Position Counter */
+   int24_t   pc_sc[FS_ETPU_QD_MAX_AXES];       /* Position Counter for SC */
+   int24_t   rc[FS_ETPU_QD_MAX_AXES];          /* Revolution Counter */
+   uint32_t  period[FS_ETPU_QD_MAX_AXES];      /* QD period (32-bit) */
+   uint24_t  last_edge[FS_ETPU_QD_MAX_AXES];   /* TCR time of the last transition */
+   int8_t    direction[FS_ETPU_QD_MAX_AXES];   /* FS_ETPU_QD_DIRECTION_INC or _DEC */
+   uint8_t   mode[FS_ETPU_QD_MAX_AXES];        /* FS_ETPU_QD_MODE_SLOW, _NORMAL, _FAST, _ULTRA_FAST or _TCR2 */
+   uint8_t   error_flags[FS_ETPU_QD_MAX_AXES]; /* current error flags */
+   uint32_t  incoherent;  /* bit i set when axis i was updated during the
+                             read, so its values may not belong together */
+};
+
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+/* QD_ERROR_COUNTERS error counters, filled by the
+   fs_etpu_eqd_*get_error_counters functions. Saturated at
+   FS_ETPU_QD_ERROR_COUNT_MAX. */
+struct eqd_error_counters_t
+{
+   uint16_t  illegal;     /* illegal transitions (FS_ETPU_QD_ERROR_ILLEGAL) */
+   uint16_t  window;      /* window ends without an edge (FS_ETPU_QD_ERROR_WINDOWING) */
+   uint16_t  spurious;    /* spurious edges (FS_ETPU_QD_ERROR_SPURIOUS) */
+};
+#endif
+
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+/* QD_PROFILING thread hit counters, filled by the fs_etpu_eqd_*prof_get
+   functions. 24-bit, wrapping. */
+struct eqd_prof_t
+{
+   uint24_t  init;        /* Init threads and host service requests */
+   uint24_t  slow_normal; /* Slow and Normal mode edges */
+   uint24_t  fast;        /* Fast, Ultra Fast and TCR2 mode edges and matches */
+   uint24_t  overflow;    /* period overflow and standstill matches */
+   uint24_t  index_home;  /* Index and Home transitions and overflows */
+   uint24_t  mode_switch; /* mode switches, within the threads above */
+};
+#endif
 
 /*******************************************************************************
 *                       Function Prototypes
 *******************************************************************************/
 
+/* QD Phase A, Phase B, Home and Index channel initialization, thresholds in
+   TCR ticks. */
+int32_t fs_etpu_eqd_init_precomputed(struct eqd_instance_t *p_instance,
+                                     ETPU_MODULE etpu_module,
+                                     uint8_t   channel_primary,
+                                     uint8_t   channel_secondary,
+                                     uint8_t   channel_home,
+                                     uint8_t   channel_index,
+                                     uint8_t   signals,
+                                     uint8_t   priority,
+                                     uint8_t   configuration,
+                                     uint8_t   timer,
+                                     uint24_t  pc_max,
+                                     uint24_t  slow_normal_period,
+                                     uint24_t  normal_slow_period,
+                                     uint24_t  normal_fast_period,
+                                     uint24_t  fast_normal_period,
+                                     fract24_t window_ratio1,
+                                     fract24_t window_ratio2,
+                                     uint8_t   home_transition,
+                                     uint8_t   index_pulse,
+                                     uint8_t   index_pc_reset);
+
+/* Convert a speed threshold in [rpm] to a QD period in TCR ticks. */
+uint24_t fs_etpu_eqd_rpm_to_period(uint32_t etpu_tcr_freq,
+                                   uint24_t pc_per_rev,
+                                   uint24_t rpm);
+
 /* QD Phase A, Phase B, Home and Index channel initialization. */
+int32_t fs_etpu_eqd_init_instance(struct eqd_instance_t *p_instance,
+                                  ETPU_MODULE etpu_module,
+                                  uint8_t   channel_primary,
+                                  uint8_t   channel_secondary,
+                                  uint8_t   channel_home,
+                                  uint8_t   channel_index,
+                                  uint8_t   signals,
+                                  uint8_t   priority,
+                                  uint8_t   configuration,
+                                  uint8_t   timer,
+                                  uint24_t  pc_max,
+                                  uint24_t  slow_normal_threshold,
+                                  uint24_t  normal_slow_threshold,
+                                  uint24_t  normal_fast_threshold,
+                                  uint24_t  fast_normal_threshold,
+                                  fract24_t window_ratio1,
+                                  fract24_t window_ratio2,
+                                  uint8_t   home_transition,
+                                  uint8_t   index_pulse,
+                                  uint8_t   index_pc_reset,
+                                  uint32_t  etpu_tcr_freq,
+                                  uint24_t  pc_per_rev);
 int32_t fs_etpu_eqd_init(ETPU_MODULE etpu_module,
                          uint8_t   channel_primary,
                          uint8_t   channel_secondary,
@@ -150,6 +396,10 @@ int32_t fs_etpu_eqd_align(ETPU_MODULE etpu_module,
                           int24_t pc);
 int32_t fs_etpu_qd_align(uint8_t channel_primary,
                          int24_t pc);
+int32_t fs_etpu_eqd_h_align_start(struct eqd_instance_t *p_instance,
+                                  int24_t pc,
+                                  uint32_t timeout_polls);
+int32_t fs_etpu_eqd_h_align_poll(struct eqd_instance_t *p_instance);
 
 /* Set QD pc_interrupt values. */
 int32_t fs_etpu_eqd_set_pc_interrupts(ETPU_MODULE etpu_module,
@@ -170,6 +420,52 @@ int32_t fs_etpu_eqd_disable_pc_interrupts(ETPU_MODULE etpu_module,
                                           uint8_t channel_primary);
 int32_t fs_etpu_qd_disable_pc_interrupts(uint8_t channel_primary);
 
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+/* Set QD pc_interrupt coalescing of a QD_PC_IRQ_COALESCING build. */
+int32_t fs_etpu_eqd_set_pc_interrupt_coalescing(ETPU_MODULE etpu_module,
+                                                uint8_t channel_primary,
+                                                uint24_t min_interval,
+                                                uint8_t hysteresis,
+                                                uint8_t rev_divider);
+
+/* Get the number of pc_interrupts suppressed by coalescing. */
+uint24_t fs_etpu_eqd_get_pc_interrupts_suppressed(ETPU_MODULE etpu_module,
+                                                  uint8_t channel_primary);
+#endif
+
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+/* Set QD standstill detection of a QD_STANDSTILL build. */
+int32_t fs_etpu_eqd_set_standstill(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   uint24_t timeout,
+                                   uint8_t interrupt_enable);
+
+/* Get the QD standstill flag. */
+uint8_t fs_etpu_eqd_get_standstill(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary);
+#endif
+
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+/* Enable or disable QD reversal detection in FAST mode, of a
+   QD_FAST_REVERSAL build. */
+int32_t fs_etpu_eqd_set_fast_reversal(ETPU_MODULE etpu_module,
+                                      uint8_t channel_primary,
+                                      uint8_t enable);
+#endif
+
+/* Set QD ultra fast mode thresholds. */
+int32_t fs_etpu_eqd_set_ultra_fast(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   uint24_t fast_ultra_period,
+                                   uint24_t ultra_fast_period);
+
+/* Set QD TCR2 counting mode thresholds and interval. */
+int32_t fs_etpu_eqd_set_tcr2_counting(ETPU_MODULE etpu_module,
+                                      uint8_t channel_primary,
+                                      uint24_t fast_tcr2_period,
+                                      uint24_t tcr2_fast_period,
+                                      uint24_t interval);
+
 /* Change QD Position Counter. */
 int32_t fs_etpu_eqd_set_pc(ETPU_MODULE etpu_module,
                            uint8_t channel_primary,
@@ -219,11 +515,32 @@ uint24_t fs_etpu_eqd_get_tcr(ETPU_MODULE etpu_module,
                              uint8_t channel_primary);
 uint24_t fs_etpu_qd_get_tcr(uint8_t channel_primary);
 
+/* Get TCR time of the last transition with the wrap extension (32-bit). */
+uint32_t fs_etpu_eqd_get_tcr32(ETPU_MODULE etpu_module,
+                               uint8_t channel_primary);
+
 /* Get period. */
 uint32_t fs_etpu_eqd_get_period(ETPU_MODULE etpu_module,
                                 uint8_t channel_primary);
 uint24_t fs_etpu_qd_get_period(uint8_t channel_primary);
 
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+/* Get moving average period. */
+uint32_t fs_etpu_eqd_get_period_avg(ETPU_MODULE etpu_module,
+                                    uint8_t channel_primary);
+#endif
+
+/* Get the revolution period measured on the index channel. */
+int32_t fs_etpu_eqd_get_rev_period(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   uint32_t *p_rev_period,
+                                   uint8_t *p_rev_period_ext);
+
+/* Get the 48-bit absolute position. */
+int32_t fs_etpu_eqd_get_position64(ETPU_MODULE etpu_module,
+                                   uint8_t channel_primary,
+                                   long long *p_position);
+
 /* Get the state of Phase A input channel on last transition. */
 uint8_t fs_etpu_eqd_get_pinA(ETPU_MODULE etpu_module,
                              uint8_t channel_primary);
@@ -242,6 +559,131 @@ uint8_t fs_etpu_eqd_get_latched_error_flags(ETPU_MODULE etpu_module,
 int32_t fs_etpu_eqd_latch_and_clear_error_flags(ETPU_MODULE etpu_module,
                                                 uint8_t channel_primary);
 
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+/* Get the QD error counters of a QD_ERROR_COUNTERS build. */
+int32_t fs_etpu_eqd_get_error_counters(ETPU_MODULE etpu_module,
+                                       uint8_t channel_primary,
+                                       struct eqd_error_counters_t *p_counters);
+#endif
+
+/* Get a snapshot of all QD outputs in one pass. */
+int32_t fs_etpu_eqd_get_state(ETPU_MODULE etpu_module,
+                              uint8_t channel_primary,
+                              struct eqd_state_t *p_state);
+
+/* Resolve a QD instance of already initialized channels. */
+int32_t fs_etpu_eqd_get_instance(ETPU_MODULE etpu_module,
+                                 uint8_t channel_primary,
+                                 struct eqd_instance_t *p_instance);
+
+/* Instance based accessors - no eTPU register access. */
+int24_t  fs_etpu_eqd_h_get_pc(const struct eqd_instance_t *p_instance);
+int24_t  fs_etpu_eqd_h_get_pc_sc(const struct eqd_instance_t *p_instance);
+int24_t  fs_etpu_eqd_h_get_rc(const struct eqd_instance_t *p_instance);
+int8_t   fs_etpu_eqd_h_get_direction(const struct eqd_instance_t *p_instance);
+uint8_t  fs_etpu_eqd_h_get_mode(const struct eqd_instance_t *p_instance);
+uint24_t fs_etpu_eqd_h_get_tcr(const struct eqd_instance_t *p_instance);
+uint32_t fs_etpu_eqd_h_get_period(const struct eqd_instance_t *p_instance);
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+uint32_t fs_etpu_eqd_h_get_period_avg(const struct eqd_instance_t *p_instance);
+#endif
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+uint8_t  fs_etpu_eqd_h_get_standstill(const struct eqd_instance_t *p_instance);
+#endif
+uint8_t  fs_etpu_eqd_h_get_pinA(const struct eqd_instance_t *p_instance);
+uint8_t  fs_etpu_eqd_h_get_pinB(const struct eqd_instance_t *p_instance);
+uint8_t  fs_etpu_eqd_h_get_current_error_flags(const struct eqd_instance_t *p_instance);
+uint8_t  fs_etpu_eqd_h_get_latched_error_flags(const struct eqd_instance_t *p_instance);
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+void     fs_etpu_eqd_h_get_error_counters(const struct eqd_instance_t *p_instance,
+                                          struct eqd_error_counters_t *p_counters);
+#endif
+int32_t  fs_etpu_eqd_h_get_state(const struct eqd_instance_t *p_instance,
+                                 struct eqd_state_t *p_state);
+
+/* Get a tear-free snapshot of all QD outputs using the sequence counter. */
+int32_t  fs_etpu_eqd_h_get_state_seq(struct eqd_instance_t *p_instance,
+                                     struct eqd_state_t *p_state);
+
+/* Get the revolution period measured on the index channel (40-bit). */
+int32_t  fs_etpu_eqd_h_get_rev_period(struct eqd_instance_t *p_instance,
+                                      uint32_t *p_rev_period,
+                                      uint8_t  *p_rev_period_ext);
+
+/* Get the 32-bit (wrap extended) edge times using the sequence counter. */
+int32_t  fs_etpu_eqd_h_get_tcr32(struct eqd_instance_t *p_instance,
+                                 uint32_t *p_last_edge,
+                                 uint32_t *p_last_leading_edge);
+
+/* Get the 48-bit absolute position using the sequence counter. */
+int32_t  fs_etpu_eqd_h_get_position64(struct eqd_instance_t *p_instance,
+                                      long long *p_position);
+
+#ifdef FS_ETPU_QD_RING_START_OFFSET
+/* Leading edge record ring of a QD_EDGE_RING build. */
+int32_t  fs_etpu_eqd_h_edge_ring_init(struct eqd_instance_t *p_instance,
+                                      uint16_t num_records,
+                                      uint8_t  mode);
+uint24_t fs_etpu_eqd_h_edge_ring_get_wr_index(const struct eqd_instance_t *p_instance);
+uint24_t fs_etpu_eqd_h_edge_ring_get_overflow(const struct eqd_instance_t *p_instance);
+uint8_t  fs_etpu_eqd_edge_ring_lost(const uint32_t *p_prev_record,
+                                    const uint32_t *p_record);
+int32_t  fs_etpu_eqd_h_edge_ring_set_rd_index(const struct eqd_instance_t *p_instance,
+                                              uint24_t rd_index);
+#endif
+
+#ifdef FS_ETPU_QD_HIST_START_OFFSET
+/* Edge history - the most recent edge times, of a QD_EDGE_HISTORY build. */
+int32_t  fs_etpu_eqd_h_edge_history_init(struct eqd_instance_t *p_instance,
+                                         uint8_t num_entries);
+int32_t  fs_etpu_eqd_h_edge_history_get(struct eqd_instance_t *p_instance,
+                                        uint8_t num_entries,
+                                        uint32_t *p_entries);
+#endif
+
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+/* Moving average of the last 2^n periods, of a QD_PERIOD_AVG build. */
+int32_t  fs_etpu_eqd_h_period_avg_init(struct eqd_instance_t *p_instance,
+                                       uint8_t num_periods);
+#endif
+
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+/* Double-buffered position trigger table of a QD_TRIGGER_TABLE build. */
+int32_t  fs_etpu_eqd_h_trigger_init(struct eqd_instance_t *p_instance,
+                                    uint8_t max_triggers,
+                                    uint8_t link_chan);
+int32_t  fs_etpu_eqd_h_trigger_load(struct eqd_instance_t *p_instance,
+                                    const struct eqd_trigger_t *p_triggers,
+                                    uint8_t num_triggers);
+uint32_t fs_etpu_eqd_h_trigger_get_last(const struct eqd_instance_t *p_instance);
+#endif
+
+/* Read the outputs of several QD instances at once. */
+int32_t  fs_etpu_eqd_h_read_many(const struct eqd_instance_t *p_instances,
+                                 uint8_t num_axes,
+                                 struct eqd_readout_t *p_readout);
+
+/* Get position interpolated between edges at the given TCR time. */
+int32_t  fs_etpu_eqd_h_get_position_at(struct eqd_instance_t *p_instance,
+                                       uint24_t tcr_now,
+                                       int32_t  *p_position);
+
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+/* Thread hit counters of a QD_PROFILING build and the engine utilization
+   estimated from them. */
+int32_t  fs_etpu_eqd_prof_get(ETPU_MODULE etpu_module,
+                              uint8_t channel_primary,
+                              struct eqd_prof_t *p_prof);
+int32_t  fs_etpu_eqd_prof_reset(ETPU_MODULE etpu_module,
+                                uint8_t channel_primary);
+void     fs_etpu_eqd_h_prof_get(const struct eqd_instance_t *p_instance,
+                                struct eqd_prof_t *p_prof);
+void     fs_etpu_eqd_h_prof_reset(const struct eqd_instance_t *p_instance);
+uint32_t fs_etpu_eqd_prof_utilization(const struct eqd_prof_t *p_prof,
+                                      uint32_t etpu_clock_freq,
+                                      uint32_t interval_us);
+#endif
+
 /*******************************************************************************
 *======================== for TPU3 API Compatibility ===========================
 *******************************************************************************/
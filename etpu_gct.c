@@ -43,7 +43,11 @@ uint32_t *fs_etpu_c_free_param;
 
 /* counter frequencies */
 uint32_t etpu_a_tcr1_freq = 100000000/2;
+#if QD_TCR2_TCRCLK
+uint32_t etpu_a_tcr2_freq = 0;           /* TCRCLK edges, no fixed frequency */
+#else
 uint32_t etpu_a_tcr2_freq = 100000000/8;
+#endif
 uint32_t etpu_b_tcr1_freq = 100000000/2;
 uint32_t etpu_b_tcr2_freq = 100000000/8;
 uint32_t etpu_c_tcr1_freq = 0;
@@ -76,7 +80,11 @@ struct etpu_config_t my_etpu_config =
   | FS_ETPU_TCR1CS_DIV2 /* TCR1 clock source = div 2 (TCR1CS=0)*/
   | FS_ETPU_TCR1CTL_DIV2 /* TCR1 source = div 2 (TCR1CTL=2) */
   | FS_ETPU_TCR1_PRESCALER(1) /* TCR1 prescaler = 1 (TCR1P=0) */
+#if QD_TCR2_TCRCLK
+  | FS_ETPU_TCR2CTL_RISEFALL /* TCR2 source = TCRCLK rise and fall, QD phase A (TCR2CTL=3) */
+#else
   | FS_ETPU_TCR2CTL_DIV8 /* TCR2 source = etpuclk div 8 (TCR2CTL=4) */
+#endif
   | FS_ETPU_TCR2_PRESCALER(1) /* TCR2 prescaler = 1 (TCR2P=0) */
   | FS_ETPU_ANGLE_MODE_DISABLE, /* TCR2 angle mode is disabled (AM=0) */
 
@@ -242,7 +250,7 @@ int32_t my_system_etpu_init(void)
   int32_t err_code;
 
   /* Initialization of eTPU DATA RAM */
-  fs_memset32_ext((uint32_t*)fs_etpu_data_ram_start, 0, fs_etpu_data_ram_end - fs_etpu_data_ram_start);
+  fs_memset32_ext((uint32_t*)(unsigned long)fs_etpu_data_ram_start, 0, fs_etpu_data_ram_end - fs_etpu_data_ram_start);
 
   /* Initialization of eTPU global settings */
   err_code = fs_etpu_init_ext(
@@ -43,6 +43,13 @@
 #define RPM2FRACT(rpm, period_ns) \
                 ((rpm) * NSEC2TCR1(period_ns) / TCR1_FREQ_HZ * (0x1000000 / 60))
 
+/* 1: TCR2 of engine A counts the TCRCLK rise and fall; wire QD phase A to
+   TCRCLK as well for the QD TCR2 counting mode (fs_etpu_eqd_set_tcr2_counting).
+   0 (default): TCR2 runs from the eTPU clock */
+#ifndef QD_TCR2_TCRCLK
+#define QD_TCR2_TCRCLK                                                        0
+#endif
+
 #define DEG2FRACT(deg)                                       ((deg)*0x200000/45)
 #define FRACT2DEG(angle_fract)                             ((angle)*45/0x200000)
 /*******************************************************************************
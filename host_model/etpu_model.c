@@ -0,0 +1,840 @@
+/**************************************************************************
+ * FILE NAME: etpu_model.c
+ *
+ * DESCRIPTION:
+ * Behavioral model of the eTPU_AB module for Linux (x86-64) hosts - memory
+ * images, register side effects, channel hardware and scheduler. See
+ * etpu_model.h.
+ *
+ * Memory: one shared memory object holds the register block, DATA RAM, the
+ * DATA RAM mirror and code memory. It is mapped at the MPC5554 addresses
+ * for the host code and a second time (alias) for the model. On the fixed
+ * mapping the register page is read-only and the mirror page inaccessible,
+ * so host writes to registers and any host mirror access raise SIGSEGV.
+ * The handler unprotects the page and sets the x86 trap flag; after the
+ * access has executed, SIGTRAP re-protects the page, compares the page to
+ * a snapshot and applies the hardware side effects.
+ *
+ * Time: the model runs at ETPU_MODEL_CLOCK_HZ. Threads execute in zero
+ * time at the instant their request is serviced; requests still pending
+ * after ETPU_MODEL_MAX_PASSES scheduler passes (e.g. a thread linking to
+ * itself) are serviced in further ETPU_MODEL_SERVICE_CLKS time slots.
+ * Channel priorities are not modeled - pending channels are serviced
+ * round-robin.
+ **************************************************************************/
+#define _GNU_SOURCE
+#include <signal.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "etpu_model.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE   0x100000
+#endif
+
+/*******************************************************************************
+*                            Definitions
+*******************************************************************************/
+#define ETPU_MODEL_BASE        0xC3FC0000UL
+#define ETPU_MODEL_SIZE        0x14000UL   /* registers up to the end of code */
+#define ETPU_MODEL_PAGE        0x1000UL
+#define ETPU_MODEL_REG_OFFSET  0x0000UL
+#define ETPU_MODEL_RAM_OFFSET  0x8000UL
+#define ETPU_MODEL_RAM_SIZE    0x0C00UL
+#define ETPU_MODEL_PSE_OFFSET  0xC000UL
+#define ETPU_MODEL_SCMSIZE     7           /* (7+1)*2KB code memory */
+
+#define ETPU_MODEL_TRAP_NONE   0
+#define ETPU_MODEL_TRAP_REGS   1
+#define ETPU_MODEL_TRAP_PSE    2
+
+#define ETPU_MODEL_EFLAGS_TF   0x100
+
+#define ETPU_MODEL_NEVER       (~0ULL)
+
+/* SCR bits */
+#define ETPU_MODEL_SCR_CIS     0x80000000
+#define ETPU_MODEL_SCR_CIOS    0x40000000
+#define ETPU_MODEL_SCR_DTRS    0x00800000
+#define ETPU_MODEL_SCR_DTROS   0x00400000
+#define ETPU_MODEL_SCR_IPS     0x00008000
+#define ETPU_MODEL_SCR_FM      0x00000003
+
+_Static_assert(sizeof(struct eTPU_struct) <= ETPU_MODEL_RAM_OFFSET, "eTPU_struct size");
+_Static_assert(offsetof(struct eTPU_struct, CHAN) == 0x400, "eTPU_struct CHAN");
+
+/*******************************************************************************
+*                            Global Variables
+*******************************************************************************/
+struct etpu_model_chan_t etpu_model_chan[ETPU_MODEL_NUM_CHANNELS];
+struct etpu_model_stats_t etpu_model_stats;
+
+static uint8_t *etpu_model_alias;
+static volatile struct eTPU_struct *etpu_model_regs;
+static uint32_t *etpu_model_ram;
+static uint32_t *etpu_model_pse;
+static etpu_model_function_t etpu_model_functions[ETPU_MODEL_NUM_FUNCTIONS];
+
+static unsigned long long etpu_model_clk;
+static unsigned long long etpu_model_tcr_start;
+static uint8_t  etpu_model_tcr_running;
+static uint32_t etpu_model_tcr1_div;
+static uint32_t etpu_model_tcr2_div;
+static uint8_t  etpu_model_tcr2_ctl;       /* TBCR_A TCR2CTL at the time base start */
+static uint32_t etpu_model_tcr2_count;     /* TCR2 clocked by TCRCLK edges */
+static uint8_t  etpu_model_tcrclk;         /* TCRCLK input level */
+static uint8_t  etpu_model_deferred;
+
+static volatile int etpu_model_trap;
+static uint32_t etpu_model_trap_word;    /* register word written */
+static uint32_t etpu_model_snapshot[ETPU_MODEL_PAGE/4];
+
+static void etpu_model_service_all(uint8_t passes);
+
+/*******************************************************************************
+*                            Time Bases
+*******************************************************************************/
+static unsigned long long etpu_model_ticks(uint32_t div)
+{
+   if (!etpu_model_tcr_running)
+      return(0);
+   return((etpu_model_clk - etpu_model_tcr_start) / div);
+}
+
+uint24_t etpu_model_tcr1(void)
+{
+   return((uint24_t)etpu_model_ticks(etpu_model_tcr1_div) & 0xffffff);
+}
+
+uint24_t etpu_model_tcr2(void)
+{
+   if (ETPU_MODEL_TCR2_TCRCLK(etpu_model_tcr2_ctl))
+      return((uint24_t)etpu_model_tcr2_count & 0xffffff);
+   return((uint24_t)etpu_model_ticks(etpu_model_tcr2_div) & 0xffffff);
+}
+
+unsigned long long etpu_model_clocks(void)
+{
+   return(etpu_model_clk);
+}
+
+static void etpu_model_update_tbr(void)
+{
+   etpu_model_regs->TB1R_A.R = etpu_model_tcr1();
+   etpu_model_regs->TB2R_A.R = etpu_model_tcr2();
+   etpu_model_regs->TB1R_B.R = etpu_model_tcr1();
+   etpu_model_regs->TB2R_B.R = etpu_model_tcr2();
+}
+
+/* Clock of the first "greater or equal" match of a 24-bit match value, or of
+   the "equal only" match, which waits up to a full TCR wrap */
+static unsigned long long etpu_model_match_clk(uint24_t match, uint8_t tcr2, uint8_t equal_only)
+{
+   uint32_t div = tcr2 ? etpu_model_tcr2_div : etpu_model_tcr1_div;
+   unsigned long long ticks = etpu_model_ticks(div);
+   uint24_t delta;
+
+   if (tcr2 && ETPU_MODEL_TCR2_TCRCLK(etpu_model_tcr2_ctl))
+      ticks = etpu_model_tcr2_count;
+   delta = (match - (uint24_t)ticks) & 0xffffff;
+   if ((delta == 0) || (!equal_only && (delta > 0x800000)))
+      return(etpu_model_clk);
+   if (!etpu_model_tcr_running || (tcr2 && ETPU_MODEL_TCR2_TCRCLK(etpu_model_tcr2_ctl)))
+      return(ETPU_MODEL_NEVER);      /* not before the next TCRCLK edge */
+   return(etpu_model_tcr_start + (ticks + delta) * div);
+}
+
+/*******************************************************************************
+*                            Channel Hardware
+*******************************************************************************/
+static uint8_t etpu_model_ch(const struct etpu_model_ctx_t *p_ctx)
+{
+   return((uint8_t)((p_ctx->base + (p_ctx->chan & 0x1f)) % ETPU_MODEL_NUM_CHANNELS));
+}
+
+static struct etpu_model_chan_t *etpu_model_c(const struct etpu_model_ctx_t *p_ctx)
+{
+   return(&etpu_model_chan[etpu_model_ch(p_ctx)]);
+}
+
+uint8_t etpu_model_fm(const struct etpu_model_ctx_t *p_ctx)
+{
+   return((uint8_t)(etpu_model_regs->CHAN[etpu_model_ch(p_ctx)].SCR.R & ETPU_MODEL_SCR_FM));
+}
+
+uint8_t etpu_model_pin(const struct etpu_model_ctx_t *p_ctx)
+{
+   return(etpu_model_c(p_ctx)->pin);
+}
+
+void etpu_model_action_units(struct etpu_model_ctx_t *p_ctx, uint8_t tcr2)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->tcr2_a = tcr2 ? 1 : 0;
+   etpu_model_c(p_ctx)->tcr2_b = tcr2 ? 1 : 0;
+   etpu_model_c(p_ctx)->equal_a = 0;
+}
+
+void etpu_model_action_unit_a(struct etpu_model_ctx_t *p_ctx, uint8_t tcr2, uint8_t equal_only)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->tcr2_a = tcr2 ? 1 : 0;
+   etpu_model_c(p_ctx)->equal_a = equal_only ? 1 : 0;
+}
+
+void etpu_model_channel_mode(struct etpu_model_ctx_t *p_ctx, uint8_t mode)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->mode = mode;
+}
+
+void etpu_model_on_trans_a(struct etpu_model_ctx_t *p_ctx, uint8_t ipac)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->ipac_a = ipac;
+}
+
+void etpu_model_on_trans_b(struct etpu_model_ctx_t *p_ctx, uint8_t ipac)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->ipac_b = ipac;
+}
+
+void etpu_model_clear_all_latches(struct etpu_model_ctx_t *p_ctx)
+{
+   struct etpu_model_chan_t *c = etpu_model_c(p_ctx);
+
+   p_ctx->steps++;
+   c->mrla = c->mrlb = c->tdla = c->tdlb = 0;
+}
+
+void etpu_model_clear_trans_latch(struct etpu_model_ctx_t *p_ctx)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->tdla = 0;
+   etpu_model_c(p_ctx)->tdlb = 0;
+}
+
+void etpu_model_clear_match_a_latch(struct etpu_model_ctx_t *p_ctx)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->mrla = 0;
+}
+
+void etpu_model_clear_lsr(struct etpu_model_ctx_t *p_ctx)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->lsr = 0;
+}
+
+uint8_t etpu_model_trans_a_latched(const struct etpu_model_ctx_t *p_ctx)
+{
+   return(etpu_model_c(p_ctx)->tdla);
+}
+
+uint8_t etpu_model_trans_b_latched(const struct etpu_model_ctx_t *p_ctx)
+{
+   return(etpu_model_c(p_ctx)->tdlb);
+}
+
+uint8_t etpu_model_match_b_latched(const struct etpu_model_ctx_t *p_ctx)
+{
+   return(etpu_model_c(p_ctx)->mrlb);
+}
+
+void etpu_model_write_erta_match_a(struct etpu_model_ctx_t *p_ctx)
+{
+   struct etpu_model_chan_t *c = etpu_model_c(p_ctx);
+
+   p_ctx->steps++;
+   c->match_a = p_ctx->erta & 0xffffff;
+   c->mre_a = 1;
+   c->window_open = 0;
+}
+
+void etpu_model_write_ertb_match_b(struct etpu_model_ctx_t *p_ctx)
+{
+   struct etpu_model_chan_t *c = etpu_model_c(p_ctx);
+
+   p_ctx->steps++;
+   c->match_b = p_ctx->ertb & 0xffffff;
+   c->mre_b = 1;
+}
+
+void etpu_model_disable_matches(struct etpu_model_ctx_t *p_ctx)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->mre_a = 0;
+   etpu_model_c(p_ctx)->mre_b = 0;
+}
+
+void etpu_model_set_flag0(struct etpu_model_ctx_t *p_ctx, uint8_t value)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->flag0 = value ? 1 : 0;
+}
+
+void etpu_model_set_flag1(struct etpu_model_ctx_t *p_ctx, uint8_t value)
+{
+   p_ctx->steps++;
+   etpu_model_c(p_ctx)->flag1 = value ? 1 : 0;
+}
+
+void etpu_model_link(struct etpu_model_ctx_t *p_ctx, uint8_t chan)
+{
+   p_ctx->steps++;
+   etpu_model_chan[(p_ctx->base + (chan & 0x1f)) % ETPU_MODEL_NUM_CHANNELS].lsr = 1;
+}
+
+void etpu_model_channel_interrupt(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t ch = etpu_model_ch(p_ctx);
+
+   p_ctx->steps++;
+   etpu_model_regs->CHAN[ch].SCR.R |= ETPU_MODEL_SCR_CIS;
+   if (ch < 64)
+      etpu_model_regs->CISR_A.R |= (1UL << (ch & 0x1f));
+   else
+      etpu_model_regs->CISR_B.R |= (1UL << (ch & 0x1f));
+}
+
+void etpu_model_data_transfer_request(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t ch = etpu_model_ch(p_ctx);
+
+   p_ctx->steps++;
+   etpu_model_regs->CHAN[ch].SCR.R |= ETPU_MODEL_SCR_DTRS;
+   if (ch < 64)
+      etpu_model_regs->CDTRSR_A.R |= (1UL << (ch & 0x1f));
+   else
+      etpu_model_regs->CDTRSR_B.R |= (1UL << (ch & 0x1f));
+}
+
+void etpu_model_unexpected_thread(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_clear_all_latches(p_ctx);
+   etpu_model_clear_lsr(p_ctx);
+   etpu_model_stats.unexpected_threads++;
+}
+
+uint8_t *etpu_model_sdm(uint24_t address)
+{
+   static uint32_t scratch[2];
+
+   address &= 0xffffff;
+   if (address + 8 > ETPU_MODEL_RAM_SIZE)
+      return((uint8_t*)scratch);
+   return((uint8_t*)etpu_model_ram + address);
+}
+
+/* Match A/B events at the current time */
+static void etpu_model_matches(void)
+{
+   struct etpu_model_chan_t *c;
+   uint8_t ch;
+
+   for (ch = 0; ch < ETPU_MODEL_NUM_CHANNELS; ch++)
+   {
+      c = &etpu_model_chan[ch];
+      if (c->mre_a && (etpu_model_match_clk(c->match_a, c->tcr2_a, c->equal_a) <= etpu_model_clk))
+      {
+         c->mre_a = 0;
+         if (c->mode == ETPU_MODEL_MODE_M2_ST)
+         {
+            c->window_open = 1;       /* match A opens the transition window */
+         }
+         else
+         {
+            c->mrla = 1;
+            if (!c->tdla)
+               c->capture_a = c->tcr2_a ? etpu_model_tcr2() : etpu_model_tcr1();
+         }
+      }
+      if (c->mre_b && (etpu_model_match_clk(c->match_b, c->tcr2_b, 0) <= etpu_model_clk))
+      {
+         c->mre_b = 0;
+         c->mrlb = 1;
+         c->capture_b = c->tcr2_b ? etpu_model_tcr2() : etpu_model_tcr1();
+      }
+   }
+}
+
+/* Earliest pending match or deferred service slot */
+static unsigned long long etpu_model_next_event(void)
+{
+   unsigned long long next = ETPU_MODEL_NEVER;
+   unsigned long long t;
+   struct etpu_model_chan_t *c;
+   uint8_t ch;
+
+   if (etpu_model_deferred)
+      next = etpu_model_clk + ETPU_MODEL_SERVICE_CLKS;
+   for (ch = 0; ch < ETPU_MODEL_NUM_CHANNELS; ch++)
+   {
+      c = &etpu_model_chan[ch];
+      if (c->mre_a && ((t = etpu_model_match_clk(c->match_a, c->tcr2_a, c->equal_a)) < next))
+         next = t;
+      if (c->mre_b && ((t = etpu_model_match_clk(c->match_b, c->tcr2_b, 0)) < next))
+         next = t;
+   }
+   return(next);
+}
+
+/*******************************************************************************
+*                            Scheduler
+*******************************************************************************/
+static uint8_t etpu_model_pending(uint8_t ch)
+{
+   struct etpu_model_chan_t *c = &etpu_model_chan[ch];
+
+   if (etpu_model_regs->CHAN[ch].CR.B.CPR == 0)
+      return(0);
+   /* in SM_DT mode the first transition does not request service */
+   return((etpu_model_regs->CHAN[ch].HSRR.R & 0x7) || c->lsr ||
+          c->mrla || c->mrlb || c->tdlb ||
+          (c->tdla && (c->mode != ETPU_MODEL_MODE_SM_DT)));
+}
+
+static void etpu_model_service(uint8_t ch)
+{
+   struct etpu_model_chan_t *c = &etpu_model_chan[ch];
+   struct etpu_model_ctx_t ctx;
+   uint32_t cr = etpu_model_regs->CHAN[ch].CR.R;
+   etpu_model_function_t service;
+
+   ctx.base = ch & 0xe0;
+   ctx.chan = ch & 0x1f;
+   ctx.hsr = (uint8_t)(etpu_model_regs->CHAN[ch].HSRR.R & 0x7);
+   etpu_model_regs->CHAN[ch].HSRR.R = 0;
+   ctx.cond = (c->lsr ? ETPU_MODEL_COND_LSR : 0) |
+              ((c->mrla || c->tdlb) ? ETPU_MODEL_COND_M1 : 0) |
+              ((c->tdla || c->mrlb) ? ETPU_MODEL_COND_M2 : 0) |
+              (c->pin ? ETPU_MODEL_COND_PIN : 0) |
+              (c->flag0 ? ETPU_MODEL_COND_F0 : 0) |
+              (c->flag1 ? ETPU_MODEL_COND_F1 : 0);
+   ctx.erta = c->capture_a;
+   ctx.ertb = c->capture_b;
+   ctx.pba = (uint8_t*)etpu_model_ram + ((cr & 0x7ff) << 3);
+   ctx.steps = 0;
+
+   c->services++;
+   etpu_model_stats.threads++;
+
+   service = etpu_model_functions[(cr >> 16) & 0x1f];
+   if (service)
+      service(&ctx);
+   else
+      etpu_model_unexpected_thread(&ctx);
+}
+
+static void etpu_model_service_all(uint8_t passes)
+{
+   uint8_t ch, serviced;
+
+   while (passes--)
+   {
+      serviced = 0;
+      for (ch = 0; ch < ETPU_MODEL_NUM_CHANNELS; ch++)
+      {
+         if (etpu_model_pending(ch))
+         {
+            etpu_model_service(ch);
+            serviced = 1;
+         }
+      }
+      if (!serviced)
+      {
+         etpu_model_deferred = 0;
+         return;
+      }
+   }
+   for (ch = 0; ch < ETPU_MODEL_NUM_CHANNELS; ch++)
+   {
+      if (etpu_model_pending(ch))
+      {
+         etpu_model_deferred = 1;
+         return;
+      }
+   }
+   etpu_model_deferred = 0;
+}
+
+/* Run the model up to clock 'clk_end' */
+static void etpu_model_run_until(unsigned long long clk_end)
+{
+   unsigned long long next;
+
+   for (;;)
+   {
+      next = etpu_model_next_event();
+      if (next > clk_end)
+         break;
+      if (next > etpu_model_clk)
+         etpu_model_clk = next;
+      else if (etpu_model_deferred)
+         etpu_model_stats.deferred_slots++;
+      etpu_model_matches();
+      etpu_model_service_all(etpu_model_deferred ? 1 : ETPU_MODEL_MAX_PASSES);
+   }
+   etpu_model_clk = clk_end;
+   etpu_model_matches();
+   etpu_model_service_all(ETPU_MODEL_MAX_PASSES);
+   etpu_model_update_tbr();
+}
+
+void etpu_model_advance(uint32_t time_us)
+{
+   etpu_model_run_until(etpu_model_clk +
+      (unsigned long long)time_us * (ETPU_MODEL_CLOCK_HZ / 1000000));
+}
+
+/* Input pin change and transition detection, no service */
+static void etpu_model_pin_change(uint8_t chan, uint8_t value)
+{
+   struct etpu_model_chan_t *c = &etpu_model_chan[chan % ETPU_MODEL_NUM_CHANNELS];
+   uint8_t detect;
+
+   value = value ? 1 : 0;
+   if (c->pin != value)
+   {
+      c->pin = value;
+      if (value)
+         etpu_model_regs->CHAN[chan].SCR.R |= ETPU_MODEL_SCR_IPS;
+      else
+         etpu_model_regs->CHAN[chan].SCR.R &= ~ETPU_MODEL_SCR_IPS;
+
+      detect = (c->ipac_a == ETPU_MODEL_IPAC_ANY) ||
+               ((c->ipac_a == ETPU_MODEL_IPAC_LOW_HIGH) && value) ||
+               ((c->ipac_a == ETPU_MODEL_IPAC_HIGH_LOW) && !value);
+      if ((c->mode == ETPU_MODEL_MODE_M2_ST) && !c->window_open)
+         detect = 0;
+      if ((c->mode == ETPU_MODEL_MODE_SM_DT) && c->tdla)
+      {
+         /* second transition, detected by IPAC B */
+         detect = (c->ipac_b == ETPU_MODEL_IPAC_ANY) ||
+                  ((c->ipac_b == ETPU_MODEL_IPAC_LOW_HIGH) && value) ||
+                  ((c->ipac_b == ETPU_MODEL_IPAC_HIGH_LOW) && !value);
+         if (detect && !c->tdlb)
+         {
+            c->tdlb = 1;
+            c->capture_b = c->tcr2_b ? etpu_model_tcr2() : etpu_model_tcr1();
+         }
+      }
+      else if (detect && !c->tdla)
+      {
+         c->tdla = 1;
+         c->capture_a = c->tcr2_a ? etpu_model_tcr2() : etpu_model_tcr1();
+      }
+   }
+}
+
+void etpu_model_set_pin(uint8_t chan, uint8_t value)
+{
+   etpu_model_matches();
+   etpu_model_pin_change(chan, value);
+   etpu_model_service_all(ETPU_MODEL_MAX_PASSES);
+}
+
+/* Several pin changes at the same instant - the threads see them all, as
+   with changes faster than the thread service */
+void etpu_model_set_pins(uint8_t count, const uint8_t *p_chans, const uint8_t *p_values)
+{
+   uint8_t i;
+
+   etpu_model_matches();
+   for (i = 0; i < count; i++)
+      etpu_model_pin_change(p_chans[i], p_values[i]);
+   etpu_model_service_all(ETPU_MODEL_MAX_PASSES);
+}
+
+void etpu_model_set_tcrclk(uint8_t value)
+{
+   value = value ? 1 : 0;
+   etpu_model_matches();
+   if (etpu_model_tcrclk != value)
+   {
+      etpu_model_tcrclk = value;
+      if (etpu_model_tcr_running && ETPU_MODEL_TCR2_TCRCLK(etpu_model_tcr2_ctl) &&
+          (etpu_model_tcr2_ctl & (value ? ETPU_MODEL_TCR2CTL_RISE : ETPU_MODEL_TCR2CTL_FALL)))
+      {
+         etpu_model_tcr2_count++;
+         etpu_model_update_tbr();
+         etpu_model_matches();        /* TCR2 matches reached */
+      }
+   }
+   etpu_model_service_all(ETPU_MODEL_MAX_PASSES);
+}
+
+void etpu_model_register_function(uint8_t function,
+                                  etpu_model_function_t service)
+{
+   etpu_model_functions[function & (ETPU_MODEL_NUM_FUNCTIONS - 1)] = service;
+}
+
+/*******************************************************************************
+*                            Host Access Side Effects
+*******************************************************************************/
+/* Refresh the sign-extended DATA RAM mirror */
+static void etpu_model_pse_refresh(void)
+{
+   uint32_t i;
+
+   for (i = 0; i < ETPU_MODEL_RAM_SIZE/4; i++)
+      etpu_model_pse[i] = (uint32_t)(((int32_t)(etpu_model_ram[i] << 8)) >> 8);
+}
+
+/* Host wrote the mirror - 24-bit writes, the top byte is preserved */
+static void etpu_model_pse_written(void)
+{
+   uint32_t i;
+
+   for (i = 0; i < ETPU_MODEL_RAM_SIZE/4; i++)
+   {
+      if (etpu_model_pse[i] != etpu_model_snapshot[i])
+         etpu_model_ram[i] = (etpu_model_ram[i] & 0xff000000) |
+                             (etpu_model_pse[i] & 0x00ffffff);
+   }
+}
+
+/* Coherent dual-parameter transfer */
+static void etpu_model_cdc(uint32_t cdcr)
+{
+   uint32_t ctbase = (cdcr >> 26) & 0x1f;
+   uint32_t *buffer = etpu_model_ram + (((cdcr >> 16) & 0x3ff) << 1);
+   uint32_t mask = (cdcr & 0x8000) ? 0xffffffff : 0x00ffffff;
+   uint32_t word[2];
+   uint8_t i;
+
+   word[0] = (ctbase << 7) + ((cdcr >> 8) & 0x7f);
+   word[1] = (ctbase << 7) + (cdcr & 0x7f);
+   for (i = 0; i < 2; i++)
+   {
+      if (word[i] >= ETPU_MODEL_RAM_SIZE/4)
+         continue;
+      if (cdcr & 0x80)
+         etpu_model_ram[word[i]] = (etpu_model_ram[word[i]] & ~mask) | (buffer[i] & mask);
+      else
+         buffer[i] = etpu_model_ram[word[i]] & mask;
+   }
+}
+
+/* Global status register bits cleared by the host - clear the SCR flags */
+static void etpu_model_status_cleared(uint8_t chan_base, uint32_t bits, uint32_t scr_flag)
+{
+   uint8_t i;
+
+   for (i = 0; i < 32; i++)
+      if (bits & (1UL << i))
+         etpu_model_regs->CHAN[chan_base + i].SCR.R &= ~scr_flag;
+}
+
+/* Host wrote the register page - 'old' is the page before the write */
+static void etpu_model_regs_written(const uint32_t *old)
+{
+   uint32_t *now = (uint32_t*)etpu_model_regs;
+   uint32_t i, off, w1c;
+   uint32_t cis_a = 0, cis_b = 0, dtrs_a = 0, dtrs_b = 0;
+   uint8_t ch;
+
+   /* The written word is processed even when its value is unchanged - a
+      write 1 to clear of a set status bit does not change the page */
+   for (i = 0; i < ETPU_MODEL_PAGE/4; i++)
+   {
+      if ((now[i] == old[i]) && (i != etpu_model_trap_word))
+         continue;
+      off = i << 2;
+      if (off == offsetof(struct eTPU_struct, MCR))
+      {
+         if (!etpu_model_tcr_running && etpu_model_regs->MCR.B.GTBE)
+         {
+            etpu_model_tcr_running = 1;
+            etpu_model_tcr_start = etpu_model_clk;
+            etpu_model_tcr2_ctl = (uint8_t)etpu_model_regs->TBCR_A.B.TCR2CTL;
+         }
+      }
+      else if (off == offsetof(struct eTPU_struct, CDCR))
+      {
+         if (now[i] & 0x80000000)
+         {
+            etpu_model_cdc(now[i]);
+            now[i] &= ~0x80000000;
+         }
+      }
+      else if ((off == offsetof(struct eTPU_struct, TB1R_A)) ||
+               (off == offsetof(struct eTPU_struct, TB2R_A)) ||
+               (off == offsetof(struct eTPU_struct, TB1R_B)) ||
+               (off == offsetof(struct eTPU_struct, TB2R_B)))
+      {
+         now[i] = old[i];              /* read only */
+      }
+      else if ((off == offsetof(struct eTPU_struct, CISR_A)) ||
+               (off == offsetof(struct eTPU_struct, CISR_B)) ||
+               (off == offsetof(struct eTPU_struct, CDTRSR_A)) ||
+               (off == offsetof(struct eTPU_struct, CDTRSR_B)) ||
+               (off == offsetof(struct eTPU_struct, CIOSR_A)) ||
+               (off == offsetof(struct eTPU_struct, CIOSR_B)) ||
+               (off == offsetof(struct eTPU_struct, CDTROSR_A)) ||
+               (off == offsetof(struct eTPU_struct, CDTROSR_B)))
+      {
+         if (off == offsetof(struct eTPU_struct, CISR_A))
+            cis_a = old[i] & now[i];
+         else if (off == offsetof(struct eTPU_struct, CISR_B))
+            cis_b = old[i] & now[i];
+         else if (off == offsetof(struct eTPU_struct, CDTRSR_A))
+            dtrs_a = old[i] & now[i];
+         else if (off == offsetof(struct eTPU_struct, CDTRSR_B))
+            dtrs_b = old[i] & now[i];
+         now[i] = old[i] & ~now[i];    /* write 1 to clear */
+      }
+      else if (off >= offsetof(struct eTPU_struct, CHAN))
+      {
+         ch = (uint8_t)((off - offsetof(struct eTPU_struct, CHAN)) >> 4);
+         switch (off & 0xc)
+         {
+         case 0x4:   /* SCR - FM writable, status flags write 1 to clear */
+            w1c = ETPU_MODEL_SCR_CIS | ETPU_MODEL_SCR_CIOS |
+                  ETPU_MODEL_SCR_DTRS | ETPU_MODEL_SCR_DTROS;
+            now[i] = (old[i] & ~ETPU_MODEL_SCR_FM & ~(now[i] & w1c)) |
+                     (now[i] & ETPU_MODEL_SCR_FM);
+            break;
+         case 0x8:   /* HSRR - ignored while a request is pending */
+            if (old[i] & 0x7)
+               now[i] = old[i];
+            else
+               now[i] &= 0x7;
+            break;
+         default:
+            break;
+         }
+         (void)ch;
+      }
+   }
+
+   /* the channel SCR flags are views of the global status bits */
+   etpu_model_status_cleared(0, cis_a, ETPU_MODEL_SCR_CIS);
+   etpu_model_status_cleared(64, cis_b, ETPU_MODEL_SCR_CIS);
+   etpu_model_status_cleared(0, dtrs_a, ETPU_MODEL_SCR_DTRS);
+   etpu_model_status_cleared(64, dtrs_b, ETPU_MODEL_SCR_DTRS);
+}
+
+/*******************************************************************************
+*                            Trap Handlers
+*******************************************************************************/
+static void etpu_model_sigsegv(int sig, siginfo_t *info, void *p_uc)
+{
+   ucontext_t *uc = (ucontext_t*)p_uc;
+   unsigned long addr = (unsigned long)info->si_addr;
+   uint8_t *base = (uint8_t*)ETPU_MODEL_BASE;
+
+   (void)sig;
+   if ((addr >= ETPU_MODEL_BASE + ETPU_MODEL_REG_OFFSET) &&
+       (addr < ETPU_MODEL_BASE + ETPU_MODEL_REG_OFFSET + ETPU_MODEL_PAGE))
+   {
+      memcpy(etpu_model_snapshot, (void*)etpu_model_regs, ETPU_MODEL_PAGE);
+      etpu_model_trap_word = (uint32_t)((addr - ETPU_MODEL_BASE - ETPU_MODEL_REG_OFFSET) >> 2);
+      mprotect(base + ETPU_MODEL_REG_OFFSET, ETPU_MODEL_PAGE, PROT_READ | PROT_WRITE);
+      etpu_model_trap = ETPU_MODEL_TRAP_REGS;
+      etpu_model_stats.register_traps++;
+   }
+   else if ((addr >= ETPU_MODEL_BASE + ETPU_MODEL_PSE_OFFSET) &&
+            (addr < ETPU_MODEL_BASE + ETPU_MODEL_PSE_OFFSET + ETPU_MODEL_PAGE))
+   {
+      etpu_model_pse_refresh();
+      memcpy(etpu_model_snapshot, etpu_model_pse, ETPU_MODEL_PAGE);
+      mprotect(base + ETPU_MODEL_PSE_OFFSET, ETPU_MODEL_PAGE, PROT_READ | PROT_WRITE);
+      etpu_model_trap = ETPU_MODEL_TRAP_PSE;
+      etpu_model_stats.mirror_traps++;
+   }
+   else
+   {
+      /* not a model page - let the access fault again with the default action */
+      signal(SIGSEGV, SIG_DFL);
+      return;
+   }
+   uc->uc_mcontext.gregs[REG_EFL] |= ETPU_MODEL_EFLAGS_TF;
+}
+
+static void etpu_model_sigtrap(int sig, siginfo_t *info, void *p_uc)
+{
+   ucontext_t *uc = (ucontext_t*)p_uc;
+   uint8_t *base = (uint8_t*)ETPU_MODEL_BASE;
+
+   (void)sig;
+   (void)info;
+   uc->uc_mcontext.gregs[REG_EFL] &= ~ETPU_MODEL_EFLAGS_TF;
+   switch (etpu_model_trap)
+   {
+   case ETPU_MODEL_TRAP_REGS:
+      mprotect(base + ETPU_MODEL_REG_OFFSET, ETPU_MODEL_PAGE, PROT_READ);
+      etpu_model_trap = ETPU_MODEL_TRAP_NONE;
+      etpu_model_regs_written(etpu_model_snapshot);
+      etpu_model_service_all(ETPU_MODEL_MAX_PASSES);
+      break;
+   case ETPU_MODEL_TRAP_PSE:
+      mprotect(base + ETPU_MODEL_PSE_OFFSET, ETPU_MODEL_PAGE, PROT_NONE);
+      etpu_model_trap = ETPU_MODEL_TRAP_NONE;
+      etpu_model_pse_written();
+      etpu_model_service_all(ETPU_MODEL_MAX_PASSES);
+      break;
+   default:
+      break;
+   }
+}
+
+/*******************************************************************************
+*                            Initialization
+*******************************************************************************/
+int32_t etpu_model_init(void)
+{
+   struct sigaction sa;
+   uint8_t *base;
+   int fd;
+
+   fd = memfd_create("etpu_model", 0);
+   if ((fd < 0) || (ftruncate(fd, ETPU_MODEL_SIZE) != 0))
+      return(FS_ETPU_ERROR_MALLOC);
+   base = mmap((void*)ETPU_MODEL_BASE, ETPU_MODEL_SIZE, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+   if (base != (uint8_t*)ETPU_MODEL_BASE)
+      return(FS_ETPU_ERROR_ADDRESS);
+   etpu_model_alias = mmap(0, ETPU_MODEL_SIZE, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd, 0);
+   if (etpu_model_alias == MAP_FAILED)
+      return(FS_ETPU_ERROR_MALLOC);
+   close(fd);
+
+   etpu_model_regs = (volatile struct eTPU_struct*)(etpu_model_alias + ETPU_MODEL_REG_OFFSET);
+   etpu_model_ram = (uint32_t*)(etpu_model_alias + ETPU_MODEL_RAM_OFFSET);
+   etpu_model_pse = (uint32_t*)(etpu_model_alias + ETPU_MODEL_PSE_OFFSET);
+
+   /* the register bit fields must be in host bit field order */
+   etpu_model_regs->CHAN[0].CR.B.CPBA = 1;
+   if (etpu_model_regs->CHAN[0].CR.R != 1)
+      return(FS_ETPU_ERROR_VALUE);
+   etpu_model_regs->CHAN[0].CR.R = 0;
+   etpu_model_regs->MCR.B.SCMSIZE = ETPU_MODEL_SCMSIZE;
+
+   etpu_model_tcr1_div = etpu_a_tcr1_freq ? ETPU_MODEL_CLOCK_HZ / etpu_a_tcr1_freq : 2;
+   etpu_model_tcr2_div = etpu_a_tcr2_freq ? ETPU_MODEL_CLOCK_HZ / etpu_a_tcr2_freq : 8;
+   if (etpu_model_tcr1_div == 0)
+      etpu_model_tcr1_div = 1;
+   if (etpu_model_tcr2_div == 0)
+      etpu_model_tcr2_div = 1;
+
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_flags = SA_SIGINFO;
+   sigemptyset(&sa.sa_mask);
+   sigaddset(&sa.sa_mask, SIGALRM);
+   sa.sa_sigaction = etpu_model_sigsegv;
+   sigaction(SIGSEGV, &sa, 0);
+   sa.sa_sigaction = etpu_model_sigtrap;
+   sigaction(SIGTRAP, &sa, 0);
+
+   mprotect(base + ETPU_MODEL_REG_OFFSET, ETPU_MODEL_PAGE, PROT_READ);
+   mprotect(base + ETPU_MODEL_PSE_OFFSET, ETPU_MODEL_PAGE, PROT_NONE);
+
+   return(FS_ETPU_ERROR_NONE);
+}
@@ -0,0 +1,168 @@
+/**************************************************************************
+ * FILE NAME: etpu_model.h
+ *
+ * DESCRIPTION:
+ * Behavioral model of the eTPU_AB module for running the host API and test
+ * application natively on Linux (x86-64). The model provides:
+ *  - the eTPU register block, code memory, DATA RAM and the sign-extended
+ *    DATA RAM mirror at the MPC5554 addresses,
+ *  - the channel hardware used by the QD function (pin, transition
+ *    detection, match A/B, capture, latches, flags),
+ *  - the scheduler, which dispatches channel service requests to the
+ *    function models registered with etpu_model_register_function().
+ *
+ * Host code accesses the registers and the DATA RAM mirror with ordinary
+ * loads and stores. Those pages are access-protected; each access traps,
+ * is single-stepped and then the model applies the register side effects
+ * (HSR, CDC transfer, write-1-to-clear flags, 24-bit mirror writes) and
+ * services any pending channel requests.
+ **************************************************************************/
+#ifndef _ETPU_MODEL_H_
+#define _ETPU_MODEL_H_
+
+#include "etpu_util_ext.h"
+
+/*******************************************************************************
+*                            Definitions
+*******************************************************************************/
+#define ETPU_MODEL_CLOCK_HZ          100000000  /* eTPU engine clock */
+#define ETPU_MODEL_NUM_CHANNELS      96         /* engine A 0-31, B 64-95 */
+#define ETPU_MODEL_NUM_FUNCTIONS     32
+#define ETPU_MODEL_SERVICE_CLKS      40         /* time slot of a deferred service */
+#define ETPU_MODEL_MAX_PASSES        16         /* scheduler passes per time step */
+
+/* input pin action (transition detection) */
+#define ETPU_MODEL_IPAC_NO_DETECT    0
+#define ETPU_MODEL_IPAC_LOW_HIGH     1
+#define ETPU_MODEL_IPAC_HIGH_LOW     2
+#define ETPU_MODEL_IPAC_ANY          3
+
+/* channel modes */
+#define ETPU_MODEL_MODE_SM_ST        0  /* SingleMatchSingleTransition */
+#define ETPU_MODEL_MODE_M2_ST        1  /* Match2SingleTransition */
+#define ETPU_MODEL_MODE_EM_NB_ST     2  /* EitherMatchNonBlockingSingleTransition */
+#define ETPU_MODEL_MODE_SM_DT        3  /* SingleMatchDoubleTransition */
+
+/* TBCR TCR2CTL - TCR2 clocked by the TCRCLK rise, fall or both */
+#define ETPU_MODEL_TCR2CTL_RISE      1
+#define ETPU_MODEL_TCR2CTL_FALL      2
+#define ETPU_MODEL_TCR2_TCRCLK(ctl)  (((ctl) >= ETPU_MODEL_TCR2CTL_RISE) && \
+                                      ((ctl) <= (ETPU_MODEL_TCR2CTL_RISE | ETPU_MODEL_TCR2CTL_FALL)))
+
+/* entry table condition bits passed to the function model */
+#define ETPU_MODEL_COND_LSR          0x01
+#define ETPU_MODEL_COND_M1           0x02  /* match A or transition B */
+#define ETPU_MODEL_COND_M2           0x04  /* transition A or match B */
+#define ETPU_MODEL_COND_PIN          0x08
+#define ETPU_MODEL_COND_F0           0x10
+#define ETPU_MODEL_COND_F1           0x20
+
+/*******************************************************************************
+*                            Type Definitions
+*******************************************************************************/
+/* channel hardware state */
+struct etpu_model_chan_t
+{
+   uint8_t  pin;
+   uint8_t  ipac_a;
+   uint8_t  ipac_b;        /* SM_DT - second transition */
+   uint8_t  mode;
+   uint8_t  tcr2_a;        /* action unit A uses TCR2 */
+   uint8_t  tcr2_b;        /* action unit B uses TCR2 */
+   uint8_t  equal_a;       /* action unit A matches equal only */
+   uint8_t  mre_a;         /* match A enabled */
+   uint8_t  mre_b;         /* match B enabled */
+   uint8_t  window_open;   /* M2_ST - match A occurred */
+   uint8_t  mrla;
+   uint8_t  mrlb;
+   uint8_t  tdla;
+   uint8_t  tdlb;
+   uint8_t  lsr;
+   uint8_t  flag0;
+   uint8_t  flag1;
+   uint24_t match_a;
+   uint24_t match_b;
+   uint24_t capture_a;
+   uint24_t capture_b;
+   uint32_t services;      /* number of threads executed */
+};
+
+/* thread context - the eTPU registers visible to a function thread */
+struct etpu_model_ctx_t
+{
+   uint8_t  base;          /* first channel of the engine, 0 or 64 */
+   uint8_t  chan;          /* chan register, may be changed by the thread */
+   uint8_t  hsr;           /* HSR that started the thread, 0 if none */
+   uint8_t  cond;          /* ETPU_MODEL_COND_* */
+   uint24_t erta;
+   uint24_t ertb;
+   uint8_t  *pba;          /* channel frame of the serviced channel */
+   uint32_t steps;         /* thread length estimate, see etpu_qd_model.c */
+};
+
+/* function model service routine */
+typedef void (*etpu_model_function_t)(struct etpu_model_ctx_t *p_ctx);
+
+/* statistics */
+struct etpu_model_stats_t
+{
+   uint32_t threads;            /* all threads executed */
+   uint32_t unexpected_threads; /* _Error_handler_unexpected_thread */
+   uint32_t deferred_slots;     /* time slots spent on requests left pending */
+   uint32_t register_traps;     /* host register accesses */
+   uint32_t mirror_traps;       /* host DATA RAM mirror accesses */
+};
+
+/*******************************************************************************
+*                            Global Variables
+*******************************************************************************/
+extern struct etpu_model_chan_t etpu_model_chan[ETPU_MODEL_NUM_CHANNELS];
+extern struct etpu_model_stats_t etpu_model_stats;
+
+/*******************************************************************************
+*                            Function Prototypes
+*******************************************************************************/
+/* Model set-up and time */
+int32_t  etpu_model_init(void);
+void     etpu_model_register_function(uint8_t function,
+                                      etpu_model_function_t service);
+void     etpu_model_advance(uint32_t time_us);
+void     etpu_model_set_pin(uint8_t chan, uint8_t value);
+void     etpu_model_set_pins(uint8_t count, const uint8_t *p_chans,
+                             const uint8_t *p_values);
+void     etpu_model_set_tcrclk(uint8_t value);
+unsigned long long etpu_model_clocks(void);
+
+/* Channel hardware operations for function models */
+uint24_t etpu_model_tcr1(void);
+uint24_t etpu_model_tcr2(void);
+uint8_t  etpu_model_fm(const struct etpu_model_ctx_t *p_ctx);
+uint8_t  etpu_model_pin(const struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_action_units(struct etpu_model_ctx_t *p_ctx, uint8_t tcr2);
+void     etpu_model_action_unit_a(struct etpu_model_ctx_t *p_ctx, uint8_t tcr2, uint8_t equal_only);
+void     etpu_model_channel_mode(struct etpu_model_ctx_t *p_ctx, uint8_t mode);
+void     etpu_model_on_trans_a(struct etpu_model_ctx_t *p_ctx, uint8_t ipac);
+void     etpu_model_on_trans_b(struct etpu_model_ctx_t *p_ctx, uint8_t ipac);
+void     etpu_model_clear_all_latches(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_clear_trans_latch(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_clear_match_a_latch(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_clear_lsr(struct etpu_model_ctx_t *p_ctx);
+uint8_t  etpu_model_trans_a_latched(const struct etpu_model_ctx_t *p_ctx);
+uint8_t  etpu_model_trans_b_latched(const struct etpu_model_ctx_t *p_ctx);
+uint8_t  etpu_model_match_b_latched(const struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_write_erta_match_a(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_write_ertb_match_b(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_disable_matches(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_set_flag0(struct etpu_model_ctx_t *p_ctx, uint8_t value);
+void     etpu_model_set_flag1(struct etpu_model_ctx_t *p_ctx, uint8_t value);
+void     etpu_model_link(struct etpu_model_ctx_t *p_ctx, uint8_t chan);
+void     etpu_model_channel_interrupt(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_data_transfer_request(struct etpu_model_ctx_t *p_ctx);
+void     etpu_model_unexpected_thread(struct etpu_model_ctx_t *p_ctx);
+uint8_t *etpu_model_sdm(uint24_t address);
+
+/* QD function model */
+void     etpu_qd_model_register(void);
+void     etpu_qd_model_report(int fd);
+
+#endif
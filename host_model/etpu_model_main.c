@@ -0,0 +1,131 @@
+/**************************************************************************
+ * FILE NAME: etpu_model_main.c
+ *
+ * DESCRIPTION:
+ * Host entry point of the QD test application. Sets up the eTPU model,
+ * runs user_main() from main.c and provides the simulator script and
+ * interrupt library functions main.c calls. A watchdog timer reports the
+ * result, since main.c ends in an endless loop both on completion
+ * (g_complete_flag) and on failure (fail_loop()).
+ *
+ * Exit code: 0 - pass, 1 - fail_loop() reached, 2 - timeout,
+ *            3 - model initialization failed or user_main() returned.
+ **************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "etpu_model.h"
+#include "isrLib.h"
+#include "ScriptLib.h"
+
+#define ETPU_MODEL_WATCHDOG_US   20000   /* watchdog check period */
+#define ETPU_MODEL_TIMEOUT_S     60      /* wall clock limit */
+
+extern int user_main(void);
+extern int32_t g_complete_flag;
+extern uint32_t g_fail_loop_cnt;
+
+static volatile uint32_t watchdog_ticks;
+
+/*******************************************************************************
+*                            Simulator Script Library
+*******************************************************************************/
+void wait_time(unsigned int time_us)
+{
+   etpu_model_advance(time_us);
+}
+
+void write_chan_input_pin(unsigned int channel, unsigned int value)
+{
+   etpu_model_set_pin((uint8_t)channel, (uint8_t)value);
+}
+
+/* the pins are written at the same instant, before any thread is serviced */
+void write_chan_input_pins(unsigned int count, const unsigned int *p_channels,
+                           const unsigned int *p_values)
+{
+   uint8_t chans[8], values[8];
+   unsigned int i;
+
+   if (count > 8)
+      count = 8;
+   for (i = 0; i < count; i++)
+   {
+      chans[i] = (uint8_t)p_channels[i];
+      values[i] = (uint8_t)p_values[i];
+   }
+   etpu_model_set_pins((uint8_t)count, chans, values);
+}
+
+void write_tcrclk_pin(unsigned int value)
+{
+   etpu_model_set_tcrclk((uint8_t)value);
+}
+
+/*******************************************************************************
+*                            Interrupt Library
+*******************************************************************************/
+void isrLibInit(void)
+{
+}
+
+void isrEnableAllInterrupts(void)
+{
+}
+
+/*******************************************************************************
+*                            Result Reporting
+*******************************************************************************/
+static void etpu_model_report(const char *result, int code)
+{
+   char line[256];
+   int len;
+
+   len = snprintf(line, sizeof(line),
+                  "%s: %llu us simulated, %u threads (%u unexpected, %u deferred slots), "
+                  "%u register / %u mirror accesses trapped\n",
+                  result, etpu_model_clocks() / (ETPU_MODEL_CLOCK_HZ / 1000000),
+                  etpu_model_stats.threads, etpu_model_stats.unexpected_threads,
+                  etpu_model_stats.deferred_slots, etpu_model_stats.register_traps,
+                  etpu_model_stats.mirror_traps);
+   if (write(STDOUT_FILENO, line, len) < 0)
+      code = 3;
+   etpu_qd_model_report(STDOUT_FILENO);
+   _exit(code);
+}
+
+static void etpu_model_watchdog(int sig)
+{
+   (void)sig;
+   if (g_complete_flag)
+      etpu_model_report("PASS", 0);
+   if (g_fail_loop_cnt)
+      etpu_model_report("FAIL", 1);
+   if (++watchdog_ticks > (ETPU_MODEL_TIMEOUT_S * 1000000 / ETPU_MODEL_WATCHDOG_US))
+      etpu_model_report("TIMEOUT", 2);
+}
+
+int main(void)
+{
+   struct itimerval timer;
+
+   if (etpu_model_init() != FS_ETPU_ERROR_NONE)
+   {
+      fprintf(stderr, "eTPU model initialization failed\n");
+      return(3);
+   }
+   etpu_qd_model_register();
+
+   signal(SIGALRM, etpu_model_watchdog);
+   timer.it_interval.tv_sec = 0;
+   timer.it_interval.tv_usec = ETPU_MODEL_WATCHDOG_US;
+   timer.it_value = timer.it_interval;
+   setitimer(ITIMER_REAL, &timer, 0);
+
+   user_main();
+
+   fprintf(stderr, "user_main() returned\n");
+   return(3);
+}
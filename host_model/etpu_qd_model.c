@@ -0,0 +1,1854 @@
+/**************************************************************************
+ * FILE NAME: etpu_qd_model.c
+ *
+ * DESCRIPTION:
+ * Host model of the QD, QD HOME and QD INDEX eTPU functions. Each thread
+ * mirrors the thread of the same name in etpu/_etpu_set/etec_eqd.c line by
+ * line and works on the channel frame in the model DATA RAM, using the
+ * parameter offsets of etpu_eqd_auto.h. Any change of the microcode must
+ * be reflected here. The code of a microcode build option is compiled when
+ * etpu_eqd_auto.h exports the parameters of the option, as the #ifdef QD_*
+ * blocks of the microcode.
+ **************************************************************************/
+#include <stdio.h>
+#include <unistd.h>
+#include "etpu_model.h"
+#include "etpu_eqd_auto.h"
+
+/*******************************************************************************
+*                            Definitions
+*******************************************************************************/
+/* private (not exported) channel frame parameters */
+#define QD_FOUND_LEADING_EDGE_OFFSET   43
+#define QD_PERIOD_ACCUM_OFFSET         60
+#define QD_WINDOW_BEGIN_OFFSET         69
+#define QD_WINDOW_END_OFFSET           73
+#define QD_LAST_INDEX_OFFSET           77
+#define QD_REV_ACCUM_OFFSET            80
+#define QD_REV_ACCUM_EXT_OFFSET        59
+#define QD_INDEX_SEEN_OFFSET           55
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+#define QD_IRQ_LAST_TIME_OFFSET        205
+#define QD_IRQ_STATE_OFFSET            103
+#endif
+#define QD_TCR2_BASE_OFFSET            109
+#define QD_TCR2_STATE_OFFSET           71
+
+#define QD_DIRECTION_INCREMENT         1
+#define QD_DIRECTION_DECREMENT         (-1)
+#define QD_DIRECTION_INCREMENT_FAST    4
+#define QD_DIRECTION_DECREMENT_FAST    (-4)
+#define QD_DIRECTION_INCREMENT_ULTRA   8
+#define QD_DIRECTION_DECREMENT_ULTRA   (-8)
+#define QD_DIRECTION_BIT7              0x80
+
+#define QD_MODE_SLOW                   0x01
+#define QD_MODE_NORMAL                 0x02
+#define QD_MODE_FAST                   0x04
+#define QD_LEADING_EDGE_INDICATION     0x08
+#define QD_FAST_TO_NORMAL_SWITCH       0x10
+#define QD_MODE_ULTRA_FAST             0x20
+#define QD_MODE_TCR2                   0x40
+
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+#define QD_IRQ_ARMED1                  0x01
+#define QD_IRQ_ARMED2                  0x02
+#define QD_IRQ_HOLD                    0x04
+#endif
+
+/* threads, index into qd_model_threads[] */
+#define QD_THREAD_INIT                          0
+#define QD_THREAD_LATCH_AND_CLEAR_ERRORS        1
+#define QD_THREAD_NON_LEADING_EDGE              2
+#define QD_THREAD_SLOW_MODE_LEADING_EDGE        3
+#define QD_THREAD_NORMAL_MODE_LEADING_EDGE      4
+#define QD_THREAD_PERIOD_OVERFLOW               5
+#define QD_THREAD_FAST_MODE_EDGE                6
+#define QD_THREAD_HOME_INIT                     7
+#define QD_THREAD_HOME_TRANSITION               8
+#define QD_THREAD_INDEX_INIT                    9
+#define QD_THREAD_INDEX_FIRST_TRANSITION        10
+#define QD_THREAD_INDEX_FIRST_TRANSITION_LINK   11
+#define QD_THREAD_INDEX_SECOND_TRANSITION       12
+#define QD_THREAD_INDEX_SECOND_TRANSITION_LINK  13
+#define QD_THREAD_INDEX_PERIOD_OVERFLOW         14
+#define QD_THREAD_FAST_MODE_MATCH               15
+#define QD_THREAD_COUNT                         16
+
+/*******************************************************************************
+*                            Thread Length Statistics
+*******************************************************************************/
+/* The length of a thread is estimated in steps - one per channel frame
+   parameter access and one per channel hardware operation (flags, pin
+   action, matches, latches, channel mode, link, interrupt, channel
+   switch). That is close to the eTPU instruction count, which for the
+   microcode itself is reported by the ETEC analysis file. */
+struct qd_model_thread_t
+{
+   const char *name;
+   uint32_t count;
+   uint32_t max_steps;
+};
+
+static struct qd_model_thread_t qd_model_threads[QD_THREAD_COUNT] =
+{
+   { "Init", 0, 0 },
+   { "LatchAndClearErrors", 0, 0 },
+   { "NonLeadingEdge", 0, 0 },
+   { "SlowModeLeadingEdge", 0, 0 },
+   { "NormalModeLeadingEdge", 0, 0 },
+   { "PeriodOverflow", 0, 0 },
+   { "FastModeEdge", 0, 0 },
+   { "Home_Init", 0, 0 },
+   { "Home_Transition", 0, 0 },
+   { "Index_Init", 0, 0 },
+   { "Index_FirstTransition", 0, 0 },
+   { "Index_FirstTransitionLink", 0, 0 },
+   { "Index_SecondTransition", 0, 0 },
+   { "Index_SecondTransitionLink", 0, 0 },
+   { "Index_PeriodOverflow", 0, 0 },
+   { "FastModeMatch", 0, 0 },
+};
+
+static void qd_prof_thread(struct etpu_model_ctx_t *p_ctx, uint8_t thread);
+
+static void qd_thread_done(struct etpu_model_ctx_t *p_ctx, uint8_t thread)
+{
+   struct qd_model_thread_t *p_thread = &qd_model_threads[thread];
+
+   qd_prof_thread(p_ctx, thread);
+   p_thread->count++;
+   if (p_ctx->steps > p_thread->max_steps)
+      p_thread->max_steps = p_ctx->steps;
+}
+
+/*******************************************************************************
+*                            Channel Frame Access
+*******************************************************************************/
+static uint32_t *qd_word(struct etpu_model_ctx_t *p_ctx, uint8_t offset)
+{
+   p_ctx->steps++;
+   return((uint32_t*)(p_ctx->pba + (offset & ~3)));
+}
+
+/* 24-bit parameter at 'offset' (offset of its low 3 bytes) */
+static int32_t qd_get24(struct etpu_model_ctx_t *p_ctx, uint8_t offset)
+{
+   return(((int32_t)(*qd_word(p_ctx, offset - 1) << 8)) >> 8);
+}
+
+static void qd_set24(struct etpu_model_ctx_t *p_ctx, uint8_t offset, int32_t value)
+{
+   uint32_t *p = qd_word(p_ctx, offset - 1);
+
+   *p = (*p & 0xff000000) | ((uint32_t)value & 0x00ffffff);
+}
+
+static int8_t qd_get8(struct etpu_model_ctx_t *p_ctx, uint8_t offset)
+{
+   p_ctx->steps++;
+   return(*(int8_t*)(p_ctx->pba + offset));
+}
+
+static void qd_set8(struct etpu_model_ctx_t *p_ctx, uint8_t offset, int32_t value)
+{
+   p_ctx->steps++;
+   *(int8_t*)(p_ctx->pba + offset) = (int8_t)value;
+}
+
+/* channel switch ("chan = ...") */
+static void qd_chan(struct etpu_model_ctx_t *p_ctx, uint8_t chan)
+{
+   p_ctx->steps++;
+   p_ctx->chan = chan;
+}
+
+/* 8.24 union - msb in the top byte, lsb in the low 3 bytes */
+static uint32_t qd_get32(struct etpu_model_ctx_t *p_ctx, uint8_t offset)
+{
+   return(*qd_word(p_ctx, offset));
+}
+
+static void qd_set32(struct etpu_model_ctx_t *p_ctx, uint8_t offset, uint32_t value)
+{
+   *qd_word(p_ctx, offset) = value;
+}
+
+/* 8.24 union "lsb += value" with the carry propagated to the msb */
+static uint24_t qd_accumulate(struct etpu_model_ctx_t *p_ctx, uint8_t offset, uint24_t value)
+{
+   uint32_t accum = qd_get32(p_ctx, offset) + (value & 0xffffff);
+
+   qd_set32(p_ctx, offset, accum);
+   return(accum & 0xffffff);
+}
+
+/* fract24 multiply with rounding */
+static uint24_t qd_mulir(uint24_t a, uint24_t b)
+{
+   long long sa = ((int32_t)(a << 8)) >> 8;
+   long long sb = ((int32_t)(b << 8)) >> 8;
+
+   return((uint24_t)(((sa * sb) + (1 << 22)) >> 23) & 0xffffff);
+}
+
+/* 48-bit absolute position "+= counts" - position_lo with the carry (borrow)
+   to position_hi */
+static void qd_position_add(struct etpu_model_ctx_t *p_ctx, int32_t counts)
+{
+   uint24_t lo = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_POSITION_LO_OFFSET) & 0xffffff;
+   uint24_t new_lo = (lo + (uint24_t)counts) & 0xffffff;
+
+   qd_set24(p_ctx, FS_ETPU_QD_POSITION_LO_OFFSET, (int32_t)new_lo);
+   if ((counts < 0) ? (new_lo > lo) : (new_lo < lo))
+      qd_set24(p_ctx, FS_ETPU_QD_POSITION_HI_OFFSET,
+               qd_get24(p_ctx, FS_ETPU_QD_POSITION_HI_OFFSET) + ((counts < 0) ? -1 : 1));
+}
+
+/* wrap extension of a TCR time - advances tcr_ext by a time up to half a
+   wrap after it */
+static uint8_t qd_time_ext(struct etpu_model_ctx_t *p_ctx, uint24_t time)
+{
+   uint32_t ext = qd_get32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET);
+   uint24_t lsb = ext & 0xffffff;
+   uint8_t msb = (uint8_t)(ext >> 24);
+
+   time &= 0xffffff;
+   if (((time - lsb) & 0xffffff) <= 0x800000)
+   {
+      if (time < lsb)
+         msb++;
+      qd_set32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET, ((uint32_t)msb << 24) | time);
+      return(msb);
+   }
+   return((time > lsb) ? (uint8_t)(msb - 1) : msb);
+}
+
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+/* standstill - tcr_ext advanced by a time less than a wrap after it */
+static void qd_time_ext_wrap(struct etpu_model_ctx_t *p_ctx, uint24_t time)
+{
+   uint32_t ext = qd_get32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET);
+   uint8_t msb = (uint8_t)(ext >> 24);
+
+   time &= 0xffffff;
+   if (time < (ext & 0xffffff))
+      msb++;
+   qd_set32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET, ((uint32_t)msb << 24) | time);
+}
+
+/* period overflow match at standstill - extend tcr_ext, match again one
+   TCR wrap from now (equal only) */
+static void qd_standstill_overflow(struct etpu_model_ctx_t *p_ctx)
+{
+   qd_time_ext_wrap(p_ctx, p_ctx->erta);
+   etpu_model_action_unit_a(p_ctx, etpu_model_fm(p_ctx) & 2, 1);
+   p_ctx->erta = (p_ctx->erta - 1) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+}
+
+/* standstill end - both channels back to greater-equal matches */
+static void qd_standstill_end(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t tmp_chan;
+
+   qd_time_ext_wrap(p_ctx, p_ctx->erta);
+   tmp_chan = p_ctx->chan;
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+   etpu_model_disable_matches(p_ctx);
+   etpu_model_clear_match_a_latch(p_ctx);
+   etpu_model_action_unit_a(p_ctx, etpu_model_fm(p_ctx) & 2, 0);
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+   etpu_model_disable_matches(p_ctx);
+   etpu_model_clear_match_a_latch(p_ctx);
+   etpu_model_action_unit_a(p_ctx, etpu_model_fm(p_ctx) & 2, 0);
+   qd_chan(p_ctx, tmp_chan);
+}
+#endif
+
+/* QD_PROFILING thread hit counters - etpu_eqd_auto.h mirrors a microcode
+   build with QD_PROFILING defined. The counter of each thread, as the
+   QD_PROF_HIT at the start of the threads in etec_eqd.c. */
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+#define PROF_HIT(offset) qd_set24(p_ctx, (offset), qd_get24(p_ctx, (offset)) + 1)
+
+static const uint8_t qd_model_prof[QD_THREAD_COUNT] =
+{
+   FS_ETPU_QD_PROF_INIT_OFFSET,          /* Init */
+   FS_ETPU_QD_PROF_INIT_OFFSET,          /* LatchAndClearErrors */
+   FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET,   /* NonLeadingEdge */
+   FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET,   /* SlowModeLeadingEdge */
+   FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET,   /* NormalModeLeadingEdge */
+   FS_ETPU_QD_PROF_OVERFLOW_OFFSET,      /* PeriodOverflow */
+   FS_ETPU_QD_PROF_FAST_OFFSET,          /* FastModeEdge */
+   FS_ETPU_QD_PROF_INIT_OFFSET,          /* Home_Init */
+   FS_ETPU_QD_PROF_INDEX_HOME_OFFSET,    /* Home_Transition */
+   FS_ETPU_QD_PROF_INIT_OFFSET,          /* Index_Init */
+   FS_ETPU_QD_PROF_INDEX_HOME_OFFSET,    /* Index_FirstTransition */
+   FS_ETPU_QD_PROF_INDEX_HOME_OFFSET,    /* Index_FirstTransitionLink */
+   FS_ETPU_QD_PROF_INDEX_HOME_OFFSET,    /* Index_SecondTransition */
+   FS_ETPU_QD_PROF_INDEX_HOME_OFFSET,    /* Index_SecondTransitionLink */
+   FS_ETPU_QD_PROF_INDEX_HOME_OFFSET,    /* Index_PeriodOverflow */
+   FS_ETPU_QD_PROF_FAST_OFFSET,          /* FastModeMatch */
+};
+
+static void qd_prof_thread(struct etpu_model_ctx_t *p_ctx, uint8_t thread)
+{
+   PROF_HIT(qd_model_prof[thread]);
+}
+#else
+#define PROF_HIT(offset)
+
+static void qd_prof_thread(struct etpu_model_ctx_t *p_ctx, uint8_t thread)
+{
+   (void)p_ctx;
+   (void)thread;
+}
+#endif
+
+#define SET_LLE_EXT(v)  qd_set8(p_ctx, FS_ETPU_QD_LAST_LEADING_EDGE_EXT_OFFSET, (v))
+#define SET_LAST_EDGE_EXT(v) qd_set8(p_ctx, FS_ETPU_QD_LAST_EDGE_EXT_OFFSET, (v))
+
+#define PC              qd_get24(p_ctx, FS_ETPU_QD_PC_OFFSET)
+#define SET_PC(v)       qd_set24(p_ctx, FS_ETPU_QD_PC_OFFSET, (v))
+#define RC              qd_get24(p_ctx, FS_ETPU_QD_RC_OFFSET)
+#define SET_RC(v)       qd_set24(p_ctx, FS_ETPU_QD_RC_OFFSET, (v))
+#define PC_SC           qd_get24(p_ctx, FS_ETPU_QD_PC_SC_OFFSET)
+#define SET_PC_SC(v)    qd_set24(p_ctx, FS_ETPU_QD_PC_SC_OFFSET, (v))
+#define LLE             qd_get24(p_ctx, FS_ETPU_QD_LAST_LEADING_EDGE_OFFSET)
+#define SET_LLE(v)      qd_set24(p_ctx, FS_ETPU_QD_LAST_LEADING_EDGE_OFFSET, (v))
+#define LAST_EDGE       qd_get24(p_ctx, FS_ETPU_QD_LAST_EDGE_OFFSET)
+#define SET_LAST_EDGE(v) qd_set24(p_ctx, FS_ETPU_QD_LAST_EDGE_OFFSET, (v))
+#define DIRECTION       qd_get8(p_ctx, FS_ETPU_QD_DIRECTION_OFFSET)
+#define SET_DIRECTION(v) qd_set8(p_ctx, FS_ETPU_QD_DIRECTION_OFFSET, (v))
+#define LAST_DIRECTION  qd_get8(p_ctx, FS_ETPU_QD_LAST_DIRECTION_OFFSET)
+#define SET_LAST_DIRECTION(v) qd_set8(p_ctx, FS_ETPU_QD_LAST_DIRECTION_OFFSET, (v))
+#define PINS            ((uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PINS_OFFSET))
+#define SET_PINS(v)     qd_set8(p_ctx, FS_ETPU_QD_PINS_OFFSET, (v))
+#define MODE            ((uint8_t)qd_get8(p_ctx, FS_ETPU_QD_MODE_CURRENT_OFFSET))
+#define SET_MODE(v)     qd_set8(p_ctx, FS_ETPU_QD_MODE_CURRENT_OFFSET, (v))
+#define OPTIONS         ((uint8_t)qd_get8(p_ctx, FS_ETPU_QD_OPTIONS_OFFSET))
+#define ERRORS          ((uint8_t)qd_get8(p_ctx, FS_ETPU_QD_ERROR_FLAGS_OFFSET))
+#define SET_ERRORS(v)   qd_set8(p_ctx, FS_ETPU_QD_ERROR_FLAGS_OFFSET, (v))
+#define SEQ_INC()       qd_set24(p_ctx, FS_ETPU_QD_SEQ_OFFSET, qd_get24(p_ctx, FS_ETPU_QD_SEQ_OFFSET) + 1)
+
+#define PRIMARY         ((etpu_model_fm(p_ctx) & 1) == FS_ETPU_QD_FM_CHANNEL_PRIMARY)
+#define PIN_BIT         (PRIMARY ? FS_ETPU_QD_PINS_PIN_A : FS_ETPU_QD_PINS_PIN_B)
+
+/*******************************************************************************
+*                            QD Threads
+*******************************************************************************/
+static void qd_count_edge(struct etpu_model_ctx_t *p_ctx);
+static uint24_t qd_leading_edge_period(struct etpu_model_ctx_t *p_ctx);
+static void qd_normal_to_fast(struct etpu_model_ctx_t *p_ctx);
+static void qd_fast_to_normal(struct etpu_model_ctx_t *p_ctx);
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+static void qd_fast_reversal(struct etpu_model_ctx_t *p_ctx);
+#endif
+static void qd_fast_to_ultra(struct etpu_model_ctx_t *p_ctx);
+static void qd_ultra_fast_edge(struct etpu_model_ctx_t *p_ctx);
+static void qd_ultra_to_slow(struct etpu_model_ctx_t *p_ctx);
+static void qd_ultra_next_edges(struct etpu_model_ctx_t *p_ctx);
+static void qd_fast_to_tcr2(struct etpu_model_ctx_t *p_ctx);
+static void qd_tcr2_reconcile(struct etpu_model_ctx_t *p_ctx);
+static void qd_tcr2_next_match(struct etpu_model_ctx_t *p_ctx);
+static uint8_t qd_slow_from_pins(struct etpu_model_ctx_t *p_ctx);
+static void qd_count_to_pins(struct etpu_model_ctx_t *p_ctx, uint8_t at_level);
+static void qd_slow_mode_next_edge(struct etpu_model_ctx_t *p_ctx);
+static void qd_leading_edge_window(struct etpu_model_ctx_t *p_ctx);
+static void qd_window_next_edge(struct etpu_model_ctx_t *p_ctx);
+static void qd_pc_interrupt(struct etpu_model_ctx_t *p_ctx);
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+static void qd_trigger_edge(struct etpu_model_ctx_t *p_ctx);
+static void qd_trigger_seek(struct etpu_model_ctx_t *p_ctx);
+#endif
+static void qd_pc_max(struct etpu_model_ctx_t *p_ctx);
+
+/* pins bits on their leading edge level */
+static uint8_t qd_at_level(uint8_t pins)
+{
+   return((pins & FS_ETPU_QD_PINS_CONFIGURATION) ? pins : (uint8_t)~pins);
+}
+
+/* pins = both pins on their leading edge level */
+static void qd_leading_edge_pins(struct etpu_model_ctx_t *p_ctx)
+{
+   if (PINS & FS_ETPU_QD_PINS_CONFIGURATION)
+   {
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+      SET_PINS(FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B + FS_ETPU_QD_PINS_CONFIGURATION);
+   }
+   else
+   {
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+      SET_PINS(0);
+   }
+}
+
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+/* error counter += 1, saturated at FS_ETPU_QD_ERROR_COUNT_MAX */
+static void qd_error_count(struct etpu_model_ctx_t *p_ctx, uint8_t offset)
+{
+   if ((qd_get24(p_ctx, offset) & 0xffffff) < FS_ETPU_QD_ERROR_COUNT_MAX)
+      qd_set24(p_ctx, offset, qd_get24(p_ctx, offset) + 1);
+}
+#endif
+
+/* SLOW mode, pin back on its level before the edge - not counted */
+static void qd_spurious_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   SET_ERRORS(ERRORS | FS_ETPU_QD_ERROR_SPURIOUS);
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+   qd_error_count(p_ctx, FS_ETPU_QD_SPURIOUS_COUNT_OFFSET);
+#endif
+   etpu_model_clear_trans_latch(p_ctx);
+   SEQ_INC();
+}
+
+/* SLOW mode, the other pin must still be on the level of its last edge */
+static void qd_illegal_check(struct etpu_model_ctx_t *p_ctx, uint8_t pin_bit)
+{
+   uint8_t tmp_chan = p_ctx->chan;
+   uint8_t other_bit = pin_bit ^ (FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B);
+   uint8_t illegal;
+
+   if (pin_bit == FS_ETPU_QD_PINS_PIN_A)
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+   else
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+   illegal = (etpu_model_pin(p_ctx) != 0) != ((PINS & other_bit) != 0);
+   qd_chan(p_ctx, tmp_chan);
+   if (illegal)
+   {
+      SET_ERRORS(ERRORS | FS_ETPU_QD_ERROR_ILLEGAL);
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+      qd_error_count(p_ctx, FS_ETPU_QD_ILLEGAL_COUNT_OFFSET);
+#endif
+   }
+}
+
+/* pins = both input pins */
+static void qd_read_pins(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t tmp_chan = p_ctx->chan;
+
+   SET_PINS(PINS & FS_ETPU_QD_PINS_CONFIGURATION);
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+   if (etpu_model_pin(p_ctx))
+      SET_PINS(PINS | FS_ETPU_QD_PINS_PIN_A);
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+   if (etpu_model_pin(p_ctx))
+      SET_PINS(PINS | FS_ETPU_QD_PINS_PIN_B);
+   qd_chan(p_ctx, tmp_chan);
+}
+
+/* position modulo 4 of the pins */
+static uint8_t qd_pin_state(uint8_t pins)
+{
+   uint8_t state = (pins & FS_ETPU_QD_PINS_PIN_B) ? 3 : 0;
+
+   return((pins & FS_ETPU_QD_PINS_PIN_A) ? (state ^ 1) : state);
+}
+
+static uint8_t qd_slow_from_pins(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t tmp_chan, at_level;
+
+   PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+   SET_MODE(QD_MODE_SLOW);
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      SET_DIRECTION(QD_DIRECTION_DECREMENT);
+   else
+      SET_DIRECTION(QD_DIRECTION_INCREMENT);
+   qd_read_pins(p_ctx);
+   at_level = qd_at_level(PINS) & (FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B);
+   tmp_chan = p_ctx->chan;
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+   etpu_model_on_trans_a(p_ctx, (PINS & FS_ETPU_QD_PINS_PIN_A) ?
+                         ETPU_MODEL_IPAC_HIGH_LOW : ETPU_MODEL_IPAC_LOW_HIGH);
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+   etpu_model_clear_all_latches(p_ctx);
+   etpu_model_set_flag0(p_ctx, 0);
+   etpu_model_set_flag1(p_ctx, at_level == FS_ETPU_QD_PINS_PIN_B);
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+   etpu_model_on_trans_a(p_ctx, (PINS & FS_ETPU_QD_PINS_PIN_B) ?
+                         ETPU_MODEL_IPAC_HIGH_LOW : ETPU_MODEL_IPAC_LOW_HIGH);
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+   etpu_model_clear_all_latches(p_ctx);
+   etpu_model_set_flag0(p_ctx, 0);
+   etpu_model_set_flag1(p_ctx, at_level == FS_ETPU_QD_PINS_PIN_A);
+   qd_chan(p_ctx, tmp_chan);
+   return(at_level);
+}
+
+static void qd_count_to_pins(struct etpu_model_ctx_t *p_ctx, uint8_t at_level)
+{
+   int32_t counts = 0;
+
+   if (at_level != FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B)
+   {
+      counts = DIRECTION;
+      if (at_level != PIN_BIT)
+      {
+         counts += DIRECTION;
+         if (at_level != 0)
+            counts += DIRECTION;
+      }
+   }
+   SET_PC(PC + counts);
+   SET_PC_SC(PC_SC + counts);
+   qd_position_add(p_ctx, counts);
+}
+
+static void qd_init(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tcr;
+   uint8_t tmp_chan, at_level;
+
+   SEQ_INC();
+   if (etpu_model_fm(p_ctx) & 2)
+   {
+      etpu_model_action_units(p_ctx, 1);
+      tcr = etpu_model_tcr2();
+   }
+   else
+   {
+      etpu_model_action_units(p_ctx, 0);
+      tcr = etpu_model_tcr1();
+   }
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+   etpu_model_clear_all_latches(p_ctx);
+   SET_LLE(tcr);
+   qd_set32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET,
+            (qd_get32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET) & 0xff000000) | (tcr & 0xffffff));
+   SET_LLE_EXT(qd_get32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET) >> 24);
+   SET_LAST_EDGE_EXT(qd_get32(p_ctx, FS_ETPU_QD_TCR_EXT_OFFSET) >> 24);
+   if (etpu_model_pin(p_ctx))
+   {
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+      SET_PINS(PINS | PIN_BIT);
+   }
+   else
+   {
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+      SET_PINS(PINS & ~PIN_BIT);
+   }
+   SET_PC(0);
+   SET_MODE(QD_MODE_SLOW);
+   qd_set32(p_ctx, QD_PERIOD_ACCUM_OFFSET, 0);
+
+   at_level = qd_at_level(PINS) & (FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B);
+   tmp_chan = p_ctx->chan;
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+   etpu_model_set_flag0(p_ctx, 0);
+   etpu_model_set_flag1(p_ctx, at_level == FS_ETPU_QD_PINS_PIN_B);
+   qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+   etpu_model_set_flag0(p_ctx, 0);
+   etpu_model_set_flag1(p_ctx, at_level == FS_ETPU_QD_PINS_PIN_A);
+   qd_chan(p_ctx, tmp_chan);
+
+   qd_set8(p_ctx, QD_FOUND_LEADING_EDGE_OFFSET, 0);
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+   qd_set8(p_ctx, QD_IRQ_STATE_OFFSET, QD_IRQ_ARMED1 + QD_IRQ_ARMED2);
+#endif
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   qd_set8(p_ctx, FS_ETPU_QD_STANDSTILL_OFFSET, 0);
+#endif
+   p_ctx->erta = (LLE + 0x800000) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+   SEQ_INC();
+}
+
+static void qd_latch_and_clear_errors(struct etpu_model_ctx_t *p_ctx)
+{
+   SEQ_INC();
+   qd_set8(p_ctx, FS_ETPU_QD_LATCHED_ERROR_FLAGS_OFFSET, ERRORS);
+   SET_ERRORS(0);
+   SEQ_INC();
+}
+
+static void qd_non_leading_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t tmp_chan, pin_bit, pins, at_level;
+
+   SEQ_INC();
+   pin_bit = PIN_BIT;
+   if ((MODE & QD_MODE_SLOW) && ((etpu_model_pin(p_ctx) != 0) == ((PINS & pin_bit) != 0)))
+   {
+      qd_spurious_edge(p_ctx);
+      return;
+   }
+   pins = PINS ^ pin_bit;
+   SET_PINS(pins);
+   if (pins & pin_bit)
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+   else
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+
+   if (MODE & QD_MODE_SLOW)
+   {
+      if ((!PRIMARY) ^ (pins & FS_ETPU_QD_PINS_PIN_A) ^ ((pins & FS_ETPU_QD_PINS_PIN_B) >> 1))
+         SET_DIRECTION(QD_DIRECTION_INCREMENT);
+      else
+         SET_DIRECTION(QD_DIRECTION_DECREMENT);
+      qd_illegal_check(p_ctx, pin_bit);
+   }
+   else if (!etpu_model_trans_a_latched(p_ctx))
+   {
+      p_ctx->erta = (LAST_EDGE + ((qd_get32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET) & 0xffffff) >> 2)) & 0xffffff;
+      SET_ERRORS(ERRORS | FS_ETPU_QD_ERROR_WINDOWING);
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+      qd_error_count(p_ctx, FS_ETPU_QD_WINDOW_COUNT_OFFSET);
+#endif
+   }
+   qd_count_edge(p_ctx);
+
+   SET_MODE(MODE & ~(QD_LEADING_EDGE_INDICATION | QD_FAST_TO_NORMAL_SWITCH));
+
+   at_level = qd_at_level(pins);
+   if (at_level & (pin_bit ^ (FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B)))
+   {
+      if (MODE & QD_MODE_SLOW)
+         etpu_model_set_flag1(p_ctx, 1);
+      else
+         etpu_model_set_flag0(p_ctx, 1);
+   }
+   else
+   {
+      tmp_chan = p_ctx->chan;
+      if (PRIMARY)
+         qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+      else
+         qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+      if (!(at_level & pin_bit))
+      {
+         etpu_model_set_flag0(p_ctx, 0);
+         etpu_model_set_flag1(p_ctx, 0);
+      }
+      else if (MODE & QD_MODE_SLOW)
+         etpu_model_set_flag1(p_ctx, 1);
+      else
+         etpu_model_set_flag0(p_ctx, 1);
+      qd_chan(p_ctx, tmp_chan);
+   }
+
+   if (MODE & QD_MODE_SLOW)
+      qd_slow_mode_next_edge(p_ctx);
+   else
+      qd_window_next_edge(p_ctx);
+}
+
+static void qd_slow_mode_leading_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tmp_period;
+
+   SEQ_INC();
+   if ((etpu_model_pin(p_ctx) != 0) != ((PINS & FS_ETPU_QD_PINS_CONFIGURATION) != 0))
+   {
+      qd_spurious_edge(p_ctx);
+      return;
+   }
+   etpu_model_set_flag1(p_ctx, 0);
+   qd_leading_edge_pins(p_ctx);
+   if (PRIMARY)
+      SET_DIRECTION(QD_DIRECTION_DECREMENT);
+   else
+      SET_DIRECTION(QD_DIRECTION_INCREMENT);
+   qd_illegal_check(p_ctx, PIN_BIT);
+   qd_count_edge(p_ctx);
+   tmp_period = qd_leading_edge_period(p_ctx);
+
+   if (!qd_get8(p_ctx, QD_FOUND_LEADING_EDGE_OFFSET))
+   {
+      qd_set8(p_ctx, QD_FOUND_LEADING_EDGE_OFFSET, 1);
+      SET_MODE(MODE | QD_LEADING_EDGE_INDICATION);
+      qd_slow_mode_next_edge(p_ctx);
+   }
+   else if ((tmp_period < (qd_get24(p_ctx, FS_ETPU_QD_SLOW_NORMAL_THR_OFFSET) & 0xffffff)) &&
+            ((qd_get32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET) >> 24) == 0))
+   {
+      PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+      SET_MODE(QD_MODE_NORMAL + QD_LEADING_EDGE_INDICATION);
+      qd_leading_edge_window(p_ctx);
+   }
+   else
+   {
+      SET_MODE(QD_MODE_SLOW + QD_LEADING_EDGE_INDICATION);
+      qd_slow_mode_next_edge(p_ctx);
+   }
+}
+
+static void qd_normal_mode_leading_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tmp_period;
+
+   SEQ_INC();
+   etpu_model_set_flag0(p_ctx, 0);
+   qd_leading_edge_pins(p_ctx);
+   if (!etpu_model_trans_a_latched(p_ctx))
+   {
+      p_ctx->erta = (LAST_EDGE + ((qd_get32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET) & 0xffffff) >> 2)) & 0xffffff;
+      SET_ERRORS(ERRORS | FS_ETPU_QD_ERROR_WINDOWING);
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+      qd_error_count(p_ctx, FS_ETPU_QD_WINDOW_COUNT_OFFSET);
+#endif
+   }
+   qd_count_edge(p_ctx);
+   tmp_period = qd_leading_edge_period(p_ctx);
+
+   if (tmp_period < (qd_get24(p_ctx, FS_ETPU_QD_NORMAL_FAST_THR_OFFSET) & 0xffffff))
+   {
+      qd_normal_to_fast(p_ctx);
+   }
+   else if (tmp_period > (qd_get24(p_ctx, FS_ETPU_QD_NORMAL_SLOW_THR_OFFSET) & 0xffffff))
+   {
+      PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+      SET_MODE(QD_LEADING_EDGE_INDICATION + QD_MODE_SLOW);
+      qd_slow_mode_next_edge(p_ctx);
+   }
+   else
+   {
+      SET_MODE(QD_MODE_NORMAL + QD_LEADING_EDGE_INDICATION);
+      qd_leading_edge_window(p_ctx);
+   }
+}
+
+static void qd_period_overflow(struct etpu_model_ctx_t *p_ctx)
+{
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   uint24_t tmp_elapsed, timeout;
+   uint8_t tmp_chan;
+#endif
+
+   etpu_model_clear_match_a_latch(p_ctx);
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   if (qd_get8(p_ctx, FS_ETPU_QD_STANDSTILL_OFFSET))
+   {
+      qd_standstill_overflow(p_ctx);
+      return;
+   }
+#endif
+   qd_accumulate(p_ctx, QD_PERIOD_ACCUM_OFFSET, p_ctx->erta - LLE);
+   SET_LLE(p_ctx->erta);
+   SET_LLE_EXT(qd_time_ext(p_ctx, p_ctx->erta));
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+   if (qd_get8(p_ctx, QD_IRQ_STATE_OFFSET) & QD_IRQ_HOLD)
+   {
+      if (((p_ctx->erta - qd_get24(p_ctx, QD_IRQ_LAST_TIME_OFFSET)) & 0xffffff) >=
+          ((uint24_t)qd_get24(p_ctx, FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET) & 0xffffff))
+         qd_set8(p_ctx, QD_IRQ_STATE_OFFSET, qd_get8(p_ctx, QD_IRQ_STATE_OFFSET) & ~QD_IRQ_HOLD);
+   }
+#endif
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   tmp_elapsed = (p_ctx->erta - LAST_EDGE) & 0xffffff;
+#endif
+   p_ctx->erta = (p_ctx->erta + 0x800000) & 0xffffff;
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   timeout = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_STANDSTILL_TIMEOUT_OFFSET) & 0xffffff;
+   if ((timeout != 0) && (MODE & QD_MODE_SLOW))
+   {
+      if (tmp_elapsed >= timeout)
+      {
+         SEQ_INC();
+         qd_set8(p_ctx, FS_ETPU_QD_STANDSTILL_OFFSET, 1);
+         SEQ_INC();
+         if (qd_get8(p_ctx, FS_ETPU_QD_STANDSTILL_IRQ_OFFSET))
+            etpu_model_channel_interrupt(p_ctx);
+         tmp_chan = p_ctx->chan;
+         if (PRIMARY)
+            qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+         else
+            qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+         etpu_model_disable_matches(p_ctx);
+         etpu_model_clear_match_a_latch(p_ctx);
+         qd_chan(p_ctx, tmp_chan);
+      }
+      else
+         p_ctx->erta = (LAST_EDGE + timeout) & 0xffffff;
+   }
+#endif
+   etpu_model_write_erta_match_a(p_ctx);
+}
+
+static void qd_fast_mode_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tmp_period;
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+   uint8_t tmp_chan, at_level;
+#endif
+
+   SEQ_INC();
+   if (MODE & QD_MODE_ULTRA_FAST)
+   {
+      qd_ultra_fast_edge(p_ctx);
+      return;
+   }
+   if (!etpu_model_trans_a_latched(p_ctx))
+   {
+      p_ctx->erta = (LAST_EDGE + (qd_get32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET) & 0xffffff)) & 0xffffff;
+      SET_ERRORS(ERRORS | FS_ETPU_QD_ERROR_WINDOWING);
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+      qd_error_count(p_ctx, FS_ETPU_QD_WINDOW_COUNT_OFFSET);
+#endif
+   }
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+   else if (qd_get8(p_ctx, FS_ETPU_QD_FAST_REVERSAL_OFFSET))
+   {
+      if (etpu_model_fm(p_ctx) & 2)
+         tmp_period = (etpu_model_tcr2() - p_ctx->erta) & 0xffffff;
+      else
+         tmp_period = (etpu_model_tcr1() - p_ctx->erta) & 0xffffff;
+      if (tmp_period < ((qd_get32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET) & 0xffffff) >> 2))
+      {
+         tmp_chan = p_ctx->chan;
+         if (PRIMARY)
+            qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+         else
+            qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+         at_level = etpu_model_pin(p_ctx);
+         qd_chan(p_ctx, tmp_chan);
+         if (!(PINS & FS_ETPU_QD_PINS_CONFIGURATION))
+            at_level ^= 1;
+         if (!at_level)
+         {
+            qd_fast_reversal(p_ctx);
+            return;
+         }
+      }
+   }
+#endif
+   qd_count_edge(p_ctx);
+   tmp_period = qd_leading_edge_period(p_ctx);
+
+   if (tmp_period > (qd_get24(p_ctx, FS_ETPU_QD_FAST_NORMAL_THR_OFFSET) & 0xffffff))
+   {
+      qd_fast_to_normal(p_ctx);
+   }
+   else if ((tmp_period < (qd_get24(p_ctx, FS_ETPU_QD_FAST_TCR2_THR_OFFSET) & 0xffffff)) &&
+            !(etpu_model_fm(p_ctx) & 2))
+   {
+      qd_fast_to_tcr2(p_ctx);
+   }
+   else if (tmp_period < (qd_get24(p_ctx, FS_ETPU_QD_FAST_ULTRA_THR_OFFSET) & 0xffffff))
+   {
+      qd_fast_to_ultra(p_ctx);
+   }
+   else
+   {
+      SET_MODE(QD_MODE_FAST + QD_LEADING_EDGE_INDICATION);
+      qd_leading_edge_window(p_ctx);
+   }
+}
+
+static void qd_fast_mode_match(struct etpu_model_ctx_t *p_ctx)
+{
+   SEQ_INC();
+   etpu_model_clear_match_a_latch(p_ctx);
+   if (MODE & QD_MODE_TCR2)
+   {
+      qd_tcr2_reconcile(p_ctx);
+      return;
+   }
+   if (MODE & QD_MODE_ULTRA_FAST)
+   {
+      qd_ultra_to_slow(p_ctx);
+      return;
+   }
+   SEQ_INC();
+}
+
+static void qd_fast_to_ultra(struct etpu_model_ctx_t *p_ctx)
+{
+   PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+   SET_MODE(QD_MODE_ULTRA_FAST + QD_LEADING_EDGE_INDICATION);
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      SET_DIRECTION(QD_DIRECTION_DECREMENT_ULTRA);
+   else
+      SET_DIRECTION(QD_DIRECTION_INCREMENT_ULTRA);
+   if (PINS & FS_ETPU_QD_PINS_CONFIGURATION)
+      etpu_model_on_trans_b(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+   else
+      etpu_model_on_trans_b(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+   qd_ultra_next_edges(p_ctx);
+}
+
+static void qd_ultra_fast_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tmp_period;
+
+   if (etpu_model_trans_b_latched(p_ctx))
+   {
+      SET_LLE(p_ctx->erta);
+      p_ctx->erta = p_ctx->ertb;
+      qd_count_edge(p_ctx);
+      tmp_period = qd_leading_edge_period(p_ctx);
+      if (tmp_period > (qd_get24(p_ctx, FS_ETPU_QD_ULTRA_FAST_THR_OFFSET) & 0xffffff))
+      {
+         PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+         SET_MODE(QD_MODE_FAST + QD_LEADING_EDGE_INDICATION);
+         if (DIRECTION & QD_DIRECTION_BIT7)
+            SET_DIRECTION(QD_DIRECTION_DECREMENT_FAST);
+         else
+            SET_DIRECTION(QD_DIRECTION_INCREMENT_FAST);
+         qd_leading_edge_window(p_ctx);
+      }
+      else if ((tmp_period < (qd_get24(p_ctx, FS_ETPU_QD_FAST_TCR2_THR_OFFSET) & 0xffffff)) &&
+               !(etpu_model_fm(p_ctx) & 2))
+      {
+         qd_fast_to_tcr2(p_ctx);
+      }
+      else
+      {
+         SET_MODE(QD_MODE_ULTRA_FAST + QD_LEADING_EDGE_INDICATION);
+         qd_ultra_next_edges(p_ctx);
+      }
+      return;
+   }
+   if (etpu_model_trans_a_latched(p_ctx))
+   {
+      if (DIRECTION & QD_DIRECTION_BIT7)
+         SET_DIRECTION(QD_DIRECTION_DECREMENT_FAST);
+      else
+         SET_DIRECTION(QD_DIRECTION_INCREMENT_FAST);
+      qd_count_edge(p_ctx);
+      qd_leading_edge_period(p_ctx);
+   }
+   qd_ultra_to_slow(p_ctx);
+}
+
+static void qd_ultra_to_slow(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_disable_matches(p_ctx);
+   qd_count_to_pins(p_ctx, qd_slow_from_pins(p_ctx));
+   qd_slow_mode_next_edge(p_ctx);
+}
+
+static void qd_ultra_next_edges(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_DT);
+   etpu_model_clear_all_latches(p_ctx);
+   p_ctx->erta = (LAST_EDGE + ((qd_get24(p_ctx, FS_ETPU_QD_ULTRA_FAST_THR_OFFSET) & 0xffffff) << 2)) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+   SEQ_INC();
+}
+
+static void qd_fast_to_tcr2(struct etpu_model_ctx_t *p_ctx)
+{
+   PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+   SET_MODE(QD_MODE_TCR2);
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      SET_DIRECTION(QD_DIRECTION_DECREMENT);
+   else
+      SET_DIRECTION(QD_DIRECTION_INCREMENT);
+   etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_NO_DETECT);
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+   etpu_model_clear_all_latches(p_ctx);
+   qd_read_pins(p_ctx);
+   qd_set24(p_ctx, QD_TCR2_BASE_OFFSET, etpu_model_tcr2());
+   SET_LAST_EDGE(etpu_model_tcr1());
+   SET_LAST_EDGE_EXT(qd_time_ext(p_ctx, LAST_EDGE));
+   qd_count_to_pins(p_ctx, qd_at_level(PINS) & (FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B));
+   qd_set8(p_ctx, QD_TCR2_STATE_OFFSET, qd_pin_state(PINS));
+   p_ctx->erta = (LAST_EDGE + qd_get24(p_ctx, FS_ETPU_QD_TCR2_INTERVAL_OFFSET)) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+   SEQ_INC();
+}
+
+static void qd_tcr2_reconcile(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tmp_tcr2, tmp_time, tmp_period, tmp_edges;
+   int32_t counts;
+   uint8_t state;
+
+   tmp_tcr2 = etpu_model_tcr2();
+   qd_read_pins(p_ctx);
+   if (etpu_model_tcr2() != tmp_tcr2)
+   {
+      tmp_tcr2 = etpu_model_tcr2();
+      qd_read_pins(p_ctx);
+      if (etpu_model_tcr2() != tmp_tcr2)
+      {
+         qd_tcr2_next_match(p_ctx);
+         return;
+      }
+   }
+   tmp_time = etpu_model_tcr1();
+   state = qd_pin_state(PINS);
+   counts = state - (uint8_t)qd_get8(p_ctx, QD_TCR2_STATE_OFFSET);
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      counts = -counts;
+   tmp_edges = ((tmp_tcr2 - qd_get24(p_ctx, QD_TCR2_BASE_OFFSET)) << 1) & 0xffffff;
+   counts = ((((counts - (int32_t)tmp_edges + 1) & 3) + tmp_edges - 1) << 8) >> 8;
+   if (DIRECTION & QD_DIRECTION_BIT7)
+   {
+      SET_PC(PC - counts);
+      SET_PC_SC(PC_SC - counts);
+      qd_position_add(p_ctx, -counts);
+   }
+   else
+   {
+      SET_PC(PC + counts);
+      SET_PC_SC(PC_SC + counts);
+      qd_position_add(p_ctx, counts);
+   }
+   qd_set24(p_ctx, QD_TCR2_BASE_OFFSET, tmp_tcr2);
+   qd_set8(p_ctx, QD_TCR2_STATE_OFFSET, state);
+   tmp_period = (tmp_time - LAST_EDGE) & 0xffffff;
+   SET_LAST_EDGE(tmp_time);
+   SET_LLE(tmp_time);
+   SET_LAST_EDGE_EXT(qd_time_ext(p_ctx, tmp_time));
+   SET_LLE_EXT(qd_get8(p_ctx, FS_ETPU_QD_LAST_EDGE_EXT_OFFSET));
+   qd_set32(p_ctx, QD_PERIOD_ACCUM_OFFSET, 0);
+   qd_pc_max(p_ctx);
+   qd_set32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET, FS_ETPU_QD_PERIOD_STANDSTILL);
+   if (counts > 0)
+   {
+      tmp_period = ((tmp_period << 2) & 0xffffff) / (uint24_t)counts;
+      qd_set32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET, tmp_period);
+   }
+   if ((counts <= 0) || (tmp_period > (qd_get24(p_ctx, FS_ETPU_QD_TCR2_FAST_THR_OFFSET) & 0xffffff)))
+   {
+      qd_slow_from_pins(p_ctx);
+      qd_slow_mode_next_edge(p_ctx);
+      return;
+   }
+   qd_tcr2_next_match(p_ctx);
+}
+
+static void qd_tcr2_next_match(struct etpu_model_ctx_t *p_ctx)
+{
+   p_ctx->erta = (p_ctx->erta + qd_get24(p_ctx, FS_ETPU_QD_TCR2_INTERVAL_OFFSET)) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+   SEQ_INC();
+}
+
+static void qd_normal_to_fast(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t tmp_chan;
+
+   PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+   SET_MODE(QD_MODE_FAST + QD_LEADING_EDGE_INDICATION);
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      SET_DIRECTION(QD_DIRECTION_DECREMENT_FAST);
+   else
+      SET_DIRECTION(QD_DIRECTION_INCREMENT_FAST);
+   etpu_model_set_flag0(p_ctx, 1);
+   etpu_model_set_flag1(p_ctx, 1);
+   if (PINS & FS_ETPU_QD_PINS_CONFIGURATION)
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+   else
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+   tmp_chan = p_ctx->chan;
+   if (PRIMARY)
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+   else
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+   etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_NO_DETECT);
+   etpu_model_disable_matches(p_ctx);
+   etpu_model_clear_all_latches(p_ctx);
+   qd_chan(p_ctx, tmp_chan);
+   qd_leading_edge_window(p_ctx);
+}
+
+static void qd_fast_to_normal(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t tmp_chan;
+
+   PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+   SET_MODE(QD_FAST_TO_NORMAL_SWITCH + QD_MODE_NORMAL + QD_LEADING_EDGE_INDICATION);
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      SET_DIRECTION(QD_DIRECTION_DECREMENT);
+   else
+      SET_DIRECTION(QD_DIRECTION_INCREMENT);
+   etpu_model_set_flag0(p_ctx, 0);
+   etpu_model_set_flag1(p_ctx, 0);
+   if (PINS & FS_ETPU_QD_PINS_CONFIGURATION)
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+   else
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+   SET_PC(PC + DIRECTION);
+   SET_PC_SC(PC_SC + DIRECTION);
+   qd_position_add(p_ctx, DIRECTION);
+   tmp_chan = p_ctx->chan;
+   if (PRIMARY)
+   {
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+      SET_PINS(PINS ^ FS_ETPU_QD_PINS_PIN_B);
+   }
+   else
+   {
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+      SET_PINS(PINS ^ FS_ETPU_QD_PINS_PIN_A);
+   }
+   if (PINS & FS_ETPU_QD_PINS_CONFIGURATION)
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+   else
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+   etpu_model_set_flag0(p_ctx, 1);
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+   qd_chan(p_ctx, tmp_chan);
+   qd_leading_edge_window(p_ctx);
+}
+
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+static void qd_fast_reversal(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t tmp_chan;
+
+   PROF_HIT(FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET);
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      SET_DIRECTION(QD_DIRECTION_DECREMENT);
+   else
+      SET_DIRECTION(QD_DIRECTION_INCREMENT);
+   qd_count_edge(p_ctx);
+   SET_DIRECTION(-DIRECTION);
+   SET_ERRORS(ERRORS | FS_ETPU_QD_ERROR_REVERSAL);
+   SET_MODE(QD_MODE_SLOW);
+
+   etpu_model_set_flag0(p_ctx, 0);
+   etpu_model_set_flag1(p_ctx, 0);
+   if (PINS & FS_ETPU_QD_PINS_CONFIGURATION)
+   {
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+      SET_PINS(PIN_BIT + FS_ETPU_QD_PINS_CONFIGURATION);
+   }
+   else
+   {
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+      SET_PINS(PIN_BIT ^ (FS_ETPU_QD_PINS_PIN_A + FS_ETPU_QD_PINS_PIN_B));
+   }
+   tmp_chan = p_ctx->chan;
+   if (PRIMARY)
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_B_CHAN_OFFSET));
+   else
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+   if (PINS & FS_ETPU_QD_PINS_CONFIGURATION)
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+   else
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+   etpu_model_set_flag0(p_ctx, 0);
+   etpu_model_set_flag1(p_ctx, 1);
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+   etpu_model_clear_all_latches(p_ctx);
+   qd_chan(p_ctx, tmp_chan);
+   qd_slow_mode_next_edge(p_ctx);
+}
+#endif
+
+static void qd_slow_mode_next_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+   etpu_model_clear_all_latches(p_ctx);
+   p_ctx->erta = (LAST_EDGE + 0x800000) & 0xffffff;
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   if (qd_get24(p_ctx, FS_ETPU_QD_STANDSTILL_TIMEOUT_OFFSET) & 0xffffff)
+      p_ctx->erta = (LAST_EDGE + qd_get24(p_ctx, FS_ETPU_QD_STANDSTILL_TIMEOUT_OFFSET)) & 0xffffff;
+#endif
+   etpu_model_write_erta_match_a(p_ctx);
+   SEQ_INC();
+}
+
+static void qd_leading_edge_window(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tmp_period;
+
+   if ((OPTIONS & FS_ETPU_QD_WINDOWING_DISABLED) == 0)
+   {
+      tmp_period = qd_get32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET) & 0xffffff;
+      if (MODE & QD_MODE_NORMAL)
+         tmp_period >>= 1;
+      qd_set24(p_ctx, QD_WINDOW_END_OFFSET,
+               tmp_period + qd_mulir(tmp_period, qd_get24(p_ctx, FS_ETPU_QD_RATIO2_OFFSET)));
+      qd_set24(p_ctx, QD_WINDOW_BEGIN_OFFSET,
+               qd_mulir(tmp_period, qd_get24(p_ctx, FS_ETPU_QD_RATIO1_OFFSET)));
+   }
+   qd_window_next_edge(p_ctx);
+}
+
+static void qd_window_next_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   p_ctx->erta = (uint24_t)LAST_EDGE & 0xffffff;
+   if (OPTIONS & FS_ETPU_QD_WINDOWING_DISABLED)
+   {
+      etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_SM_ST);
+      etpu_model_clear_all_latches(p_ctx);
+   }
+   else
+   {
+      etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_M2_ST);
+      p_ctx->ertb = (p_ctx->erta + qd_get24(p_ctx, QD_WINDOW_END_OFFSET)) & 0xffffff;
+      if (!etpu_model_match_b_latched(p_ctx))
+         p_ctx->erta = (p_ctx->erta + qd_get24(p_ctx, QD_WINDOW_BEGIN_OFFSET)) & 0xffffff;
+      etpu_model_clear_all_latches(p_ctx);
+      etpu_model_write_erta_match_a(p_ctx);
+      etpu_model_write_ertb_match_b(p_ctx);
+   }
+   SEQ_INC();
+}
+
+static void qd_count_edge(struct etpu_model_ctx_t *p_ctx)
+{
+#ifdef FS_ETPU_QD_HIST_START_OFFSET
+   uint24_t wr, rec;
+#endif
+
+   etpu_model_disable_matches(p_ctx);
+
+   SET_LAST_EDGE(p_ctx->erta);
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   if (qd_get8(p_ctx, FS_ETPU_QD_STANDSTILL_OFFSET))
+      qd_standstill_end(p_ctx);
+#endif
+   SET_LAST_EDGE_EXT(qd_time_ext(p_ctx, p_ctx->erta));
+   SET_PC(PC + DIRECTION);
+   SET_PC_SC(PC_SC + DIRECTION);
+   qd_position_add(p_ctx, DIRECTION);
+
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+   if (qd_get8(p_ctx, FS_ETPU_QD_STANDSTILL_OFFSET))
+   {
+      qd_set8(p_ctx, FS_ETPU_QD_STANDSTILL_OFFSET, 0);
+      qd_set32(p_ctx, QD_PERIOD_ACCUM_OFFSET, FS_ETPU_QD_PERIOD_STANDSTILL);
+      SET_LLE(p_ctx->erta);
+      SET_LLE_EXT(qd_get8(p_ctx, FS_ETPU_QD_LAST_EDGE_EXT_OFFSET));
+   }
+#endif
+
+#ifdef FS_ETPU_QD_HIST_START_OFFSET
+   if (OPTIONS & FS_ETPU_QD_EDGE_HISTORY_ENABLED)
+   {
+      wr = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_HIST_WR_OFFSET) & 0xffffff;
+      *(uint32_t*)etpu_model_sdm(wr) = ((uint32_t)(uint8_t)DIRECTION << 24) | (p_ctx->erta & 0xffffff);
+      rec = wr + 4;
+      if (rec >= ((uint24_t)qd_get24(p_ctx, FS_ETPU_QD_HIST_END_OFFSET) & 0xffffff))
+         rec = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_HIST_START_OFFSET) & 0xffffff;
+      qd_set24(p_ctx, FS_ETPU_QD_HIST_WR_OFFSET, rec);
+   }
+#endif
+
+   if (OPTIONS & FS_ETPU_QD_PC_INTERRUPT_ENABLED)
+      qd_pc_interrupt(p_ctx);
+
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+   if (OPTIONS & FS_ETPU_QD_TRIGGER_TABLE_ENABLED)
+      qd_trigger_edge(p_ctx);
+#endif
+}
+
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+/* 24-bit __abs(a - b) */
+static int32_t qd_abs_diff24(int32_t a, int32_t b)
+{
+   int32_t diff = ((a - b) << 8) >> 8;
+
+   return(diff < 0 ? -diff : diff);
+}
+
+#endif
+
+static void qd_pc_interrupt(struct etpu_model_ctx_t *p_ctx)
+{
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+   uint8_t state, armed, hit;
+   uint8_t hysteresis, rev_div;
+   uint24_t min_interval;
+   int32_t pc, rc;
+
+   state = (uint8_t)qd_get8(p_ctx, QD_IRQ_STATE_OFFSET);
+   min_interval = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET) & 0xffffff;
+   if (state & QD_IRQ_HOLD)
+   {
+      if (((p_ctx->erta - qd_get24(p_ctx, QD_IRQ_LAST_TIME_OFFSET)) & 0xffffff) >= min_interval)
+         state &= ~QD_IRQ_HOLD;
+   }
+   hit = 0;
+   armed = 0;
+   pc = PC;
+   hysteresis = (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_IRQ_HYSTERESIS_OFFSET);
+   if (pc == qd_get24(p_ctx, FS_ETPU_QD_PCINTERRUPT1_OFFSET))
+   {
+      hit = 1;
+      armed = state & QD_IRQ_ARMED1;
+      state &= ~QD_IRQ_ARMED1;
+   }
+   else if (qd_abs_diff24(pc, qd_get24(p_ctx, FS_ETPU_QD_PCINTERRUPT1_OFFSET)) > hysteresis)
+   {
+      state |= QD_IRQ_ARMED1;
+   }
+   if (pc == qd_get24(p_ctx, FS_ETPU_QD_PCINTERRUPT2_OFFSET))
+   {
+      hit = 1;
+      armed |= state & QD_IRQ_ARMED2;
+      state &= ~QD_IRQ_ARMED2;
+   }
+   else if (qd_abs_diff24(pc, qd_get24(p_ctx, FS_ETPU_QD_PCINTERRUPT2_OFFSET)) > hysteresis)
+   {
+      state |= QD_IRQ_ARMED2;
+   }
+   if (hit)
+   {
+      rev_div = (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_IRQ_REV_DIV_OFFSET);
+      rc = (rev_div > 1) ? RC : 0;
+      if (armed && !(state & QD_IRQ_HOLD) &&
+          ((rev_div <= 1) || (qd_abs_diff24(rc, 0) % rev_div == 0)))
+      {
+         etpu_model_channel_interrupt(p_ctx);
+         if (min_interval != 0)
+         {
+            qd_set24(p_ctx, QD_IRQ_LAST_TIME_OFFSET, p_ctx->erta);
+            state |= QD_IRQ_HOLD;
+         }
+      }
+      else
+      {
+         qd_set24(p_ctx, FS_ETPU_QD_IRQ_SUPPRESSED_OFFSET,
+                  qd_get24(p_ctx, FS_ETPU_QD_IRQ_SUPPRESSED_OFFSET) + 1);
+      }
+   }
+   qd_set8(p_ctx, QD_IRQ_STATE_OFFSET, state);
+#else
+   if ((PC == qd_get24(p_ctx, FS_ETPU_QD_PCINTERRUPT1_OFFSET)) ||
+       (PC == qd_get24(p_ctx, FS_ETPU_QD_PCINTERRUPT2_OFFSET)))
+      etpu_model_channel_interrupt(p_ctx);
+#endif
+}
+
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+/* trigger table entry at a DATA RAM address */
+static uint32_t qd_trigger_entry(struct etpu_model_ctx_t *p_ctx, uint24_t address)
+{
+   p_ctx->steps++;
+   return(*(uint32_t*)etpu_model_sdm(address));
+}
+
+/* signed position of a trigger table entry */
+#define QD_TRIGGER_POSITION(e)  (((int32_t)((e) << 8)) >> 8)
+
+static void qd_trigger_edge(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t next, start, end;
+   uint32_t entry;
+   int32_t pc, tmp_pc;
+   uint8_t actions = 0;
+   uint8_t tmp_chan;
+
+   pc = PC;
+   tmp_pc = ((pc - DIRECTION) << 8) >> 8;
+   start = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_TRIG_NEW_START_OFFSET) & 0xffffff;
+   if (start != 0)
+   {
+      /* seek from the pc before this edge, so that an entry at pc fires */
+      qd_set24(p_ctx, FS_ETPU_QD_TRIG_START_OFFSET, start);
+      end = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_TRIG_NEW_END_OFFSET) & 0xffffff;
+      qd_set24(p_ctx, FS_ETPU_QD_TRIG_END_OFFSET, end);
+      qd_set24(p_ctx, FS_ETPU_QD_TRIG_NEW_START_OFFSET, 0);
+      next = start;
+      while ((next < end) && (QD_TRIGGER_POSITION(qd_trigger_entry(p_ctx, next)) <= tmp_pc))
+         next += 4;
+      qd_set24(p_ctx, FS_ETPU_QD_TRIG_NEXT_OFFSET, next);
+   }
+   next = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_TRIG_NEXT_OFFSET) & 0xffffff;
+   if (DIRECTION & QD_DIRECTION_BIT7)
+   {
+      start = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_TRIG_START_OFFSET) & 0xffffff;
+      while ((next > start) &&
+             (QD_TRIGGER_POSITION(entry = qd_trigger_entry(p_ctx, next - 4)) > pc))
+      {
+         next -= 4;
+         if (QD_TRIGGER_POSITION(entry) != tmp_pc)
+         {
+            actions |= (uint8_t)(entry >> 24);
+            qd_set32(p_ctx, FS_ETPU_QD_TRIG_LAST_OFFSET, entry);
+         }
+      }
+      if ((next > start) &&
+          (QD_TRIGGER_POSITION(entry = qd_trigger_entry(p_ctx, next - 4)) == pc))
+      {
+         actions |= (uint8_t)(entry >> 24);
+         qd_set32(p_ctx, FS_ETPU_QD_TRIG_LAST_OFFSET, entry);
+      }
+   }
+   else
+   {
+      end = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_TRIG_END_OFFSET) & 0xffffff;
+      while ((next < end) &&
+             (QD_TRIGGER_POSITION(entry = qd_trigger_entry(p_ctx, next)) <= pc))
+      {
+         actions |= (uint8_t)(entry >> 24);
+         qd_set32(p_ctx, FS_ETPU_QD_TRIG_LAST_OFFSET, entry);
+         next += 4;
+      }
+   }
+   qd_set24(p_ctx, FS_ETPU_QD_TRIG_NEXT_OFFSET, next);
+
+   if (actions & FS_ETPU_QD_TRIGGER_LINK)
+      etpu_model_link(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_TRIG_LINK_CHAN_OFFSET));
+   if (actions & (FS_ETPU_QD_TRIGGER_INTERRUPT + FS_ETPU_QD_TRIGGER_DMA))
+   {
+      tmp_chan = p_ctx->chan;
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+      if (actions & FS_ETPU_QD_TRIGGER_INTERRUPT)
+         etpu_model_channel_interrupt(p_ctx);
+      if (actions & FS_ETPU_QD_TRIGGER_DMA)
+         etpu_model_data_transfer_request(p_ctx);
+      qd_chan(p_ctx, tmp_chan);
+   }
+}
+
+static void qd_trigger_seek(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t next = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_TRIG_START_OFFSET) & 0xffffff;
+   uint24_t end = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_TRIG_END_OFFSET) & 0xffffff;
+
+   while ((next < end) && (QD_TRIGGER_POSITION(qd_trigger_entry(p_ctx, next)) <= PC))
+      next += 4;
+   qd_set24(p_ctx, FS_ETPU_QD_TRIG_NEXT_OFFSET, next);
+}
+#endif
+
+#ifdef FS_ETPU_QD_RING_START_OFFSET
+/* Append a record to the edge ring */
+static void qd_ring_record(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t wr = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_RING_WR_OFFSET) & 0xffffff;
+   uint24_t rec = wr + 8;
+   uint32_t *p;
+   uint8_t tmp_chan;
+
+   if (rec >= ((uint24_t)qd_get24(p_ctx, FS_ETPU_QD_RING_END_OFFSET) & 0xffffff))
+      rec = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_RING_START_OFFSET) & 0xffffff;
+   if (rec == ((uint24_t)qd_get24(p_ctx, FS_ETPU_QD_RING_RD_OFFSET) & 0xffffff))
+   {
+      qd_set24(p_ctx, FS_ETPU_QD_RING_OVERFLOW_OFFSET,
+               qd_get24(p_ctx, FS_ETPU_QD_RING_OVERFLOW_OFFSET) + 1);
+   }
+   else
+   {
+      p = (uint32_t*)etpu_model_sdm(wr);
+      p[0] = ((uint32_t)(uint8_t)DIRECTION << 24) | (p_ctx->erta & 0xffffff);
+      p[1] = ((uint32_t)(uint8_t)qd_get8(p_ctx, FS_ETPU_QD_RING_SEQ_OFFSET) << 24) |
+             ((uint32_t)PC & 0xffffff);
+      qd_set24(p_ctx, FS_ETPU_QD_RING_WR_OFFSET, rec);
+      tmp_chan = p_ctx->chan;
+      qd_chan(p_ctx, (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_PHASE_A_CHAN_OFFSET));
+      etpu_model_data_transfer_request(p_ctx);
+      qd_chan(p_ctx, tmp_chan);
+   }
+   qd_set8(p_ctx, FS_ETPU_QD_RING_SEQ_OFFSET, qd_get8(p_ctx, FS_ETPU_QD_RING_SEQ_OFFSET) + 1);
+}
+#endif
+
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+/* Replace the oldest period of the moving average */
+static void qd_period_avg(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t wr = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_AVG_WR_OFFSET) & 0xffffff;
+   uint32_t *p = (uint32_t*)etpu_model_sdm(wr);
+   uint32_t period = qd_get32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET);
+   uint32_t sum;
+   uint8_t shift;
+
+   sum = qd_get32(p_ctx, FS_ETPU_QD_PERIOD_SUM_OFFSET) + period - *p;
+   qd_set32(p_ctx, FS_ETPU_QD_PERIOD_SUM_OFFSET, sum);
+   *p = period;
+   wr += 4;
+   if (wr >= ((uint24_t)qd_get24(p_ctx, FS_ETPU_QD_AVG_END_OFFSET) & 0xffffff))
+      wr = (uint24_t)qd_get24(p_ctx, FS_ETPU_QD_AVG_START_OFFSET) & 0xffffff;
+   qd_set24(p_ctx, FS_ETPU_QD_AVG_WR_OFFSET, wr);
+   shift = (uint8_t)qd_get8(p_ctx, FS_ETPU_QD_AVG_SHIFT_OFFSET);
+   qd_set32(p_ctx, FS_ETPU_QD_PERIOD_AVG_OFFSET, sum >> shift);
+}
+#endif
+
+/* pc reset at pc_max */
+static void qd_pc_max(struct etpu_model_ctx_t *p_ctx)
+{
+   int32_t pc;
+
+   if (OPTIONS & FS_ETPU_QD_PC_MAX_ENABLED)
+   {
+      pc = PC;
+      if ((pc < 0 ? -pc : pc) >= (qd_get24(p_ctx, FS_ETPU_QD_PCMAX_OFFSET) & 0xffffff))
+      {
+         SET_PC(0);
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+         if (OPTIONS & FS_ETPU_QD_TRIGGER_TABLE_ENABLED)
+            qd_trigger_seek(p_ctx);
+#endif
+      }
+   }
+}
+
+static uint24_t qd_leading_edge_period(struct etpu_model_ctx_t *p_ctx)
+{
+   uint24_t tmp_period;
+
+   qd_pc_max(p_ctx);
+   tmp_period = qd_accumulate(p_ctx, QD_PERIOD_ACCUM_OFFSET, p_ctx->erta - LLE);
+   qd_set32(p_ctx, FS_ETPU_QD_PERIOD_OFFSET, qd_get32(p_ctx, QD_PERIOD_ACCUM_OFFSET));
+   qd_set32(p_ctx, QD_PERIOD_ACCUM_OFFSET, 0);
+   SET_LLE(p_ctx->erta);
+   SET_LLE_EXT(qd_time_ext(p_ctx, p_ctx->erta));
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+   if (OPTIONS & FS_ETPU_QD_PERIOD_AVG_ENABLED)
+      qd_period_avg(p_ctx);
+#endif
+#ifdef FS_ETPU_QD_RING_START_OFFSET
+   if (OPTIONS & FS_ETPU_QD_EDGE_RING_ENABLED)
+      qd_ring_record(p_ctx);
+#endif
+   return(tmp_period);
+}
+
+/* QD entry table (alternate, input pin) */
+static void qd_dispatch(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t cond = p_ctx->cond;
+   uint8_t flags = cond & (ETPU_MODEL_COND_F0 | ETPU_MODEL_COND_F1);
+
+   switch (p_ctx->hsr)
+   {
+   case 1: case 4: case 5:
+      qd_init(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_INIT);
+      return;
+   case 6: case 7:
+      qd_latch_and_clear_errors(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_LATCH_AND_CLEAR_ERRORS);
+      return;
+   case 2: case 3:
+      etpu_model_unexpected_thread(p_ctx);
+      return;
+   default:
+      break;
+   }
+   if (cond & ETPU_MODEL_COND_M2)
+   {
+      if (flags == (ETPU_MODEL_COND_F0 | ETPU_MODEL_COND_F1))
+      {
+         qd_fast_mode_edge(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_FAST_MODE_EDGE);
+      }
+      else if (flags == ETPU_MODEL_COND_F0)
+      {
+         qd_normal_mode_leading_edge(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_NORMAL_MODE_LEADING_EDGE);
+      }
+      else if (flags == ETPU_MODEL_COND_F1)
+      {
+         qd_slow_mode_leading_edge(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_SLOW_MODE_LEADING_EDGE);
+      }
+      else
+      {
+         qd_non_leading_edge(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_NON_LEADING_EDGE);
+      }
+   }
+   else if ((cond & ETPU_MODEL_COND_M1) && (flags != (ETPU_MODEL_COND_F0 | ETPU_MODEL_COND_F1)))
+   {
+      qd_period_overflow(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_PERIOD_OVERFLOW);
+   }
+   else if (cond & ETPU_MODEL_COND_M1)
+   {
+      qd_fast_mode_match(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_FAST_MODE_MATCH);
+   }
+   else
+   {
+      etpu_model_unexpected_thread(p_ctx);
+   }
+}
+
+/*******************************************************************************
+*                            QD HOME Threads
+*******************************************************************************/
+static void qd_home_init(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t fm = etpu_model_fm(p_ctx);
+
+   etpu_model_on_trans_a(p_ctx, (fm & FS_ETPU_QD_HOME_FM_DETECT_ANY) ?
+                         ETPU_MODEL_IPAC_ANY : ETPU_MODEL_IPAC_HIGH_LOW);
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_EM_NB_ST);
+   etpu_model_action_units(p_ctx, 0);
+   etpu_model_clear_all_latches(p_ctx);
+   if (fm == FS_ETPU_QD_HOME_FM_DETECT_LOW_HIGH)
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+}
+
+static void qd_home_transition(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_clear_trans_latch(p_ctx);
+   SEQ_INC();
+   SET_RC(0);
+   SET_PC(0);
+   SEQ_INC();
+}
+
+/* QD HOME entry table (standard, input pin) */
+static void qd_home_dispatch(struct etpu_model_ctx_t *p_ctx)
+{
+   if (p_ctx->hsr == FS_ETPU_QD_HOME_INIT)
+   {
+      qd_home_init(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_HOME_INIT);
+   }
+   else if (!p_ctx->hsr && !(p_ctx->cond & ETPU_MODEL_COND_LSR) &&
+            (p_ctx->cond & ETPU_MODEL_COND_M2))
+   {
+      qd_home_transition(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_HOME_TRANSITION);
+   }
+   else
+   {
+      etpu_model_unexpected_thread(p_ctx);
+   }
+}
+
+/*******************************************************************************
+*                            QD INDEX Threads
+*******************************************************************************/
+static void qd_index_init(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_ANY);
+   etpu_model_channel_mode(p_ctx, ETPU_MODEL_MODE_EM_NB_ST);
+   etpu_model_action_units(p_ctx, 0);
+   etpu_model_clear_all_latches(p_ctx);
+   if ((etpu_model_fm(p_ctx) & 1) == FS_ETPU_QD_INDEX_FM_PULSE_POSITIVE)
+   {
+      etpu_model_set_flag0(p_ctx, 0);
+      if (etpu_model_pin(p_ctx) == 1)
+         SET_LAST_DIRECTION(0);
+   }
+   else
+   {
+      etpu_model_set_flag0(p_ctx, 1);
+      if (etpu_model_pin(p_ctx) == 0)
+         SET_LAST_DIRECTION(0);
+   }
+   SET_RC(0);
+
+   qd_set32(p_ctx, FS_ETPU_QD_REV_PERIOD_OFFSET, 0);
+   qd_set8(p_ctx, FS_ETPU_QD_REV_PERIOD_EXT_OFFSET, 0);
+   qd_set32(p_ctx, QD_REV_ACCUM_OFFSET, 0);
+   qd_set8(p_ctx, QD_REV_ACCUM_EXT_OFFSET, 0);
+   qd_set8(p_ctx, QD_INDEX_SEEN_OFFSET, 0);
+   qd_set24(p_ctx, QD_LAST_INDEX_OFFSET, etpu_model_tcr1());
+   p_ctx->erta = (qd_get24(p_ctx, QD_LAST_INDEX_OFFSET) + 0x800000) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+}
+
+/* 40-bit revolution period accumulator "+= ticks" */
+static void qd_revolution_accum(struct etpu_model_ctx_t *p_ctx, uint24_t ticks)
+{
+   uint32_t accum = qd_get32(p_ctx, QD_REV_ACCUM_OFFSET);
+   uint32_t sum = accum + (ticks & 0xffffff);
+
+   qd_set32(p_ctx, QD_REV_ACCUM_OFFSET, sum);
+   if (sum < accum)
+      qd_set8(p_ctx, QD_REV_ACCUM_EXT_OFFSET, qd_get8(p_ctx, QD_REV_ACCUM_EXT_OFFSET) + 1);
+}
+
+static void qd_index_period_overflow(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_clear_match_a_latch(p_ctx);
+   qd_revolution_accum(p_ctx, 0x800000);
+   qd_set24(p_ctx, QD_LAST_INDEX_OFFSET, qd_get24(p_ctx, QD_LAST_INDEX_OFFSET) + 0x800000);
+   p_ctx->erta = (qd_get24(p_ctx, QD_LAST_INDEX_OFFSET) + 0x800000) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+}
+
+static void qd_revolution_period(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_clear_match_a_latch(p_ctx);
+   qd_revolution_accum(p_ctx, p_ctx->erta - qd_get24(p_ctx, QD_LAST_INDEX_OFFSET));
+   qd_set24(p_ctx, QD_LAST_INDEX_OFFSET, p_ctx->erta);
+   if (qd_get8(p_ctx, QD_INDEX_SEEN_OFFSET))
+   {
+      SEQ_INC();
+      qd_set32(p_ctx, FS_ETPU_QD_REV_PERIOD_OFFSET, qd_get32(p_ctx, QD_REV_ACCUM_OFFSET));
+      qd_set8(p_ctx, FS_ETPU_QD_REV_PERIOD_EXT_OFFSET, qd_get8(p_ctx, QD_REV_ACCUM_EXT_OFFSET));
+      SEQ_INC();
+   }
+   qd_set8(p_ctx, QD_INDEX_SEEN_OFFSET, 1);
+   qd_set32(p_ctx, QD_REV_ACCUM_OFFSET, 0);
+   qd_set8(p_ctx, QD_REV_ACCUM_EXT_OFFSET, 0);
+   p_ctx->erta = (p_ctx->erta + 0x800000) & 0xffffff;
+   etpu_model_write_erta_match_a(p_ctx);
+}
+
+static void qd_index_first_transition_common(struct etpu_model_ctx_t *p_ctx)
+{
+   uint32_t tmp_edges;
+
+   if (!(MODE & (QD_LEADING_EDGE_INDICATION | QD_MODE_TCR2)))
+   {
+      etpu_model_link(p_ctx, p_ctx->chan);
+      return;
+   }
+   SEQ_INC();
+   if (etpu_model_fm(p_ctx) & FS_ETPU_QD_INDEX_FM_PC_RESET)
+   {
+      if (MODE & QD_FAST_TO_NORMAL_SWITCH)
+      {
+         SET_PC(DIRECTION);
+      }
+      else if (MODE & QD_MODE_TCR2)
+      {
+         tmp_edges = ((etpu_model_tcr2() - qd_get24(p_ctx, QD_TCR2_BASE_OFFSET)) << 1) & 0xffffff;
+         if (DIRECTION & QD_DIRECTION_BIT7)
+            SET_PC(tmp_edges);
+         else
+            SET_PC(-tmp_edges);
+      }
+      else
+      {
+         SET_PC(0);
+      }
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+      if (OPTIONS & FS_ETPU_QD_TRIGGER_TABLE_ENABLED)
+         qd_trigger_seek(p_ctx);
+#endif
+   }
+   if (DIRECTION & QD_DIRECTION_BIT7)
+      SET_RC(RC - 1);
+   else
+      SET_RC(RC + 1);
+   SET_LAST_DIRECTION(DIRECTION);
+   if (MODE & QD_MODE_FAST)
+      SET_MODE(MODE & ~QD_LEADING_EDGE_INDICATION);
+   if (MODE & QD_MODE_SLOW)
+   {
+      etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_ANY);
+   }
+   else
+   {
+      if ((etpu_model_fm(p_ctx) & 1) == FS_ETPU_QD_INDEX_FM_PULSE_POSITIVE)
+         etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_LOW_HIGH);
+      else
+         etpu_model_on_trans_a(p_ctx, ETPU_MODEL_IPAC_HIGH_LOW);
+      etpu_model_clear_all_latches(p_ctx);
+   }
+   SEQ_INC();
+}
+
+/* Index_FirstTransition - only the first transition of a pulse times the
+   revolution (the LSR + transition row may service the second one) */
+static void qd_index_first_transition(struct etpu_model_ctx_t *p_ctx)
+{
+   etpu_model_clear_trans_latch(p_ctx);
+   if (etpu_model_pin(p_ctx) == ((etpu_model_fm(p_ctx) & 1) == FS_ETPU_QD_INDEX_FM_PULSE_POSITIVE))
+      qd_revolution_period(p_ctx);
+   qd_index_first_transition_common(p_ctx);
+   qd_thread_done(p_ctx, QD_THREAD_INDEX_FIRST_TRANSITION);
+}
+
+static void qd_index_second_transition_common(struct etpu_model_ctx_t *p_ctx)
+{
+   if (MODE & QD_LEADING_EDGE_INDICATION)
+   {
+      etpu_model_link(p_ctx, p_ctx->chan);
+      return;
+   }
+   if (LAST_DIRECTION - DIRECTION != 0)
+   {
+      SEQ_INC();
+      if (DIRECTION & QD_DIRECTION_BIT7)
+         SET_RC(RC - 1);
+      else
+         SET_RC(RC + 1);
+      SEQ_INC();
+   }
+}
+
+/* QD INDEX entry table (standard, input pin) */
+static void qd_index_dispatch(struct etpu_model_ctx_t *p_ctx)
+{
+   uint8_t cond = p_ctx->cond;
+   uint8_t first = ((cond & ETPU_MODEL_COND_PIN) ? 1 : 0) ^ ((cond & ETPU_MODEL_COND_F0) ? 1 : 0);
+
+   if (p_ctx->hsr == FS_ETPU_QD_INDEX_INIT)
+   {
+      qd_index_init(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_INDEX_INIT);
+   }
+   else if (p_ctx->hsr)
+   {
+      etpu_model_unexpected_thread(p_ctx);
+   }
+   else if (!(cond & ETPU_MODEL_COND_LSR))
+   {
+      if (!(cond & ETPU_MODEL_COND_M2))
+      {
+         qd_index_period_overflow(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_INDEX_PERIOD_OVERFLOW);
+      }
+      else if (first)
+      {
+         qd_index_first_transition(p_ctx);
+      }
+      else
+      {
+         etpu_model_clear_trans_latch(p_ctx);
+         if (LAST_DIRECTION != 0)
+            qd_index_second_transition_common(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_INDEX_SECOND_TRANSITION);
+      }
+   }
+   else if (cond & ETPU_MODEL_COND_M1)
+   {
+      qd_index_period_overflow(p_ctx);
+      qd_thread_done(p_ctx, QD_THREAD_INDEX_PERIOD_OVERFLOW);
+   }
+   else if (cond & ETPU_MODEL_COND_M2)
+   {
+      qd_index_first_transition(p_ctx);
+   }
+   else
+   {
+      etpu_model_clear_lsr(p_ctx);
+      if (first)
+      {
+         qd_index_first_transition_common(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_INDEX_FIRST_TRANSITION_LINK);
+      }
+      else
+      {
+         qd_index_second_transition_common(p_ctx);
+         qd_thread_done(p_ctx, QD_THREAD_INDEX_SECOND_TRANSITION_LINK);
+      }
+   }
+}
+
+/*******************************************************************************
+*                            Registration
+*******************************************************************************/
+void etpu_qd_model_register(void)
+{
+   etpu_model_register_function(FS_ETPU_QD_FUNCTION_NUMBER, qd_dispatch);
+   etpu_model_register_function(FS_ETPU_QD_HOME_FUNCTION_NUMBER, qd_home_dispatch);
+   etpu_model_register_function(FS_ETPU_QD_INDEX_FUNCTION_NUMBER, qd_index_dispatch);
+}
+
+/*******************************************************************************
+*                            Report
+*******************************************************************************/
+/* Thread counts and worst case lengths of the threads executed */
+void etpu_qd_model_report(int fd)
+{
+   char line[128];
+   int len;
+   uint8_t i;
+
+   for (i = 0; i < QD_THREAD_COUNT; i++)
+   {
+      if (qd_model_threads[i].count == 0)
+         continue;
+      len = snprintf(line, sizeof(line), "  %-28s %8u threads, worst case %3u steps\n",
+                     qd_model_threads[i].name, qd_model_threads[i].count,
+                     qd_model_threads[i].max_steps);
+      if (write(fd, line, len) < 0)
+         return;
+   }
+}
@@ -0,0 +1,17 @@
+/**************************************************************************
+ * FILE NAME: ScriptLib.h (host model)
+ *
+ * DESCRIPTION:
+ * Host model stand-in for the simulator script library. Time is in
+ * microseconds of simulated time.
+ **************************************************************************/
+#ifndef _SCRIPTLIB_H_
+#define _SCRIPTLIB_H_
+
+void wait_time(unsigned int time_us);
+void write_chan_input_pin(unsigned int channel, unsigned int value);
+void write_chan_input_pins(unsigned int count, const unsigned int *p_channels,
+                           const unsigned int *p_values);
+void write_tcrclk_pin(unsigned int value);
+
+#endif
@@ -0,0 +1,121 @@
+/****************************************************************
+* etpu_eqd_auto.h (host model, no build options)
+*
+* Hand-written equivalent of the ETEC generated etpu_eqd_auto.h of a
+* microcode built with none of the build options of etec_eqd.c defined:
+* the core frame of 124 bytes, without the exports of the optional
+* parameters. It is include/etpu_eqd_auto.h without the option offsets
+* and must be kept in line with it. Used by "make core".
+*****************************************************************/
+#ifndef _ETPU_EQD_AUTO_H_
+#define _ETPU_EQD_AUTO_H_
+
+/****************************************************************
+* Function Configuration Information.
+****************************************************************/
+#define FS_ETPU_QD_FUNCTION_NUMBER       1
+#define FS_ETPU_QD_TABLE_SELECT          1
+#define FS_ETPU_QD_NUM_PARMS             124
+
+#define FS_ETPU_QD_HOME_FUNCTION_NUMBER  2
+#define FS_ETPU_QD_HOME_TABLE_SELECT     0
+#define FS_ETPU_QD_HOME_NUM_PARMS        124
+
+#define FS_ETPU_QD_INDEX_FUNCTION_NUMBER 3
+#define FS_ETPU_QD_INDEX_TABLE_SELECT    0
+#define FS_ETPU_QD_INDEX_NUM_PARMS       124
+
+/****************************************************************
+* Host Service Request Definitions.
+****************************************************************/
+#define FS_ETPU_QD_INIT                    1
+#define FS_ETPU_QD_HOME_INIT               1
+#define FS_ETPU_QD_INDEX_INIT              1
+#define FS_ETPU_QD_LATCH_AND_CLEAR_ERRORS  7
+
+/****************************************************************
+* Parameter Definitions.
+****************************************************************/
+#define FS_ETPU_QD_PC_OFFSET                  1
+#define FS_ETPU_QD_RC_OFFSET                  5
+#define FS_ETPU_QD_PERIOD_OFFSET              8
+#define FS_ETPU_QD_PCMAX_OFFSET               13
+#define FS_ETPU_QD_PCINTERRUPT1_OFFSET        17
+#define FS_ETPU_QD_PCINTERRUPT2_OFFSET        21
+#define FS_ETPU_QD_SLOW_NORMAL_THR_OFFSET     25
+#define FS_ETPU_QD_NORMAL_SLOW_THR_OFFSET     29
+#define FS_ETPU_QD_NORMAL_FAST_THR_OFFSET     33
+#define FS_ETPU_QD_FAST_NORMAL_THR_OFFSET     37
+#define FS_ETPU_QD_LAST_LEADING_EDGE_OFFSET   41
+#define FS_ETPU_QD_LAST_EDGE_OFFSET           45
+#define FS_ETPU_QD_PC_SC_OFFSET               49
+#define FS_ETPU_QD_DIRECTION_OFFSET           3
+#define FS_ETPU_QD_LAST_DIRECTION_OFFSET      7
+#define FS_ETPU_QD_PINS_OFFSET                15
+#define FS_ETPU_QD_MODE_CURRENT_OFFSET        19
+#define FS_ETPU_QD_OPTIONS_OFFSET             23
+#define FS_ETPU_QD_RATIO1_OFFSET              53
+#define FS_ETPU_QD_RATIO2_OFFSET              57
+#define FS_ETPU_QD_PHASE_A_CHAN_OFFSET        27
+#define FS_ETPU_QD_PHASE_B_CHAN_OFFSET        31
+#define FS_ETPU_QD_ERROR_FLAGS_OFFSET         35
+#define FS_ETPU_QD_LATCHED_ERROR_FLAGS_OFFSET 39
+#define FS_ETPU_QD_SEQ_OFFSET                 65
+#define FS_ETPU_QD_REV_PERIOD_OFFSET          84
+#define FS_ETPU_QD_REV_PERIOD_EXT_OFFSET      67
+#define FS_ETPU_QD_FAST_ULTRA_THR_OFFSET      89
+#define FS_ETPU_QD_ULTRA_FAST_THR_OFFSET      93
+#define FS_ETPU_QD_FAST_TCR2_THR_OFFSET       97
+#define FS_ETPU_QD_TCR2_FAST_THR_OFFSET       101
+#define FS_ETPU_QD_TCR2_INTERVAL_OFFSET       105
+#define FS_ETPU_QD_POSITION_LO_OFFSET         113
+#define FS_ETPU_QD_POSITION_HI_OFFSET         117
+#define FS_ETPU_QD_TCR_EXT_OFFSET             120
+#define FS_ETPU_QD_LAST_LEADING_EDGE_EXT_OFFSET 47
+#define FS_ETPU_QD_LAST_EDGE_EXT_OFFSET       51
+
+/****************************************************************
+* Value Definitions.
+****************************************************************/
+#define FS_ETPU_QD_FM_CHANNEL_PRIMARY         0
+#define FS_ETPU_QD_FM_CHANNEL_SECONDARY       1
+
+#define FS_ETPU_QD_HOME_FM_DETECT_LOW_HIGH    0
+#define FS_ETPU_QD_HOME_FM_DETECT_HIGH_LOW    1
+#define FS_ETPU_QD_HOME_FM_DETECT_ANY         2
+
+#define FS_ETPU_QD_INDEX_FM_PULSE_POSITIVE    0
+#define FS_ETPU_QD_INDEX_FM_PULSE_NEGATIVE    1
+#define FS_ETPU_QD_INDEX_FM_PC_NO_RESET       0
+#define FS_ETPU_QD_INDEX_FM_PC_RESET          2
+
+/* option bits */
+#define FS_ETPU_QD_PC_MAX_ENABLED             0x01
+#define FS_ETPU_QD_PC_INTERRUPT_ENABLED       0x02
+#define FS_ETPU_QD_WINDOWING_DISABLED         0x04
+#define FS_ETPU_QD_EDGE_RING_ENABLED          0x08
+#define FS_ETPU_QD_EDGE_HISTORY_ENABLED       0x10
+#define FS_ETPU_QD_PERIOD_AVG_ENABLED         0x20
+#define FS_ETPU_QD_TRIGGER_TABLE_ENABLED      0x40
+
+/* trigger table entry actions */
+#define FS_ETPU_QD_TRIGGER_INTERRUPT          0x01
+#define FS_ETPU_QD_TRIGGER_DMA                0x02
+#define FS_ETPU_QD_TRIGGER_LINK               0x04
+
+/* period after standstill */
+#define FS_ETPU_QD_PERIOD_STANDSTILL         0xFF000000
+
+/* pins bits */
+#define FS_ETPU_QD_PINS_PIN_A                 0x01
+#define FS_ETPU_QD_PINS_PIN_B                 0x02
+#define FS_ETPU_QD_PINS_CONFIGURATION         0x04
+
+/* error bits */
+#define FS_ETPU_QD_ERROR_WINDOWING            0x01
+#define FS_ETPU_QD_ERROR_REVERSAL             0x02
+#define FS_ETPU_QD_ERROR_ILLEGAL              0x04
+#define FS_ETPU_QD_ERROR_SPURIOUS             0x08
+#define FS_ETPU_QD_ERROR_COUNT_MAX            0xFFFF
+
+#endif
@@ -0,0 +1,179 @@
+/****************************************************************
+* etpu_eqd_auto.h (host model)
+*
+* Hand-written equivalent of the ETEC generated etpu_eqd_auto.h for the
+* Linux host model build. It must be kept in line with the QD channel
+* frame and the #pragma write h exports in etec_eqd.c.
+*
+* The frame follows the ETEC layout: each 24-bit parameter occupies the
+* low 3 bytes of a 32-bit word and an 8-bit parameter may be packed into
+* the top byte. The host model stores DATA RAM words in host (little-
+* endian) order, so the top byte of word N is at byte offset 4*N+3.
+*
+* It mirrors a build with all the build options of etec_eqd.c defined,
+* so the exports of the optional parameters are included:
+*   QD_EDGE_RING          - FS_ETPU_QD_RING_*_OFFSET
+*   QD_EDGE_HISTORY       - FS_ETPU_QD_HIST_*_OFFSET
+*   QD_PERIOD_AVG         - FS_ETPU_QD_PERIOD_AVG/SUM_OFFSET, ..._AVG_*_OFFSET
+*   QD_TRIGGER_TABLE      - FS_ETPU_QD_TRIG_*_OFFSET
+*   QD_PC_IRQ_COALESCING  - FS_ETPU_QD_IRQ_*_OFFSET
+*   QD_STANDSTILL         - FS_ETPU_QD_STANDSTILL*_OFFSET
+*   QD_FAST_REVERSAL      - FS_ETPU_QD_FAST_REVERSAL_OFFSET
+*   QD_ERROR_COUNTERS     - FS_ETPU_QD_*_COUNT_OFFSET
+*   QD_PROFILING          - FS_ETPU_QD_PROF_*_OFFSET
+* The core parameters take offsets 0-123, which is the frame of a build
+* without options (FS_ETPU_QD_NUM_PARMS 124, include/core/etpu_eqd_auto.h);
+* the 8-bit option parameters use free top bytes of the core words and the
+* other option parameters follow the core in the order of the list above.
+*****************************************************************/
+#ifndef _ETPU_EQD_AUTO_H_
+#define _ETPU_EQD_AUTO_H_
+
+/****************************************************************
+* Function Configuration Information.
+****************************************************************/
+#define FS_ETPU_QD_FUNCTION_NUMBER       1
+#define FS_ETPU_QD_TABLE_SELECT          1
+#define FS_ETPU_QD_NUM_PARMS             252
+
+#define FS_ETPU_QD_HOME_FUNCTION_NUMBER  2
+#define FS_ETPU_QD_HOME_TABLE_SELECT     0
+#define FS_ETPU_QD_HOME_NUM_PARMS        252
+
+#define FS_ETPU_QD_INDEX_FUNCTION_NUMBER 3
+#define FS_ETPU_QD_INDEX_TABLE_SELECT    0
+#define FS_ETPU_QD_INDEX_NUM_PARMS       252
+
+/****************************************************************
+* Host Service Request Definitions.
+****************************************************************/
+#define FS_ETPU_QD_INIT                    1
+#define FS_ETPU_QD_HOME_INIT               1
+#define FS_ETPU_QD_INDEX_INIT              1
+#define FS_ETPU_QD_LATCH_AND_CLEAR_ERRORS  7
+
+/****************************************************************
+* Parameter Definitions.
+****************************************************************/
+#define FS_ETPU_QD_PC_OFFSET                  1
+#define FS_ETPU_QD_RC_OFFSET                  5
+#define FS_ETPU_QD_PERIOD_OFFSET              8
+#define FS_ETPU_QD_PCMAX_OFFSET               13
+#define FS_ETPU_QD_PCINTERRUPT1_OFFSET        17
+#define FS_ETPU_QD_PCINTERRUPT2_OFFSET        21
+#define FS_ETPU_QD_SLOW_NORMAL_THR_OFFSET     25
+#define FS_ETPU_QD_NORMAL_SLOW_THR_OFFSET     29
+#define FS_ETPU_QD_NORMAL_FAST_THR_OFFSET     33
+#define FS_ETPU_QD_FAST_NORMAL_THR_OFFSET     37
+#define FS_ETPU_QD_LAST_LEADING_EDGE_OFFSET   41
+#define FS_ETPU_QD_LAST_EDGE_OFFSET           45
+#define FS_ETPU_QD_PC_SC_OFFSET               49
+#define FS_ETPU_QD_DIRECTION_OFFSET           3
+#define FS_ETPU_QD_LAST_DIRECTION_OFFSET      7
+#define FS_ETPU_QD_PINS_OFFSET                15
+#define FS_ETPU_QD_MODE_CURRENT_OFFSET        19
+#define FS_ETPU_QD_OPTIONS_OFFSET             23
+#define FS_ETPU_QD_RATIO1_OFFSET              53
+#define FS_ETPU_QD_RATIO2_OFFSET              57
+#define FS_ETPU_QD_PHASE_A_CHAN_OFFSET        27
+#define FS_ETPU_QD_PHASE_B_CHAN_OFFSET        31
+#define FS_ETPU_QD_ERROR_FLAGS_OFFSET         35
+#define FS_ETPU_QD_LATCHED_ERROR_FLAGS_OFFSET 39
+#define FS_ETPU_QD_SEQ_OFFSET                 65
+#define FS_ETPU_QD_RING_START_OFFSET          125
+#define FS_ETPU_QD_RING_END_OFFSET            129
+#define FS_ETPU_QD_RING_WR_OFFSET             133
+#define FS_ETPU_QD_RING_RD_OFFSET             137
+#define FS_ETPU_QD_RING_OVERFLOW_OFFSET       141
+#define FS_ETPU_QD_RING_SEQ_OFFSET            107
+#define FS_ETPU_QD_HIST_START_OFFSET          145
+#define FS_ETPU_QD_HIST_END_OFFSET            149
+#define FS_ETPU_QD_HIST_WR_OFFSET             153
+#define FS_ETPU_QD_PERIOD_AVG_OFFSET          156
+#define FS_ETPU_QD_PERIOD_SUM_OFFSET          160
+#define FS_ETPU_QD_AVG_START_OFFSET           165
+#define FS_ETPU_QD_AVG_END_OFFSET             169
+#define FS_ETPU_QD_AVG_WR_OFFSET              173
+#define FS_ETPU_QD_AVG_SHIFT_OFFSET           111
+#define FS_ETPU_QD_REV_PERIOD_OFFSET          84
+#define FS_ETPU_QD_REV_PERIOD_EXT_OFFSET      67
+#define FS_ETPU_QD_TRIG_START_OFFSET          177
+#define FS_ETPU_QD_TRIG_END_OFFSET            181
+#define FS_ETPU_QD_TRIG_NEXT_OFFSET           185
+#define FS_ETPU_QD_TRIG_NEW_START_OFFSET      189
+#define FS_ETPU_QD_TRIG_NEW_END_OFFSET        193
+#define FS_ETPU_QD_TRIG_LAST_OFFSET           196
+#define FS_ETPU_QD_TRIG_LINK_CHAN_OFFSET      115
+#define FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET    201
+#define FS_ETPU_QD_IRQ_SUPPRESSED_OFFSET      209
+#define FS_ETPU_QD_IRQ_HYSTERESIS_OFFSET      95
+#define FS_ETPU_QD_IRQ_REV_DIV_OFFSET         99
+#define FS_ETPU_QD_STANDSTILL_TIMEOUT_OFFSET  213
+#define FS_ETPU_QD_STANDSTILL_OFFSET          79
+#define FS_ETPU_QD_STANDSTILL_IRQ_OFFSET      91
+#define FS_ETPU_QD_FAST_REVERSAL_OFFSET       75
+#define FS_ETPU_QD_FAST_ULTRA_THR_OFFSET      89
+#define FS_ETPU_QD_ULTRA_FAST_THR_OFFSET      93
+#define FS_ETPU_QD_FAST_TCR2_THR_OFFSET       97
+#define FS_ETPU_QD_TCR2_FAST_THR_OFFSET       101
+#define FS_ETPU_QD_TCR2_INTERVAL_OFFSET       105
+#define FS_ETPU_QD_POSITION_LO_OFFSET         113
+#define FS_ETPU_QD_POSITION_HI_OFFSET         117
+#define FS_ETPU_QD_TCR_EXT_OFFSET             120
+#define FS_ETPU_QD_LAST_LEADING_EDGE_EXT_OFFSET 47
+#define FS_ETPU_QD_LAST_EDGE_EXT_OFFSET       51
+#define FS_ETPU_QD_ILLEGAL_COUNT_OFFSET       217
+#define FS_ETPU_QD_WINDOW_COUNT_OFFSET        221
+#define FS_ETPU_QD_SPURIOUS_COUNT_OFFSET      225
+#define FS_ETPU_QD_PROF_INIT_OFFSET           229
+#define FS_ETPU_QD_PROF_SLOW_NORMAL_OFFSET    233
+#define FS_ETPU_QD_PROF_FAST_OFFSET           237
+#define FS_ETPU_QD_PROF_OVERFLOW_OFFSET       241
+#define FS_ETPU_QD_PROF_INDEX_HOME_OFFSET     245
+#define FS_ETPU_QD_PROF_MODE_SWITCH_OFFSET    249
+
+/****************************************************************
+* Value Definitions.
+****************************************************************/
+#define FS_ETPU_QD_FM_CHANNEL_PRIMARY         0
+#define FS_ETPU_QD_FM_CHANNEL_SECONDARY       1
+
+#define FS_ETPU_QD_HOME_FM_DETECT_LOW_HIGH    0
+#define FS_ETPU_QD_HOME_FM_DETECT_HIGH_LOW    1
+#define FS_ETPU_QD_HOME_FM_DETECT_ANY         2
+
+#define FS_ETPU_QD_INDEX_FM_PULSE_POSITIVE    0
+#define FS_ETPU_QD_INDEX_FM_PULSE_NEGATIVE    1
+#define FS_ETPU_QD_INDEX_FM_PC_NO_RESET       0
+#define FS_ETPU_QD_INDEX_FM_PC_RESET          2
+
+/* option bits */
+#define FS_ETPU_QD_PC_MAX_ENABLED             0x01
+#define FS_ETPU_QD_PC_INTERRUPT_ENABLED       0x02
+#define FS_ETPU_QD_WINDOWING_DISABLED         0x04
+#define FS_ETPU_QD_EDGE_RING_ENABLED          0x08
+#define FS_ETPU_QD_EDGE_HISTORY_ENABLED       0x10
+#define FS_ETPU_QD_PERIOD_AVG_ENABLED         0x20
+#define FS_ETPU_QD_TRIGGER_TABLE_ENABLED      0x40
+
+/* trigger table entry actions */
+#define FS_ETPU_QD_TRIGGER_INTERRUPT          0x01
+#define FS_ETPU_QD_TRIGGER_DMA                0x02
+#define FS_ETPU_QD_TRIGGER_LINK               0x04
+
+/* period after standstill */
+#define FS_ETPU_QD_PERIOD_STANDSTILL         0xFF000000
+
+/* pins bits */
+#define FS_ETPU_QD_PINS_PIN_A                 0x01
+#define FS_ETPU_QD_PINS_PIN_B                 0x02
+#define FS_ETPU_QD_PINS_CONFIGURATION         0x04
+
+/* error bits */
+#define FS_ETPU_QD_ERROR_WINDOWING            0x01
+#define FS_ETPU_QD_ERROR_REVERSAL             0x02
+#define FS_ETPU_QD_ERROR_ILLEGAL              0x04
+#define FS_ETPU_QD_ERROR_SPURIOUS             0x08
+#define FS_ETPU_QD_ERROR_COUNT_MAX            0xFFFF
+
+#endif
@@ -0,0 +1,17 @@
+/**************************************************************************
+ * FILE NAME: etpu_set_defines.h (host model)
+ *
+ * DESCRIPTION:
+ * Stand-in for the ETEC generated global defines. The host model does not
+ * execute microcode, so the entry table, MISC and engine memory values
+ * are placeholders.
+ **************************************************************************/
+#ifndef _ETPU_SET_DEFINES_H_
+#define _ETPU_SET_DEFINES_H_
+
+#define _ENTRY_TABLE_BASE_ADDR_   0x0
+#define _MISC_VALUE_              0x0
+#define _ENGINE_DATA_SIZE_        0x0
+#define _SCM_OFF_OPCODE_          0x0
+
+#endif
@@ -0,0 +1,2 @@
+/* Stand-in for the ETEC generated global initialization data. */
+__GLOBAL_MEM_INIT32( 0x0000 , 0x00000000 )
@@ -0,0 +1,3 @@
+/* Stand-in for the ETEC generated code image - the host model does not
+   execute microcode. */
+0x00000000
@@ -0,0 +1,2 @@
+/* Stand-in for the ETEC generated autostruct header - not used by the
+   host model build. */
@@ -0,0 +1,14 @@
+/**************************************************************************
+ * FILE NAME: isrLib.h (host model)
+ *
+ * DESCRIPTION:
+ * Host model stand-in for the simulator interrupt library. The QD test
+ * application does not use eTPU interrupts.
+ **************************************************************************/
+#ifndef _ISRLIB_H_
+#define _ISRLIB_H_
+
+void isrLibInit(void);
+void isrEnableAllInterrupts(void);
+
+#endif
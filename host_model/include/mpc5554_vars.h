@@ -0,0 +1,26 @@
+/**************************************************************************
+ * FILE NAME: mpc5554_vars.h (host model)
+ *
+ * DESCRIPTION:
+ * MPC5554 eTPU addresses for the Linux host model build. Same addresses
+ * as include/mpc5554_vars.h; the RAM-backed eTPU model maps its register,
+ * code and DATA RAM images there. The addresses are const here to match
+ * the declarations in etpu_util_ext.h.
+ **************************************************************************/
+#define FS_ETPU_ARCHITECTURE ETPU1
+
+/* eTPU_AB */
+volatile struct eTPU_struct * const eTPU_AB = (struct eTPU_struct *)0xC3FC0000;
+
+const uint32_t fs_etpu_code_start =     0xC3FD0000;
+const uint32_t fs_etpu_data_ram_start = 0xC3FC8000;
+const uint32_t fs_etpu_data_ram_end =   0xC3FC8BFC;
+const uint32_t fs_etpu_data_ram_ext =   0xC3FCC000;
+
+/* eTPU_C - not present */
+volatile struct eTPU_struct * const eTPU_C  = (struct eTPU_struct *)0;
+
+const uint32_t fs_etpu_c_code_start =     0x0;
+const uint32_t fs_etpu_c_data_ram_start = 0x0;
+const uint32_t fs_etpu_c_data_ram_end =   0x0;
+const uint32_t fs_etpu_c_data_ram_ext =   0x0;
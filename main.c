@@ -4,9 +4,11 @@
  * is performed, then the main app is kicked off.
  */
 
-/* This code initializes the eTPU and a QD instance (simple, no home or index inputs).  The code
-   then exercises the function by toggling the input pins.  The input ramps through a very large
-   frequency / RPM range in order to show 32-bit period collection. */
+/* This code initializes the eTPU and a QD instance with phase A/B and index inputs (no home
+   input).  The code then exercises the function by toggling the input pins, manually and with
+   the encoder stimulus generator (qd_stimulus.c), which also drives one index pulse per
+   revolution.  The input ramps through a very large frequency / RPM range in order to show
+   32-bit period collection, through all modes and back, and exercises the optional features. */
 
 /* for sim environment */
 #include "isrLib.h"
@@ -16,10 +18,12 @@
 #include "etpu_util_ext.h"
 #include "etpu_gct.h"
 #include "etpu_eqd.h"
+#include "qd_stimulus.h"
 
 
 #define QD_PHASE_A_CHAN 1
 #define QD_PHASE_B_CHAN 2
+#define QD_INDEX_CHAN 3
 
 int32_t g_complete_flag = 0;
 
@@ -31,6 +35,241 @@ void fail_loop()
 }
 
 
+/* readout benchmark - per-call getters vs. fs_etpu_eqd_h_read_many.
+   The simulation runs a single QD, so all axes refer to the same channels. */
+#define QD_BENCH_AXES 12
+
+struct eqd_instance_t g_bench_instances[QD_BENCH_AXES];
+struct eqd_readout_t g_bench_readout;
+uint32_t g_bench_per_call_ticks;   /* TCR1 ticks, per-call getters */
+uint32_t g_bench_read_many_ticks;  /* TCR1 ticks, fs_etpu_eqd_h_read_many */
+
+void qd_readout_benchmark(uint8_t channel_primary)
+{
+    uint32_t start;
+    uint8_t i;
+
+    for (i = 0; i < QD_BENCH_AXES; i++)
+        if (fs_etpu_eqd_get_instance(EM_AB, channel_primary, &g_bench_instances[i]) != 0)
+            fail_loop();
+
+    start = eTPU_AB->TB1R_A.R;
+    for (i = 0; i < QD_BENCH_AXES; i++)
+    {
+        g_bench_readout.pc[i] = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+        g_bench_readout.pc_sc[i] = fs_etpu_eqd_get_pc_sc(EM_AB, channel_primary);
+        g_bench_readout.rc[i] = fs_etpu_eqd_get_rc(EM_AB, channel_primary);
+        g_bench_readout.period[i] = fs_etpu_eqd_get_period(EM_AB, channel_primary);
+        g_bench_readout.last_edge[i] = fs_etpu_eqd_get_tcr(EM_AB, channel_primary);
+        g_bench_readout.direction[i] = fs_etpu_eqd_get_direction(EM_AB, channel_primary);
+        g_bench_readout.mode[i] = fs_etpu_eqd_get_mode(EM_AB, channel_primary);
+        g_bench_readout.error_flags[i] = fs_etpu_eqd_get_current_error_flags(EM_AB, channel_primary);
+    }
+    g_bench_per_call_ticks = (eTPU_AB->TB1R_A.R - start) & 0xffffff;
+
+    start = eTPU_AB->TB1R_A.R;
+    if (fs_etpu_eqd_h_read_many(g_bench_instances, QD_BENCH_AXES, &g_bench_readout) != 0)
+        fail_loop();
+    g_bench_read_many_ticks = (eTPU_AB->TB1R_A.R - start) & 0xffffff;
+
+    for (i = 0; i < QD_BENCH_AXES; i++)
+        if (g_bench_readout.pc[i] != fs_etpu_eqd_get_pc(EM_AB, channel_primary))
+            fail_loop();
+}
+
+
+/* move the encoder by 'counts' A/B edges, one per ms (SLOW mode); phase A
+   is high in the count states 1 and 2, phase B in the states 2 and 3 */
+void qd_move(int32_t *p_position, int32_t counts)
+{
+    int32_t step = (counts < 0) ? -1 : 1;
+    uint8_t state;
+
+    while (counts != 0)
+    {
+        *p_position += step;
+        counts -= step;
+        state = (uint8_t)(*p_position & 3);
+        wait_time(1000);
+        if ((state == 1) || (state == 3) ? (step > 0) : (step < 0))
+            write_chan_input_pin(QD_PHASE_A_CHAN, (state == 1) || (state == 2));
+        else
+            write_chan_input_pin(QD_PHASE_B_CHAN, state >= 2);
+    }
+}
+
+
+/* QD instance with the edge history of the last QD_HIST_ENTRIES edges */
+#define QD_HIST_ENTRIES 8
+
+/* edge ring records (POLLED mode) */
+#define QD_RING_RECORDS 8
+
+struct eqd_instance_t g_qd_instance;
+#ifdef FS_ETPU_QD_HIST_START_OFFSET
+uint32_t g_qd_hist[QD_HIST_ENTRIES];
+#endif
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+struct eqd_trigger_t g_qd_triggers[3];
+#endif
+
+
+/* encoder stimulus - QD phase A/B and index inputs, 60 counts per revolution */
+struct qd_stim_config_t g_stim_config =
+{
+    QD_PHASE_A_CHAN, QD_PHASE_B_CHAN, QD_INDEX_CHAN, QD_STIM_NO_CHANNEL,
+    60, 0, 0, 1, 0x2545F491, QD_TCR2_TCRCLK
+};
+struct qd_stim_t g_stim;
+
+/* A/B only - the start-up is checked against exact edge times */
+const struct qd_stim_config_t g_start_config =
+{
+    QD_PHASE_A_CHAN, QD_PHASE_B_CHAN, QD_STIM_NO_CHANNEL, QD_STIM_NO_CHANNEL,
+    60, 0, 0, 1, 0x2545F491, QD_TCR2_TCRCLK
+};
+
+/* from standstill up to FAST mode (30us edges), one count per segment so
+   that every edge interval is exact; starts and ends with phase A rising */
+const struct qd_stim_segment_t g_start_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_STEP,     1,        0,      500000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      500000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      500000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      500000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      500000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      400000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      300000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      200000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      100000,     0,        0 },
+    { QD_STIM_STEP,     1,        0,      50000,      0,        0 },
+    { QD_STIM_STEP,     1,        0,      30000,      0,        0 },
+    { QD_STIM_STEP,     1,        0,      20000,      0,        0 },
+    { QD_STIM_STEP,     1,        0,      10000,      0,        0 },
+    { QD_STIM_STEP,     1,        0,      5000,       0,        0 },
+    { QD_STIM_STEP,     1,        0,      3000,       0,        0 },
+    { QD_STIM_STEP,     1,        0,      1500,       0,        0 },
+    { QD_STIM_STEP,     1,        0,      800,        0,        0 },
+    { QD_STIM_STEP,     1,        0,      400,        0,        0 },
+    { QD_STIM_STEP,     1,        0,      200,        0,        0 },
+    { QD_STIM_STEP,     1,        0,      100,        0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      50,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      45,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      42,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      40,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      39,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      38,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      37,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      36,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      35,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      34,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      33,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      32,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      31,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      30,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      30,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      30,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      30,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      30,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      30,         0,        0 },
+    { QD_STIM_STEP,     1,        0,      30,         0,        0 },
+};
+
+/* from FAST mode (30us edges) down to standstill, ending with phase A and B
+   low (position a multiple of 4) */
+const struct qd_stim_segment_t g_decel_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_CONSTANT, 33333,    0,      100,        0,        0 },
+    { QD_STIM_SCURVE,   33333,    15000,  3000,       0,        0 },
+    { QD_STIM_RAMP,     15000,    100,    23000,      0,        0 },
+    { QD_STIM_CONSTANT, 0,        0,      500000,     0,        0 },
+};
+
+/* soak - through all modes and back, reversal, edge jitter and dropped edges.
+   Repeated QD_SOAK_LOOPS times (about 3200 edges per pass). */
+#ifndef QD_SOAK_LOOPS
+#define QD_SOAK_LOOPS 1
+#endif
+
+const struct qd_stim_segment_t g_soak_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_RAMP,     0,        40000,  50000,      0,        0 },
+    { QD_STIM_CONSTANT, 40000,    0,      10000,      0,        0 },
+    { QD_STIM_SCURVE,   40000,    5000,   50000,      0,        0 },
+    { QD_STIM_REVERSAL, 5000,     0,      100000,     0,        0 },
+    { QD_STIM_CONSTANT, -5000,    0,      50000,      20,       0 },
+    { QD_STIM_SCURVE,   -5000,    0,      50000,      0,        0 },
+    { QD_STIM_CONSTANT, 600,      0,      100000,     0,        7 },
+    { QD_STIM_CONSTANT, 0,        0,      10000,      0,        0 },
+};
+
+/* FAST mode reversal - up to FAST mode, then turned back at full speed
+   and decelerated to standstill */
+const struct qd_stim_segment_t g_fast_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_RAMP,     0,        33333,  20000,      0,        0 },
+    { QD_STIM_CONSTANT, 33333,    0,      200,        0,        0 },
+};
+const struct qd_stim_segment_t g_reversal_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_CONSTANT, -33333,   0,      300,        0,        0 },
+    { QD_STIM_RAMP,     -33333,   0,      20000,      0,        0 },
+    { QD_STIM_CONSTANT, 0,        0,      300000,     0,        0 },
+};
+
+/* ULTRA FAST mode - up to ULTRA FAST mode, then stopped at once or
+   decelerated to standstill */
+const struct qd_stim_segment_t g_ultra_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_RAMP,     0,        80000,  30000,      0,        0 },
+    { QD_STIM_CONSTANT, 80000,    0,      1000,       0,        0 },
+};
+const struct qd_stim_segment_t g_ultra_halt_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_CONSTANT, 0,        0,      10000,      0,        0 },
+};
+/* TCR2 counting mode - 20 revolutions at 80000rpm */
+const struct qd_stim_segment_t g_tcr2_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_CONSTANT, 80000,    0,      15000,      0,        0 },
+};
+const struct qd_stim_segment_t g_ultra_stop_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_RAMP,     80000,    0,      30000,      0,        0 },
+    { QD_STIM_CONSTANT, 0,        0,      300000,     0,        0 },
+};
+
+/* revolution period - 200 rpm, 300ms (15000000 TCR1 ticks) per revolution,
+   at least two index pulses */
+const struct qd_stim_segment_t g_rev_profile[] =
+{
+    /* type             rpm_start rpm_end duration_us jitter_us drop_every */
+    { QD_STIM_CONSTANT, 200,      0,      700000,     0,        0 },
+};
+
+
 /* main application entry point */
 /* w/ GNU, if we name this main, it requires linking with the libgcc.a
    run-time support.  This may be useful with C++ because this extra
@@ -44,13 +283,54 @@ int user_main()
     int8_t direction;
     int24_t pc;
     int24_t pc_sc;
+    uint8_t i;
+    uint32_t rev_period;
+    uint8_t rev_period_ext;
+    long long position64;
+    long long position64_end;
+    uint32_t tcr32;
+    int32_t position;
+#if defined(FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET) || QD_TCR2_TCRCLK
+    int24_t rc;
+#endif
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+    struct eqd_error_counters_t counters;
+    struct eqd_error_counters_t counters_end;
+#endif
+    struct eqd_state_t state;
+    struct eqd_instance_t instance;
+    uint32_t seq_retries;
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+    struct eqd_prof_t prof;
+    uint32_t utilization;
+#if QD_TCR2_TCRCLK
+    uint32_t index_threads;
+#endif
+#endif
+#if QD_TCR2_TCRCLK
+    int32_t revs;
+#endif
+    unsigned int pin_chans[2];
+    unsigned int pin_values[2];
+    uint8_t pin_a;
+    uint8_t pin_b;
+    uint24_t seq;
+#ifdef FS_ETPU_QD_RING_START_OFFSET
+    uint24_t ring_wr;
+    uint32_t *p_rec;
+    uint32_t *p_prev_rec;
+    uint32_t last_leading_edge;
+    uint8_t records;
+#endif
+    uint24_t tcr;
+    int32_t position_at;
     
-	/* initialize interrupt support */
-	isrLibInit();
-	/* enable interrupt acknowledgement */
-	isrEnableAllInterrupts();
-	
-    /* initialize eTPU */	
+    /* initialize interrupt support */
+    isrLibInit();
+    /* enable interrupt acknowledgement */
+    isrEnableAllInterrupts();
+
+    /* initialize eTPU */
     if (my_system_etpu_init())
         return 1;
 
@@ -58,346 +338,91 @@ int user_main()
     my_system_etpu_start();
 
     /* note: the below should probably be called in the etpu_gct.c my_system_etpu_init() routine */
-    if (fs_etpu_eqd_init(EM_AB, channel_primary, channel_secondary,
-        0, 0, FS_ETPU_QD_PRIM_SEC, FS_ETPU_PRIORITY_MIDDLE, FS_ETPU_QD_CONFIGURATION_0,
-        FS_ETPU_TCR1, 0, 21000, 19000, 29000, 28000, 
+    /* thresholds 21000/19000/29000/28000 rpm at 60 counts per revolution,
+       converted to TCR1 periods up front */
+    if (fs_etpu_eqd_init_precomputed(&g_qd_instance, EM_AB, channel_primary, channel_secondary,
+        0, QD_INDEX_CHAN, FS_ETPU_QD_PRIM_SEC_INDEX, FS_ETPU_PRIORITY_MIDDLE, FS_ETPU_QD_CONFIGURATION_0,
+        FS_ETPU_TCR1, 0,
+        (uint24_t)FS_ETPU_QD_RPM_TO_PERIOD(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 21000),
+        (uint24_t)FS_ETPU_QD_RPM_TO_PERIOD(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 19000),
+        (uint24_t)FS_ETPU_QD_RPM_TO_PERIOD(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 29000),
+        (uint24_t)FS_ETPU_QD_RPM_TO_PERIOD(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 28000),
         0x500000, 0xB00000, 
-        FS_ETPU_QD_HOME_TRANS_ANY, FS_ETPU_QD_INDEX_PULSE_POSITIVE, FS_ETPU_QD_INDEX_PC_NO_RESET,
-        FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60) != 0)
-        fail_loop();
-
-    // ********************************************
-    // Pin Init States.
-    // ********************************************
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-
-    // --------------- 1 ------------------
-    wait_time(500000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(500000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(500000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(500000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(500000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(400000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(300000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(200000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(100000);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(500000+400000+300000+200000));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(500000+400000+300000+200000))
-        fail_loop();
-    // --------------- 2 ------------------
-    wait_time(50000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(30000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(20000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(10000);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(100000+50000+30000+20000));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(100000+50000+30000+20000))
-        fail_loop();
-    // --------------- 2 ------------------
-    wait_time(5000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(3000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(1500);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(800);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(10000+5000+3000+1500));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(10000+5000+3000+1500))
+        FS_ETPU_QD_HOME_TRANS_ANY, FS_ETPU_QD_INDEX_PULSE_POSITIVE, FS_ETPU_QD_INDEX_PC_NO_RESET) != 0)
         fail_loop();
-    // --------------- 2 ------------------
-    wait_time(400);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(200);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(100);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(50);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(800+400+200+100));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(800+400+200+100))
+    // the same thresholds as converted at run time, and the instance resolved
+    // from the channel is the initialized one
+    if ((fs_etpu_get_chan_local_24_ext(EM_AB, channel_primary, FS_ETPU_QD_SLOW_NORMAL_THR_OFFSET) !=
+         fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 21000)) ||
+        (fs_etpu_get_chan_local_24_ext(EM_AB, channel_primary, FS_ETPU_QD_NORMAL_SLOW_THR_OFFSET) !=
+         fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 19000)) ||
+        (fs_etpu_get_chan_local_24_ext(EM_AB, channel_primary, FS_ETPU_QD_NORMAL_FAST_THR_OFFSET) !=
+         fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 29000)) ||
+        (fs_etpu_get_chan_local_24_ext(EM_AB, channel_primary, FS_ETPU_QD_FAST_NORMAL_THR_OFFSET) !=
+         fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 28000)))
         fail_loop();
-    // --------------- 2 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(50);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(50+50+50+50));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(50+50+50+50))
+    if ((fs_etpu_eqd_get_instance(EM_AB, channel_primary, &instance) != 0) ||
+        (instance.cpba != g_qd_instance.cpba) || (instance.cpba_pse != g_qd_instance.cpba_pse))
         fail_loop();
-    // --------------- 2 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(50);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(50+50+50+50));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(50+50+50+50))
-        fail_loop();
-    // --------------- 2 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(50);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(50+50+50+50));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(50+50+50+50))
-        fail_loop();
-    // --------------- 2 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(45);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(42);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(40);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(50+50+45+42));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(50+50+45+42))
+#ifdef FS_ETPU_QD_HIST_START_OFFSET
+    if (fs_etpu_eqd_h_edge_history_init(&g_qd_instance, QD_HIST_ENTRIES) != 0)
         fail_loop();
-    // --------------- 2 ------------------
-    wait_time(39);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(38);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(37);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(36);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(40+39+38+37));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(40+39+38+37))
+    // the history belongs to g_qd_instance, a resolved instance has none
+    if ((fs_etpu_eqd_get_instance(EM_AB, channel_primary, &instance) != 0) ||
+        (fs_etpu_eqd_h_edge_history_get(&instance, 1, g_qd_hist) != FS_ETPU_ERROR_VALUE))
         fail_loop();
-    // --------------- 2 ------------------
-    wait_time(35);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(34);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(33);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(32);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(36+35+34+33));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(36+35+34+33))
+#endif
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+    if (fs_etpu_eqd_h_period_avg_init(&g_qd_instance, 4) != 0)
         fail_loop();
-    // --------------- 2 ------------------
-    wait_time(31);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(30);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(30);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(30);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(32+31+30+30));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(32+31+30+30))
+#endif
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+    if (fs_etpu_eqd_h_trigger_init(&g_qd_instance, 3, 0) != 0)
         fail_loop();
-    // --------------- 2 ------------------
-    wait_time(30);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(30);
+#endif
+
+    // ********************************************
+    // Pin Init States.
+    // ********************************************
     write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(30);
     write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(30);
-    //verify_chan_data32(QD_PHASE_A_CHAN, FS_ETPU_QD_PERIOD_OFFSET, 50*(30+30+30+30));
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
-    if (period != 50*(30+30+30+30))
+
+    // from standstill up to FAST mode, one count at a time; the period of
+    // the 4 counts before each phase A rise is checked at that rise
+    qd_stim_init(&g_stim, &g_start_config, g_start_profile,
+        sizeof(g_start_profile)/sizeof(g_start_profile[0]));
+    qd_stim_run(&g_stim, 5);
+    for (i = 5; i < sizeof(g_start_profile)/sizeof(g_start_profile[0]); i += 4)
+    {
+        qd_stim_run(&g_stim, 4);
+        period = fs_etpu_eqd_get_period(EM_AB, channel_primary);
+        if (period != 50*(g_start_profile[i-1].duration_us + g_start_profile[i].duration_us +
+                          g_start_profile[i+1].duration_us + g_start_profile[i+2].duration_us))
+            fail_loop();
+    }
+#ifdef FS_ETPU_QD_PERIOD_AVG_OFFSET
+    period = fs_etpu_eqd_get_period_avg(EM_AB, channel_primary);
+    if (period != 50*((40+39+38+37)+(36+35+34+33)+(32+31+30+30)+(30+30+30+30))/4)
         fail_loop();
-    wait_time(30);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(30);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(30);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(31);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(32);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(33);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(34);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(35);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(36);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(38);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(40);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(42);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(44);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(46);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(48);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(50);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(52);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(54);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(56);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(58);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(60);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(100);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(250);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(500);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(1000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(2000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(4000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(8000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(20000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(50000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(100000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
-    // --------------- 1 ------------------
-    wait_time(200000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 1 );
-    // --------------- 2 ------------------
-    wait_time(300000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 1 );
-    // --------------- 3 ------------------
-    wait_time(400000);
-    write_chan_input_pin(QD_PHASE_A_CHAN, 0 );
-    // --------------- 4 ------------------
-    wait_time(500000);
-    write_chan_input_pin(QD_PHASE_B_CHAN, 0 );
+#endif
+    // decelerate through NORMAL and SLOW mode to standstill
+    // (FAST mode: pc is updated on leading edges, phase A has risen since)
+    g_stim_config.position = fs_etpu_eqd_get_pc(EM_AB, channel_primary) + 1;
+    qd_stim_init(&g_stim, &g_stim_config, g_decel_profile,
+        sizeof(g_decel_profile)/sizeof(g_decel_profile[0]));
+    qd_stim_run(&g_stim, 0);
 
     // verify a few more parameters at this point
     wait_time(10);
     //verify_chan_data8(QD_PHASE_A_CHAN, FS_ETPU_QD_DIRECTION_OFFSET, 1);
-    //verify_chan_data24(QD_PHASE_A_CHAN, FS_ETPU_QD_PC_OFFSET, 88);
-    //verify_chan_data24(QD_PHASE_A_CHAN, FS_ETPU_QD_PC_SC_OFFSET, 88);
     direction = fs_etpu_eqd_get_direction(EM_AB, channel_primary);
     if (direction != FS_ETPU_QD_DIRECTION_INC)
         fail_loop();
     pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
-    if (pc != 88)
+    if (pc != g_stim.position)
         fail_loop();
     pc_sc = fs_etpu_eqd_get_pc_sc(EM_AB, channel_primary);
-    if (pc_sc != 88)
+    if (pc_sc != g_stim.position)
         fail_loop();
 
 
@@ -477,20 +502,577 @@ int user_main()
     if (direction != FS_ETPU_QD_DIRECTION_INC)
         fail_loop();
     pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
-    if (pc != 92)
+    if (pc != g_stim.position + 4)
         fail_loop();
     pc_sc = fs_etpu_eqd_get_pc_sc(EM_AB, channel_primary);
-    if (pc_sc != 92)
+    if (pc_sc != g_stim.position + 4)
+        fail_loop();
+    // snapshot of the QD outputs - SLOW mode, leading edges 4x100us apart
+    if (fs_etpu_eqd_get_state(EM_AB, channel_primary, &state) != 0)
+        fail_loop();
+    if ((state.pc != g_stim.position + 4) || (state.pc_sc != g_stim.position + 4) ||
+        (state.direction != FS_ETPU_QD_DIRECTION_INC) ||
+        (state.mode != FS_ETPU_QD_MODE_SLOW) || (state.period != 50*400) ||
+        (state.last_edge != fs_etpu_eqd_get_tcr(EM_AB, channel_primary)) ||
+        (state.pins != 0) || (state.error_flags != 0) || (state.coherent != 1))
+        fail_loop();
+#ifdef FS_ETPU_QD_HIST_START_OFFSET
+    // edges 18..22 are 100us (5000 TCR1 ticks) apart, counting up
+    if (fs_etpu_eqd_h_edge_history_get(&g_qd_instance, 5, g_qd_hist) != 0)
+        fail_loop();
+    for (i = 0; i < 4; i++)
+    {
+        if (((g_qd_hist[i] - g_qd_hist[i+1]) & 0xffffff) != 50*100)
+            fail_loop();
+        if ((int8_t)(g_qd_hist[i] >> 24) != 1)
+            fail_loop();
+    }
+#endif
+
+    qd_readout_benchmark(channel_primary);
+
+    // soak; in SLOW mode each dropped edge costs 4 counts - the other phase
+    // toggles twice without the dropped one and counts down, then up again
+    g_stim_config.position = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+    g_stim_config.loops = QD_SOAK_LOOPS;
+    qd_stim_init(&g_stim, &g_stim_config, g_soak_profile,
+        sizeof(g_soak_profile)/sizeof(g_soak_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+    if (((pc - (g_stim.position - 4*(int32_t)g_stim.dropped)) & 0xffffff) != 0)
+        fail_loop();
+
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+    // position triggers, taken over on the first edge of the next run
+    g_qd_triggers[0].position = pc + 10;
+    g_qd_triggers[0].actions = FS_ETPU_QD_TRIGGER_INTERRUPT;
+    g_qd_triggers[1].position = pc + 20;
+    g_qd_triggers[1].actions = FS_ETPU_QD_TRIGGER_DMA;
+    g_qd_triggers[2].position = pc + 100;
+    g_qd_triggers[2].actions = FS_ETPU_QD_TRIGGER_INTERRUPT | FS_ETPU_QD_TRIGGER_DMA;
+    if (fs_etpu_eqd_h_trigger_load(&g_qd_instance, g_qd_triggers, 3) != 0)
+        fail_loop();
+    if (fs_etpu_eqd_h_trigger_load(&g_qd_instance, g_qd_triggers, 3) != FS_ETPU_ERROR_NOT_READY)
+        fail_loop();
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+    fs_etpu_clear_chan_dma_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+#endif
+
+    // revolution period on the index channel; the absolute position follows
+    // the encoder across the index
+    if (fs_etpu_eqd_get_position64(EM_AB, channel_primary, &position64) != 0)
+        fail_loop();
+    g_stim_config.position = pc;
+    g_stim_config.loops = 1;
+    qd_stim_init(&g_stim, &g_stim_config, g_rev_profile,
+        sizeof(g_rev_profile)/sizeof(g_rev_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if (fs_etpu_eqd_get_rev_period(EM_AB, channel_primary, &rev_period, &rev_period_ext) != 0)
+        fail_loop();
+    if ((rev_period != 50*300000) || (rev_period_ext != 0))
+        fail_loop();
+    if ((fs_etpu_eqd_get_position64(EM_AB, channel_primary, &position64_end) != 0) ||
+        (position64_end - position64 != g_stim.position - pc))
+        fail_loop();
+    position = g_stim.position;
+#ifdef FS_ETPU_QD_TRIG_START_OFFSET
+    if (fs_etpu_eqd_h_trigger_get_last(&g_qd_instance) !=
+        (((uint32_t)(FS_ETPU_QD_TRIGGER_INTERRUPT | FS_ETPU_QD_TRIGGER_DMA) << 24) | ((pc + 100) & 0xffffff)))
+        fail_loop();
+    if (!fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) ||
+        !fs_etpu_get_chan_dma_flag_ext(EM_AB, QD_PHASE_A_CHAN))
+        fail_loop();
+
+    // a table taken over on an edge fires an entry at the pc of that edge,
+    // in both directions; an empty table ends the triggers
+    pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+    for (i = 0; i < 2; i++)
+    {
+        g_qd_triggers[0].position = (i == 0) ? pc + 1 : pc - 1;
+        g_qd_triggers[0].actions = FS_ETPU_QD_TRIGGER_INTERRUPT;
+        if (fs_etpu_eqd_h_trigger_load(&g_qd_instance, g_qd_triggers, 1) != 0)
+            fail_loop();
+        fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+        qd_move(&position, (i == 0) ? 1 : -1);
+        if (!fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) ||
+            (fs_etpu_eqd_h_trigger_get_last(&g_qd_instance) !=
+             (((uint32_t)FS_ETPU_QD_TRIGGER_INTERRUPT << 24) | (g_qd_triggers[0].position & 0xffffff))))
+            fail_loop();
+        pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+    }
+    if (fs_etpu_eqd_h_trigger_load(&g_qd_instance, 0, 0) != 0)
+        fail_loop();
+#endif
+    qd_move(&position, 1);
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+
+#ifdef FS_ETPU_QD_IRQ_MIN_INTERVAL_OFFSET
+    // pc_interrupt coalescing - dither around pc_interrupt1 at standstill
+    pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+    if (fs_etpu_eqd_set_pc_interrupts(EM_AB, channel_primary, pc + 1, pc - 1000) != 0)
+        fail_loop();
+    if (fs_etpu_eqd_set_pc_interrupt_coalescing(EM_AB, channel_primary, 0, 2, 0) != 0)
+        fail_loop();
+    if (fs_etpu_eqd_enable_pc_interrupts(EM_AB, channel_primary) != 0)
+        fail_loop();
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN);
+    for (i = 0; i < 5; i++)
+    {
+        qd_move(&position, 1);
+        qd_move(&position, -1);
+    }
+    // the first of 5 hits interrupts, the others are within the hysteresis
+    if (fs_etpu_eqd_get_pc_interrupts_suppressed(EM_AB, channel_primary) != 4)
         fail_loop();
+    if (!fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) &&
+        !fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN))
+        fail_loop();
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN);
+    // re-armed 3 counts away, interrupts on the way back
+    qd_move(&position, 4);
+    if ((fs_etpu_eqd_get_pc_interrupts_suppressed(EM_AB, channel_primary) != 5) ||
+        fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) ||
+        fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN))
+        fail_loop();
+    qd_move(&position, -3);
+    if ((fs_etpu_eqd_get_pc_interrupts_suppressed(EM_AB, channel_primary) != 5) ||
+        (!fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) &&
+         !fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN)))
+        fail_loop();
+    // minimum interval 5ms, hits every 2ms - interrupts at 0 and 6ms of 0..8ms
+    if (fs_etpu_eqd_set_pc_interrupt_coalescing(EM_AB, channel_primary, 50*5000, 0, 0) != 0)
+        fail_loop();
+    for (i = 0; i < 5; i++)
+    {
+        qd_move(&position, -1);
+        qd_move(&position, 1);
+    }
+    if (fs_etpu_eqd_get_pc_interrupts_suppressed(EM_AB, channel_primary) != 8)
+        fail_loop();
+    // every 2nd revolution - interrupts only when rc is even
+    if (fs_etpu_eqd_set_pc_interrupt_coalescing(EM_AB, channel_primary, 0, 0, 2) != 0)
+        fail_loop();
+    rc = fs_etpu_eqd_get_rc(EM_AB, channel_primary);
+    qd_move(&position, -1);
+    qd_move(&position, 1);
+    if (fs_etpu_eqd_get_pc_interrupts_suppressed(EM_AB, channel_primary) != ((rc & 1) ? 9 : 8))
+        fail_loop();
+#else
+    // pc_interrupt - an interrupt on each hit of pc_interrupt1
+    pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+    if (fs_etpu_eqd_set_pc_interrupts(EM_AB, channel_primary, pc + 1, pc - 1000) != 0)
+        fail_loop();
+    if (fs_etpu_eqd_enable_pc_interrupts(EM_AB, channel_primary) != 0)
+        fail_loop();
+    for (i = 0; i < 2; i++)
+    {
+        fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+        fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN);
+        qd_move(&position, 1);
+        if (!fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) &&
+            !fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN))
+            fail_loop();
+        qd_move(&position, -1);
+    }
+#endif
+    if (fs_etpu_eqd_disable_pc_interrupts(EM_AB, channel_primary) != 0)
+        fail_loop();
+
+    // glitch and illegal transition detection (SLOW mode) - a phase A pulse
+    // that is over before its edge is serviced is not counted; a change of
+    // both phases between two services is counted, and flagged. The pins
+    // written by write_chan_input_pins change before any service.
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+    if (fs_etpu_eqd_get_error_counters(EM_AB, channel_primary, &counters) != 0)
+        fail_loop();
+#endif
+    // the latch publishes error_flags between two seq increments
+    seq = fs_etpu_get_chan_local_24_ext(EM_AB, channel_primary, FS_ETPU_QD_SEQ_OFFSET);
+    if (fs_etpu_eqd_latch_and_clear_error_flags(EM_AB, channel_primary) != 0)
+        fail_loop();
+    wait_time(1000);
+    if (fs_etpu_get_chan_local_24_ext(EM_AB, channel_primary, FS_ETPU_QD_SEQ_OFFSET) !=
+        ((seq + 2) & 0xffffff))
+        fail_loop();
+    pc = fs_etpu_eqd_get_pc(EM_AB, channel_primary);
+    pin_a = ((position & 3) == 1) || ((position & 3) == 2);
+    pin_b = (position & 3) >= 2;
+    pin_chans[0] = QD_PHASE_A_CHAN;
+    pin_values[0] = !pin_a;
+    pin_chans[1] = QD_PHASE_A_CHAN;
+    pin_values[1] = pin_a;
+    write_chan_input_pins(2, pin_chans, pin_values);
+    wait_time(1000);
+    if ((fs_etpu_eqd_get_pc(EM_AB, channel_primary) != pc) ||
+        (fs_etpu_eqd_get_current_error_flags(EM_AB, channel_primary) != FS_ETPU_QD_ERROR_SPURIOUS))
+        fail_loop();
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+    fs_etpu_eqd_get_error_counters(EM_AB, channel_primary, &counters_end);
+    if ((counters_end.spurious != counters.spurious + 1) ||
+        (counters_end.illegal != counters.illegal))
+        fail_loop();
+#endif
+    pin_chans[1] = QD_PHASE_B_CHAN;
+    pin_values[1] = !pin_b;
+    write_chan_input_pins(2, pin_chans, pin_values);
+    wait_time(1000);
+    pin_values[0] = pin_a;
+    pin_values[1] = pin_b;
+    write_chan_input_pins(2, pin_chans, pin_values);
+    wait_time(1000);
+    if (!(fs_etpu_eqd_get_current_error_flags(EM_AB, channel_primary) & FS_ETPU_QD_ERROR_ILLEGAL))
+        fail_loop();
+#ifdef FS_ETPU_QD_ILLEGAL_COUNT_OFFSET
+    fs_etpu_eqd_get_error_counters(EM_AB, channel_primary, &counters_end);
+    if ((counters_end.illegal != counters.illegal + 2) ||
+        (counters_end.spurious != counters.spurious + 1))
+        fail_loop();
+#endif
+    // each jump by 2 counts is taken as 2 counts in the same direction, the
+    // pins are back where they were
+    if ((((fs_etpu_eqd_get_pc(EM_AB, channel_primary) - pc) & 0xffffff) != 4) &&
+        (((pc - fs_etpu_eqd_get_pc(EM_AB, channel_primary)) & 0xffffff) != 4))
+        fail_loop();
+    position += ((fs_etpu_eqd_get_pc(EM_AB, channel_primary) - pc) & 0xffffff) == 4 ? 4 : -4;
+
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+    // thread profiling - one SLOW mode edge thread per count
+    if (fs_etpu_eqd_prof_reset(EM_AB, channel_primary) != 0)
+        fail_loop();
+    qd_move(&position, 4);
+    if (fs_etpu_eqd_prof_get(EM_AB, channel_primary, &prof) != 0)
+        fail_loop();
+    if ((prof.slow_normal != 4) || (prof.fast != 0) ||
+        (prof.mode_switch != 0) || (prof.init != 0))
+        fail_loop();
+    utilization = fs_etpu_eqd_prof_utilization(&prof, (uint32_t)SYS_FREQ_HZ, 4000);
+    if ((utilization == 0) || (utilization >= FS_ETPU_QD_PROF_UTIL_FULL))
+        fail_loop();
+#endif
+
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+    // standstill detection - 20ms timeout with interrupt
+    if (fs_etpu_eqd_set_standstill(EM_AB, channel_primary, 50*20000,
+                                   FS_ETPU_QD_STANDSTILL_IRQ_ENABLE) != 0)
+        fail_loop();
+#endif
+    qd_move(&position, 1);
+    tcr32 = fs_etpu_eqd_get_tcr32(EM_AB, channel_primary);
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN);
+    wait_time(15000);
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+    if (fs_etpu_eqd_get_standstill(EM_AB, channel_primary) ||
+        fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) ||
+        fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN))
+        fail_loop();
+#endif
+    wait_time(10000);
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+    if (!fs_etpu_eqd_get_standstill(EM_AB, channel_primary) ||
+        (!fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) &&
+         !fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN)))
+        fail_loop();
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN);
+    fs_etpu_clear_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN);
+    // period overflow matches only extend the TCR - no interrupt, stays at
+    // standstill, and a single match per TCR wrap (~1.5 wraps here)
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+    if (fs_etpu_eqd_prof_reset(EM_AB, channel_primary) != 0)
+        fail_loop();
+#endif
+#endif
+    wait_time(500000);
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+    if (!fs_etpu_eqd_get_standstill(EM_AB, channel_primary) ||
+        fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_A_CHAN) ||
+        fs_etpu_get_chan_interrupt_flag_ext(EM_AB, QD_PHASE_B_CHAN))
+        fail_loop();
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+    if (fs_etpu_eqd_prof_get(EM_AB, channel_primary, &prof) != 0)
+        fail_loop();
+    if ((prof.overflow == 0) || (prof.overflow > 2))
+        fail_loop();
+#endif
+#endif
+    qd_move(&position, 4);
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+    // the first period after standstill is saturated, the next one measured
+    if (fs_etpu_eqd_get_standstill(EM_AB, channel_primary) ||
+        (fs_etpu_eqd_get_period(EM_AB, channel_primary) < FS_ETPU_QD_PERIOD_STANDSTILL))
+        fail_loop();
+#endif
+    // 32-bit edge time across more than one TCR1 wrap of standstill
+    if ((fs_etpu_eqd_get_tcr32(EM_AB, channel_primary) - tcr32 != 50*529000) ||
+        ((fs_etpu_eqd_get_tcr32(EM_AB, channel_primary) & 0xffffff) !=
+         fs_etpu_eqd_get_tcr(EM_AB, channel_primary)))
+        fail_loop();
+    qd_move(&position, 4);
+    if (fs_etpu_eqd_get_period(EM_AB, channel_primary) != 50*4000)
+        fail_loop();
+    // the same under the sequence counter, read without a retry
+    seq_retries = g_qd_instance.seq_retries;
+    if (fs_etpu_eqd_h_get_state_seq(&g_qd_instance, &state) != 0)
+        fail_loop();
+    if ((((state.pc - position) & 0xffffff) != 0) ||
+        (state.direction != FS_ETPU_QD_DIRECTION_INC) ||
+        (state.mode != FS_ETPU_QD_MODE_SLOW) || (state.period != 50*4000) ||
+        (state.last_edge != fs_etpu_eqd_h_get_tcr(&g_qd_instance)) ||
+        (state.coherent != 1) || (g_qd_instance.seq_retries != seq_retries))
+        fail_loop();
+#ifdef FS_ETPU_QD_STANDSTILL_OFFSET
+    if (fs_etpu_eqd_set_standstill(EM_AB, channel_primary, 0, 0) != 0)
+        fail_loop();
+#endif
 
+#ifdef FS_ETPU_QD_FAST_REVERSAL_OFFSET
+    // FAST mode reversal detection - from a position with both pins low, so
+    // that the shaft turns at the same place relative to the leading edges
+    if (fs_etpu_eqd_set_fast_reversal(EM_AB, channel_primary, FS_ETPU_QD_FAST_REVERSAL_ENABLE) != 0)
+        fail_loop();
+    qd_move(&position, (-position) & 3);
+    g_stim_config.position = position;
+    qd_stim_init(&g_stim, &g_stim_config, g_fast_profile,
+        sizeof(g_fast_profile)/sizeof(g_fast_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if (fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_FAST)
+        fail_loop();
+    if (fs_etpu_eqd_latch_and_clear_error_flags(EM_AB, channel_primary) != 0)
+        fail_loop();
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_reversal_profile,
+        sizeof(g_reversal_profile)/sizeof(g_reversal_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if (!(fs_etpu_eqd_get_current_error_flags(EM_AB, channel_primary) & FS_ETPU_QD_ERROR_REVERSAL) ||
+        (fs_etpu_eqd_get_direction(EM_AB, channel_primary) != FS_ETPU_QD_DIRECTION_DEC) ||
+        (fs_etpu_eqd_get_pc(EM_AB, channel_primary) != g_stim.position))
+        fail_loop();
+    if (fs_etpu_eqd_set_fast_reversal(EM_AB, channel_primary, 0) != 0)
+        fail_loop();
+    position = g_stim.position;
+#endif
 
+    // ULTRA FAST mode - above 50000rpm, back to FAST mode below 45000rpm
+    if (fs_etpu_eqd_get_position64(EM_AB, channel_primary, &position64) != 0)
+        fail_loop();
+    if (fs_etpu_eqd_set_ultra_fast(EM_AB, channel_primary,
+            fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 50000),
+            fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 45000)) != 0)
+        fail_loop();
+    g_stim_config.position = position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_profile,
+        sizeof(g_ultra_profile)/sizeof(g_ultra_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if ((fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_ULTRA_FAST) ||
+        (g_stim.position - fs_etpu_eqd_get_pc(EM_AB, channel_primary) < 0) ||
+        (g_stim.position - fs_etpu_eqd_get_pc(EM_AB, channel_primary) >= 8))
+        fail_loop();
+    // stopped at once - the timeout recovers the position from the pins
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_halt_profile,
+        sizeof(g_ultra_halt_profile)/sizeof(g_ultra_halt_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if ((fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_SLOW) ||
+        (fs_etpu_eqd_get_pc(EM_AB, channel_primary) != g_stim.position))
+        fail_loop();
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_profile,
+        sizeof(g_ultra_profile)/sizeof(g_ultra_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if (fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_ULTRA_FAST)
+        fail_loop();
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_stop_profile,
+        sizeof(g_ultra_stop_profile)/sizeof(g_ultra_stop_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if ((fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_SLOW) ||
+        (fs_etpu_eqd_get_pc(EM_AB, channel_primary) != g_stim.position))
+        fail_loop();
 
-	/* TESTING DONE */
-	
-	g_complete_flag = 1;
+#if QD_TCR2_TCRCLK
+    // TCR2 counting mode - above 60000rpm, TCR2 counts the phase A edges and
+    // the position is updated every 200us
+    if (fs_etpu_eqd_set_tcr2_counting(EM_AB, channel_primary,
+            fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 60000),
+            fs_etpu_eqd_rpm_to_period(FS_ETPU_QD_ETPU_A_TCR1_FREQ, 60, 55000),
+            FS_ETPU_QD_ETPU_A_TCR1_FREQ/5000) != 0)
+        fail_loop();
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_profile,
+        sizeof(g_ultra_profile)/sizeof(g_ultra_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if ((fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_TCR2) ||
+        (g_stim.position - fs_etpu_eqd_get_pc(EM_AB, channel_primary) < 0) ||
+        (g_stim.position - fs_etpu_eqd_get_pc(EM_AB, channel_primary) > 20))
+        fail_loop();
+    // the index pulses are counted in TCR2 mode as well, one index thread
+    // per pulse and no links waiting for a leading edge
+    rc = fs_etpu_eqd_get_rc(EM_AB, channel_primary);
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+    if (fs_etpu_eqd_prof_get(EM_AB, channel_primary, &prof) != 0)
+        fail_loop();
+#endif
+    revs = g_stim.position/60;
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_tcr2_profile,
+        sizeof(g_tcr2_profile)/sizeof(g_tcr2_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if ((fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_TCR2) ||
+        (fs_etpu_eqd_get_rc(EM_AB, channel_primary) - rc != g_stim.position/60 - revs))
+        fail_loop();
+#ifdef FS_ETPU_QD_PROF_INIT_OFFSET
+    index_threads = prof.index_home;
+    if (fs_etpu_eqd_prof_get(EM_AB, channel_primary, &prof) != 0)
+        fail_loop();
+    index_threads = (prof.index_home - index_threads) & 0xffffff;
+    if (index_threads > (uint32_t)(2*(g_stim.position/60 - revs) + 2))
+        fail_loop();
+#endif
+    // stopped at once - no edge counted within the interval
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_halt_profile,
+        sizeof(g_ultra_halt_profile)/sizeof(g_ultra_halt_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if ((fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_SLOW) ||
+        (fs_etpu_eqd_get_pc(EM_AB, channel_primary) != g_stim.position))
+        fail_loop();
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_profile,
+        sizeof(g_ultra_profile)/sizeof(g_ultra_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if (fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_TCR2)
+        fail_loop();
+    g_stim_config.position = g_stim.position;
+    qd_stim_init(&g_stim, &g_stim_config, g_ultra_stop_profile,
+        sizeof(g_ultra_stop_profile)/sizeof(g_ultra_stop_profile[0]));
+    qd_stim_run(&g_stim, 0);
+    if ((fs_etpu_eqd_get_mode(EM_AB, channel_primary) != FS_ETPU_QD_MODE_SLOW) ||
+        (fs_etpu_eqd_get_pc(EM_AB, channel_primary) != g_stim.position))
+        fail_loop();
+    if (fs_etpu_eqd_set_tcr2_counting(EM_AB, channel_primary, 0, 0, 0) != 0)
+        fail_loop();
+#endif
+    if (fs_etpu_eqd_set_ultra_fast(EM_AB, channel_primary, 0, 0) != 0)
+        fail_loop();
+    // absolute position - counted in all modes
+    if ((fs_etpu_eqd_get_position64(EM_AB, channel_primary, &position64_end) != 0) ||
+        (position64_end - position64 != g_stim.position - position))
+        fail_loop();
+
+    position = g_stim.position;
+#ifdef FS_ETPU_QD_RING_START_OFFSET
+    // edge ring - a record {direction, last leading edge}, {sequence, pc}
+    // per leading edge, released by the read index; limited to DATA RAM size
+    if (fs_etpu_eqd_h_edge_ring_init(&g_qd_instance, FS_ETPU_QD_EDGE_RING_MAX + 1,
+                                     FS_ETPU_QD_EDGE_RING_POLLED) != FS_ETPU_ERROR_VALUE)
+        fail_loop();
+    if (fs_etpu_eqd_h_edge_ring_init(&g_qd_instance, QD_RING_RECORDS,
+                                     FS_ETPU_QD_EDGE_RING_POLLED) != 0)
+        fail_loop();
+    ring_wr = 0;
+    records = 0;
+    for (i = 0; i < 8; i++)
+    {
+        qd_move(&position, 1);
+        if (fs_etpu_eqd_h_edge_ring_get_wr_index(&g_qd_instance) == ring_wr)
+            continue;
+        p_rec = g_qd_instance.edge_ring + 2*ring_wr;
+        if (fs_etpu_eqd_h_get_tcr32(&g_qd_instance, &tcr32, &last_leading_edge) != 0)
+            fail_loop();
+        if (((p_rec[0] & 0xffffff) != (last_leading_edge & 0xffffff)) ||
+            ((int8_t)(p_rec[0] >> 24) != 1) ||
+            (((p_rec[1] - (uint32_t)fs_etpu_eqd_get_pc(EM_AB, channel_primary)) & 0xffffff) != 0) ||
+            ((uint8_t)(p_rec[1] >> 24) != records))
+            fail_loop();
+        ring_wr = (ring_wr + 1) % QD_RING_RECORDS;
+        records++;
+        if ((fs_etpu_eqd_h_edge_ring_get_wr_index(&g_qd_instance) != ring_wr) ||
+            (fs_etpu_eqd_h_edge_ring_set_rd_index(&g_qd_instance, ring_wr) != 0))
+            fail_loop();
+    }
+    if ((records < 2) || (fs_etpu_eqd_h_edge_ring_get_overflow(&g_qd_instance) != 0))
+        fail_loop();
+    // not released - the ring fills up and the following records are dropped,
+    // which shows as a gap in the sequence of the next record kept
+    for (i = 0; (i < 64) && (fs_etpu_eqd_h_edge_ring_get_overflow(&g_qd_instance) < 2); i++)
+        qd_move(&position, 1);
+    ring_wr = fs_etpu_eqd_h_edge_ring_get_wr_index(&g_qd_instance);
+    p_prev_rec = g_qd_instance.edge_ring + 2*((ring_wr + QD_RING_RECORDS - 1) % QD_RING_RECORDS);
+    if ((fs_etpu_eqd_h_edge_ring_get_overflow(&g_qd_instance) != 2) ||
+        (fs_etpu_eqd_h_edge_ring_set_rd_index(&g_qd_instance, ring_wr) != 0))
+        fail_loop();
+    for (i = 0; (i < 8) && (fs_etpu_eqd_h_edge_ring_get_wr_index(&g_qd_instance) == ring_wr); i++)
+        qd_move(&position, 1);
+    p_rec = g_qd_instance.edge_ring + 2*ring_wr;
+    if ((fs_etpu_eqd_h_edge_ring_get_wr_index(&g_qd_instance) == ring_wr) ||
+        (fs_etpu_eqd_edge_ring_lost(p_prev_rec, p_rec) != 2))
+        fail_loop();
+#else
+    qd_move(&position, 8);
+#endif
+
+    // position between edges - a count every 1ms, half a count after the last
+    // edge, limited to one count; a time before the last edge is outside
+    tcr = fs_etpu_eqd_h_get_tcr(&g_qd_instance);
+    pc = fs_etpu_eqd_h_get_pc(&g_qd_instance);
+    if ((fs_etpu_eqd_h_get_period(&g_qd_instance) != 50*4000) ||
+        (fs_etpu_eqd_h_get_position_at(&g_qd_instance, tcr + 50*500, &position_at) != 0) ||
+        (position_at - pc*(1 << FS_ETPU_QD_POSITION_FRAC_BITS) < (1 << (FS_ETPU_QD_POSITION_FRAC_BITS - 1)) - 1) ||
+        (position_at - pc*(1 << FS_ETPU_QD_POSITION_FRAC_BITS) > (1 << (FS_ETPU_QD_POSITION_FRAC_BITS - 1))))
+        fail_loop();
+    if ((fs_etpu_eqd_h_get_position_at(&g_qd_instance, tcr + 50*5000, &position_at) != 0) ||
+        (position_at != (pc + 1)*(1 << FS_ETPU_QD_POSITION_FRAC_BITS)))
+        fail_loop();
+    if (fs_etpu_eqd_h_get_position_at(&g_qd_instance, tcr - 1, &position_at) != FS_ETPU_ERROR_VALUE)
+        fail_loop();
+    // one count above the largest pc saturates
+    if ((fs_etpu_eqd_set_pc(EM_AB, channel_primary, 0x7FFFFF) != 0) ||
+        (fs_etpu_eqd_h_get_position_at(&g_qd_instance, tcr + 50*5000, &position_at) != 0) ||
+        (position_at != 0x7FFFFFFF) ||
+        (fs_etpu_eqd_set_pc(EM_AB, channel_primary, pc) != 0))
+        fail_loop();
 
-	while (1)
-		;
+    // alignment - started without waiting, done when both init HSRs have
+    // been serviced (held off while the channels are disabled); pc is set to
+    // 1000-1..1000+2 by the pin state
+    if ((fs_etpu_eqd_disable(EM_AB, channel_primary, channel_secondary, 0, QD_INDEX_CHAN,
+                             FS_ETPU_QD_PRIM_SEC_INDEX) != 0) ||
+        (fs_etpu_eqd_h_align_start(&g_qd_instance, 1000, 0) != 0) ||
+        (fs_etpu_eqd_h_align_start(&g_qd_instance, 1000, 0) != FS_ETPU_ERROR_NOT_READY) ||
+        (fs_etpu_eqd_h_align_poll(&g_qd_instance) != FS_ETPU_ERROR_NOT_READY))
+        fail_loop();
+    if ((fs_etpu_eqd_enable(EM_AB, channel_primary, channel_secondary, 0, QD_INDEX_CHAN,
+                            FS_ETPU_QD_PRIM_SEC_INDEX, FS_ETPU_PRIORITY_MIDDLE) != 0) ||
+        (fs_etpu_eqd_h_align_poll(&g_qd_instance) != 0))
+        fail_loop();
+    pc = fs_etpu_eqd_h_get_pc(&g_qd_instance);
+    if ((pc < 1000 - 1) || (pc > 1000 + 2) ||
+        (fs_etpu_eqd_h_get_pc_sc(&g_qd_instance) != 0) ||
+        (fs_etpu_eqd_h_align_poll(&g_qd_instance) != FS_ETPU_ERROR_VALUE))
+        fail_loop();
+    // not serviced within 2 polls - the alignment is abandoned; the init HSRs
+    // serviced later reset pc, it is not aligned
+    if ((fs_etpu_eqd_disable(EM_AB, channel_primary, channel_secondary, 0, QD_INDEX_CHAN,
+                             FS_ETPU_QD_PRIM_SEC_INDEX) != 0) ||
+        (fs_etpu_eqd_h_align_start(&g_qd_instance, 2000, 2) != 0) ||
+        (fs_etpu_eqd_h_align_poll(&g_qd_instance) != FS_ETPU_ERROR_NOT_READY) ||
+        (fs_etpu_eqd_h_align_poll(&g_qd_instance) != FS_ETPU_ERROR_TIMING) ||
+        (fs_etpu_eqd_h_align_poll(&g_qd_instance) != FS_ETPU_ERROR_VALUE))
+        fail_loop();
+    if ((fs_etpu_eqd_enable(EM_AB, channel_primary, channel_secondary, 0, QD_INDEX_CHAN,
+                            FS_ETPU_QD_PRIM_SEC_INDEX, FS_ETPU_PRIORITY_MIDDLE) != 0) ||
+        (fs_etpu_eqd_h_get_pc(&g_qd_instance) != 0))
+        fail_loop();
+
+
+    /* TESTING DONE */
+
+    g_complete_flag = 1;
+
+    while (1)
+        ;
 
-	return 0;
+    return 0;
 }
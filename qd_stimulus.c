@@ -0,0 +1,316 @@
+/*******************************************************************************
+* FILE NAME: qd_stimulus.c
+*
+* DESCRIPTION:
+* Quadrature encoder stimulus generator for the QD test application. See
+* qd_stimulus.h.
+*
+* The encoder position is integrated from the segment speed. The position
+* within a count ('phase') is kept in units of 1/(60e6*256) counts, so a
+* speed of rpm*pc_per_rev advances it by exactly rpm*pc_per_rev units per
+* 1/256 us. A count (A/B edge) is complete when the phase leaves the range
+* 0..QD_STIM_COUNT-1. A QD_STIM_STEP segment makes a single count at its end
+* instead, for edge intervals that are not a whole rpm.
+*******************************************************************************/
+#include "typedefs.h"
+#include "ScriptLib.h"
+#include "qd_stimulus.h"
+
+/* phase units per count: 60 s/min * 1e6 us/s * 256 */
+#define QD_STIM_COUNT      15360000000LL
+
+/*******************************************************************************
+*FUNCTION     : qd_stim_rpm
+*PURPOSE      : Speed of a segment at a time.
+*INPUTS NOTES : This function has 2 parameters:
+*  p_segment - segment
+*  t         - time from the segment start, 1/256 us
+*RETURNS NOTES: Speed in rpm.
+*******************************************************************************/
+static int32_t qd_stim_rpm(const struct qd_stim_segment_t *p_segment,
+                           unsigned long long t)
+{
+   unsigned long long duration = (unsigned long long)p_segment->duration_us << 8;
+   long long u, u2, s;
+
+   if (duration == 0)
+      return(p_segment->rpm_start);
+   u = (long long)((t << 16) / duration);    /* 0..1 in 1/65536 */
+
+   switch (p_segment->type)
+   {
+   case QD_STIM_RAMP:
+      return((int32_t)(p_segment->rpm_start +
+             (((long long)p_segment->rpm_end - p_segment->rpm_start) * u >> 16)));
+   case QD_STIM_SCURVE:
+      u2 = (u * u) >> 16;
+      s = 3*u2 - 2*((u2 * u) >> 16);
+      return((int32_t)(p_segment->rpm_start +
+             (((long long)p_segment->rpm_end - p_segment->rpm_start) * s >> 16)));
+   case QD_STIM_REVERSAL:
+      return((int32_t)(p_segment->rpm_start -
+             (2LL * p_segment->rpm_start * u >> 16)));
+   default:
+      return(p_segment->rpm_start);
+   }
+}
+
+/*******************************************************************************
+*FUNCTION     : qd_stim_levels
+*PURPOSE      : Encoder pin levels at a position.
+*INPUTS NOTES : This function has 2 parameters:
+*  p_config - encoder configuration
+*  position - A/B count
+*RETURNS NOTES: QD_STIM_PIN_* levels. Phase A leads phase B when the
+*               position increments.
+*******************************************************************************/
+static uint8_t qd_stim_levels(const struct qd_stim_config_t *p_config,
+                              int32_t position)
+{
+   uint8_t state = (uint8_t)(position & 3);
+   uint8_t levels = 0;
+   int32_t rev_position;
+
+   if ((state == 1) || (state == 2))
+      levels |= QD_STIM_PIN_A;
+   if (state >= 2)
+      levels |= QD_STIM_PIN_B;
+   if (p_config->pc_per_rev)
+   {
+      rev_position = position % (int32_t)p_config->pc_per_rev;
+      if (rev_position == 0)
+         levels |= QD_STIM_PIN_INDEX;
+   }
+   if (position == p_config->home_position)
+      levels |= QD_STIM_PIN_HOME;
+   return(levels);
+}
+
+/*******************************************************************************
+*FUNCTION     : qd_stim_queue
+*PURPOSE      : Queue the transition of one pin if its driven level changes.
+*INPUTS NOTES : This function has 5 parameters:
+*  p_stim   - generator
+*  chan     - channel of the pin, QD_STIM_NO_CHANNEL if not used
+*  pin      - QD_STIM_PIN_* bit
+*  levels   - new levels
+*  delay_us - time from the previous transition
+*RETURNS NOTES: 1 if a transition was queued, 0 otherwise.
+*******************************************************************************/
+static uint8_t qd_stim_queue(struct qd_stim_t *p_stim,
+                             uint8_t chan,
+                             uint8_t pin,
+                             uint8_t levels,
+                             uint32_t delay_us)
+{
+   struct qd_stim_edge_t *p_edge;
+
+   if ((chan == QD_STIM_NO_CHANNEL) || (((p_stim->pins ^ levels) & pin) == 0))
+      return(0);
+   p_stim->pins ^= pin;
+   p_edge = &p_stim->queue[p_stim->queue_count++];
+   p_edge->delay_us = delay_us;
+   p_edge->chan = chan;
+   p_edge->value = (levels & pin) ? 1 : 0;
+   return(1);
+}
+
+/*******************************************************************************
+*FUNCTION     : qd_stim_init
+*PURPOSE      : To start a stimulus profile.
+*INPUTS NOTES : This function has 4 parameters:
+*  p_stim        - generator state to initialize
+*  p_config      - encoder configuration, must stay valid while streaming
+*  p_segments    - profile segments, must stay valid while streaming
+*  segment_count - number of segments
+*******************************************************************************/
+void qd_stim_init(struct qd_stim_t *p_stim,
+                  const struct qd_stim_config_t *p_config,
+                  const struct qd_stim_segment_t *p_segments,
+                  uint16_t segment_count)
+{
+   p_stim->p_config = p_config;
+   p_stim->p_segments = p_segments;
+   p_stim->segment_count = segment_count;
+   p_stim->segment = 0;
+   p_stim->loop = 0;
+   p_stim->segment_edges = 0;
+   p_stim->segment_start = 0;
+   p_stim->now = 0;
+   p_stim->emitted_us = 0;
+   p_stim->phase = QD_STIM_COUNT/2;      /* start mid-count */
+   p_stim->position = p_config->position;
+   p_stim->edges = 0;
+   p_stim->dropped = 0;
+   p_stim->random = p_config->seed ? p_config->seed : 1;
+   p_stim->pins = qd_stim_levels(p_config, p_config->position);
+   p_stim->stuck = 0;
+   p_stim->queue_count = 0;
+   p_stim->queue_next = 0;
+}
+
+/*******************************************************************************
+*FUNCTION     : qd_stim_next
+*PURPOSE      : To generate the next pin transition of the profile.
+*INPUTS NOTES : This function has 2 parameters:
+*  p_stim - generator
+*  p_edge - filled with the transition
+*RETURNS NOTES: 1 if a transition was returned, 0 at the end of the profile.
+*******************************************************************************/
+uint8_t qd_stim_next(struct qd_stim_t *p_stim,
+                     struct qd_stim_edge_t *p_edge)
+{
+   const struct qd_stim_config_t *p_config = p_stim->p_config;
+   const struct qd_stim_segment_t *p_segment;
+   unsigned long long duration, end, step, t_edge, rate;
+   unsigned long long time_us;
+   int32_t rpm, jitter;
+   uint8_t levels;
+
+   while (p_stim->queue_next == p_stim->queue_count)
+   {
+      p_stim->queue_next = p_stim->queue_count = 0;
+
+      if (p_stim->segment >= p_stim->segment_count)
+      {
+         if ((++p_stim->loop >= p_config->loops) || (p_stim->segment_count == 0))
+            return(0);
+         p_stim->segment = 0;
+      }
+      p_segment = &p_stim->p_segments[p_stim->segment];
+      duration = (unsigned long long)p_segment->duration_us << 8;
+      end = p_stim->segment_start + duration;
+      if (p_stim->now >= end)
+      {
+         p_stim->segment_start = end;
+         p_stim->segment++;
+         p_stim->segment_edges = 0;
+         continue;
+      }
+
+      rpm = qd_stim_rpm(p_segment, p_stim->now - p_stim->segment_start);
+      if (p_segment->type == QD_STIM_STEP)
+      {
+         /* one count at the segment end, from mid-count as at the start */
+         p_stim->now = end;
+         p_stim->phase = QD_STIM_COUNT/2;
+         p_stim->position += (rpm < 0) ? -1 : 1;
+      }
+      else
+      {
+         /* advance to the next count or the next integration step */
+         rate = (unsigned long long)(rpm < 0 ? -rpm : rpm) * p_config->pc_per_rev;
+         step = end - p_stim->now;
+         if ((p_segment->type != QD_STIM_CONSTANT) &&
+             (step > duration/QD_STIM_RAMP_STEPS) && (duration >= QD_STIM_RAMP_STEPS))
+            step = duration/QD_STIM_RAMP_STEPS;
+         if (rate == 0)
+         {
+            p_stim->now += step;
+            continue;
+         }
+         if (rpm > 0)
+            t_edge = (QD_STIM_COUNT - p_stim->phase + rate - 1) / rate;
+         else
+            t_edge = (p_stim->phase + 1 + rate - 1) / rate;
+         if (t_edge > step)
+         {
+            p_stim->now += step;
+            p_stim->phase += (rpm > 0) ? (long long)(rate*step) : -(long long)(rate*step);
+            continue;
+         }
+         p_stim->now += t_edge;
+         if (rpm > 0)
+         {
+            p_stim->phase += (long long)(rate*t_edge) - QD_STIM_COUNT;
+            p_stim->position++;
+         }
+         else
+         {
+            p_stim->phase -= (long long)(rate*t_edge);
+            p_stim->phase += QD_STIM_COUNT;
+            p_stim->position--;
+         }
+      }
+      p_stim->edges++;
+      p_stim->segment_edges++;
+
+      /* transition time */
+      time_us = (p_stim->now + 128) >> 8;
+      if (p_segment->jitter_us)
+      {
+         p_stim->random ^= p_stim->random << 13;
+         p_stim->random ^= p_stim->random >> 17;
+         p_stim->random ^= p_stim->random << 5;
+         jitter = (int32_t)(p_stim->random % (2*p_segment->jitter_us + 1u)) - p_segment->jitter_us;
+         if ((jitter < 0) && ((unsigned long long)-jitter > time_us))
+            time_us = 0;
+         else
+            time_us += jitter;
+      }
+      if (time_us < p_stim->emitted_us)
+         time_us = p_stim->emitted_us;
+
+      /* a dropped edge holds its pin until the next edge of that phase */
+      levels = qd_stim_levels(p_config, p_stim->position);
+      if (p_segment->drop_every && (p_stim->segment_edges % p_segment->drop_every == 0))
+      {
+         p_stim->stuck |= (levels ^ p_stim->pins) & (QD_STIM_PIN_A | QD_STIM_PIN_B);
+         p_stim->dropped++;
+      }
+      p_stim->stuck &= levels ^ p_stim->pins;
+      levels = (levels & ~p_stim->stuck) | (p_stim->pins & p_stim->stuck);
+      qd_stim_queue(p_stim, p_config->chan_a, QD_STIM_PIN_A, levels,
+                    (uint32_t)(time_us - p_stim->emitted_us));
+      qd_stim_queue(p_stim, p_config->chan_b, QD_STIM_PIN_B, levels,
+                    p_stim->queue_count ? 0 : (uint32_t)(time_us - p_stim->emitted_us));
+      qd_stim_queue(p_stim, p_config->chan_index, QD_STIM_PIN_INDEX, levels,
+                    p_stim->queue_count ? 0 : (uint32_t)(time_us - p_stim->emitted_us));
+      qd_stim_queue(p_stim, p_config->chan_home, QD_STIM_PIN_HOME, levels,
+                    p_stim->queue_count ? 0 : (uint32_t)(time_us - p_stim->emitted_us));
+      if (p_stim->queue_count)
+         p_stim->emitted_us = time_us;
+   }
+
+   *p_edge = p_stim->queue[p_stim->queue_next++];
+   return(1);
+}
+
+/*******************************************************************************
+*FUNCTION     : qd_stim_run
+*PURPOSE      : To drive the input pins with the profile transitions.
+*INPUTS NOTES : This function has 2 parameters:
+*  p_stim          - generator
+*  max_transitions - maximum number of transitions to drive, 0 = no limit
+*RETURNS NOTES: Number of transitions driven. Less than max_transitions
+*               at the end of the profile; the time after the last
+*               transition up to the profile end is waited as well.
+*******************************************************************************/
+uint32_t qd_stim_run(struct qd_stim_t *p_stim,
+                     uint32_t max_transitions)
+{
+   struct qd_stim_edge_t edge;
+   unsigned long long end_us;
+   uint32_t count = 0;
+
+   while ((max_transitions == 0) || (count < max_transitions))
+   {
+      if (!qd_stim_next(p_stim, &edge))
+      {
+         end_us = (p_stim->segment_start + 128) >> 8;
+         if (end_us > p_stim->emitted_us)
+         {
+            wait_time((uint32_t)(end_us - p_stim->emitted_us));
+            p_stim->emitted_us = end_us;
+         }
+         break;
+      }
+      if (edge.delay_us)
+         wait_time(edge.delay_us);
+      write_chan_input_pin(edge.chan, edge.value);
+      if (p_stim->p_config->tcrclk && (edge.chan == p_stim->p_config->chan_a))
+         write_tcrclk_pin(edge.value);
+      count++;
+   }
+   return(count);
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+* FILE NAME: qd_stimulus.h
+*
+* DESCRIPTION:
+* Quadrature encoder stimulus generator for the QD test application. The
+* A/B (and optional index/home) waveforms are synthesized from a compact
+* profile - a list of speed segments - and streamed one pin transition at
+* a time, so profiles of any length run in constant memory. The transitions
+* are applied through the simulator script interface (wait_time,
+* write_chan_input_pin, write_tcrclk_pin), which the Linux host model implements as well.
+*******************************************************************************/
+#ifndef _QD_STIMULUS_H_
+#define _QD_STIMULUS_H_
+
+#include "typedefs.h"
+
+/*******************************************************************************
+*                            Definitions
+*******************************************************************************/
+/* segment types */
+#define QD_STIM_CONSTANT     0  /* rpm_start for the whole segment */
+#define QD_STIM_RAMP         1  /* linear rpm_start -> rpm_end */
+#define QD_STIM_SCURVE       2  /* smooth (3u^2-2u^3) rpm_start -> rpm_end */
+#define QD_STIM_REVERSAL     3  /* linear rpm_start -> -rpm_start through standstill */
+#define QD_STIM_STEP         4  /* one count at the segment end, backwards if
+                                   rpm_start < 0 - exact edge intervals */
+
+/* driven pin levels */
+#define QD_STIM_PIN_A        0x01
+#define QD_STIM_PIN_B        0x02
+#define QD_STIM_PIN_INDEX    0x04
+#define QD_STIM_PIN_HOME     0x08
+
+/* unused index/home channel */
+#define QD_STIM_NO_CHANNEL   0xff
+
+/* variable speed segments are integrated in at least this many steps */
+#define QD_STIM_RAMP_STEPS   64
+
+/*******************************************************************************
+*                            Type Definitions
+*******************************************************************************/
+/* profile segment - a negative rpm turns the encoder backwards, rpm 0 is
+   standstill */
+struct qd_stim_segment_t
+{
+   uint8_t  type;          /* QD_STIM_CONSTANT .. QD_STIM_STEP */
+   int32_t  rpm_start;
+   int32_t  rpm_end;       /* QD_STIM_RAMP and QD_STIM_SCURVE only */
+   uint32_t duration_us;
+   uint16_t jitter_us;     /* edge time jitter, +/- jitter_us, 0 = none */
+   uint16_t drop_every;    /* every n-th A/B edge is not driven, 0 = none */
+};
+
+/* encoder configuration */
+struct qd_stim_config_t
+{
+   uint8_t  chan_a;
+   uint8_t  chan_b;
+   uint8_t  chan_index;    /* pulses at position multiples of pc_per_rev */
+   uint8_t  chan_home;     /* pulses at home_position */
+   uint32_t pc_per_rev;    /* quadrature counts per revolution */
+   int32_t  position;      /* start position, A/B pins must be at its levels */
+   int32_t  home_position;
+   uint32_t loops;         /* number of profile passes, 0 = 1 */
+   uint32_t seed;          /* jitter random seed, must not be 0 */
+   uint8_t  tcrclk;        /* phase A drives the TCRCLK input as well */
+};
+
+/* one pin transition */
+struct qd_stim_edge_t
+{
+   uint32_t delay_us;      /* time from the previous transition */
+   uint8_t  chan;
+   uint8_t  value;
+};
+
+/* generator state */
+struct qd_stim_t
+{
+   const struct qd_stim_config_t  *p_config;
+   const struct qd_stim_segment_t *p_segments;
+   uint16_t segment_count;
+   uint16_t segment;        /* current segment */
+   uint32_t loop;           /* current profile pass */
+   uint32_t segment_edges;  /* A/B edges in the current segment */
+   unsigned long long segment_start;  /* segment start, 1/256 us */
+   unsigned long long now;            /* time of the last A/B edge, 1/256 us */
+   unsigned long long emitted_us;     /* time of the last transition returned */
+   long long phase;         /* position within the current count */
+   int32_t  position;       /* A/B count */
+   uint32_t edges;          /* A/B edges generated */
+   uint32_t dropped;        /* A/B edges not driven */
+   uint32_t random;
+   uint8_t  pins;           /* driven levels, QD_STIM_PIN_* */
+   uint8_t  stuck;          /* A/B pins held by a dropped edge */
+   uint8_t  queue_count;
+   uint8_t  queue_next;
+   struct qd_stim_edge_t queue[3];
+};
+
+/*******************************************************************************
+*                            Function Prototypes
+*******************************************************************************/
+/* Profile set-up and streaming */
+void     qd_stim_init(struct qd_stim_t *p_stim,
+                      const struct qd_stim_config_t *p_config,
+                      const struct qd_stim_segment_t *p_segments,
+                      uint16_t segment_count);
+uint8_t  qd_stim_next(struct qd_stim_t *p_stim,
+                      struct qd_stim_edge_t *p_edge);
+uint32_t qd_stim_run(struct qd_stim_t *p_stim,
+                     uint32_t max_transitions);
+
+#endif